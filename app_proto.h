@@ -54,15 +54,27 @@ void closerend(void);
 void loadskull(void);
 void freeskull(void);
 void simpledeath(void);
-int testlinebuf(uint32 *linebuf, int32 lx, int32 rx);
 void fadecel(struct CCB *ccb, frac16 value);
 void createbackwall(void);
+void shadebackwall(void);
 void FasterMapCel(struct CCB *ccb, struct Point *p);
+void rendmapcel(struct CCB *ccb, struct Point *p);
+/* linebuf.c */
+int initlinebuf(struct LineBuf *lb, int32 width);
+void freelinebuf(struct LineBuf *lb);
+void resetlinebuf(struct LineBuf *lb);
+int islinefull(struct LineBuf *lb);
+int testlinebuf(struct LineBuf *lb, int32 lx, int32 rx);
+int testmarklinebuf(struct LineBuf *lb, int32 lx, int32 rx);
 /* shoot.c */
 void shoot(void);
 void probe(void);
 void sequencegun(frac16 dist);
+void drawhud(void);
 void loadgun(void);
+/* platform layer, called from shoot.c (threedo_compat.h on the 3DO) */
+Item (platform_hud_begin)(Item bitmap_item, uint32 key);
+void (platform_hud_composite)(Item bitmap_item);
 /* objects.c */
 void freeobjects(void);
 struct Object *createStdObject(struct ObDef *od, int type, int size, int flags, struct Object *dupsrc);
@@ -184,6 +196,8 @@ void stopstream(void);
 int playcpak(char *filename);
 /* map.c */
 int drawmap(void);
+void markmapcell(struct MapEntry *me);
+void resetmap(void);
 void loadmap(void);
 void freemap(void);
 /* option.c */
@@ -193,6 +207,13 @@ Err DoHighScoreScr(int32 newScore);
 Err DoLoadGameScr(struct SaveGameRec *theGame);
 Err DoSaveGameScr(struct SaveGameRec *theGame);
 Err ClearSaveStuff(int32 clearScores, int32 clearSaves);
+/* textstuff.c */
+void buildfontatlas(struct FontStruct *fs);
+void freefontatlas(void *font);
+void printtext(struct FontStruct *fs);
+struct FontDef *LoadFont(char *filename);
+void MyMoveTo(struct FontDef *fontdef, int32 x, int32 y);
+void MyDrawText(struct FontDef *fontdef, char *str);
 /* elkabong.c */
 int32 performElKabong(void *buf);
 int32 initElKabong(char *filename);
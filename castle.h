@@ -102,6 +102,21 @@ typedef struct VisOb {
 #define	VOTYP_OBJECT	1
 
 
+/***************************************************************************
+ * Span coverage buffer.  One bit per screen column; a set bit means the
+ * column is still open (nothing opaque has been drawn over it yet).
+ * Sized at run time from the render width, so it follows the resolution.
+ */
+typedef struct LineBuf {
+	uint64		*lb_Bits;
+	int32		lb_Width;	/*  Columns covered.		*/
+	int32		lb_NWords;
+	int32		lb_NOpen;	/*  Columns still open.		*/
+} LineBuf;
+
+#define	LB_WORDBITS	64
+
+
 /***************************************************************************
  * Joypad data - using platform definition from platform_input.h
  */
@@ -124,13 +139,30 @@ typedef struct VisOb {
 #define	MAXNCELS	(WORLDSIZ * WORLDSIZ)
 #define	NGRIDPOINTS	(GRIDSIZ * GRIDSIZ)
 
+/*
+ * Draw distance, in grid cells.  The renderer draws out to drawdist
+ * (16.16), fading walls and the backwall to black as they approach it,
+ * and extraction walks gridcutoff cells, drawdist rounded up.  The
+ * distance can be moved at run time between these bounds; the nearest
+ * must stay beyond the start of the fade.  A cel adds up to
+ * VISOBS_PER_CELL entries to visobs[] (two faces and its objects), so a
+ * 24-cell walk through open floor could want well over MAXVISOBS; the
+ * walks stop short, dropping the farthest cels, when visobs[] fills.
+ */
 #define	GRIDCUTOFF	16  /* Reduced for performance */
+#define	MINGRIDCUTOFF	10
+#define	MAXGRIDCUTOFF	24
 #define	MAXWALLVERTS	2048
 
 #define	NOBVERTS	1024
 
 #define	MAXVISOBS	512
+#define	VISOBS_PER_CELL	3
 
+/*
+ * Projection constants at 3DO resolution.  The renderer uses cx, cy and
+ * magic, which are these multiplied by rendscale.
+ */
 #define	CX		160
 #define	CY		120
 
@@ -188,6 +220,11 @@ extern frac16 damagefade;
 extern frac16 scale;
 extern int32 throttleshift;
 extern int32 cy;
+extern int32 cx, magic;
+extern int32 rendscale;
+extern frac16 drawdist;
+extern int32 gridcutoff;
+extern LineBuf linebuf;
 
 extern int8 skiptitle;
 extern int8 laytest;
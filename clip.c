@@ -13,7 +13,7 @@
 #include "app_proto.h"
 
 
-extern int32	cy;
+extern int32	cx, cy, magic;
 
 static frac16	clipconstant;
 
@@ -71,12 +71,12 @@ struct Point	*crnr;
 		 * Project coordinates.
 		 */
 		crnr[0].pt_X =
-		 ConvertF16_32 (MulSF16 (crnr[0].pt_X, clipconstant)) + CX;
+		 ConvertF16_32 (MulSF16 (crnr[0].pt_X, clipconstant)) + cx;
 		crnr[0].pt_Y =
 		 ConvertF16_32 (MulSF16 (crnr[0].pt_Y, clipconstant)) + cy;
 
 		crnr[1].pt_X =
-		 ConvertF16_32 (MulSF16 (crnr[1].pt_X, clipconstant)) + CX;
+		 ConvertF16_32 (MulSF16 (crnr[1].pt_X, clipconstant)) + cx;
 		crnr[1].pt_Y =
 		 ConvertF16_32 (MulSF16 (crnr[1].pt_Y, clipconstant)) + cy;
 
@@ -112,12 +112,12 @@ struct Point	*crnr;
 		 * Project coordinates.
 		 */
 		crnr[2].pt_X =
-		 ConvertF16_32 (MulSF16 (crnr[2].pt_X, clipconstant)) + CX;
+		 ConvertF16_32 (MulSF16 (crnr[2].pt_X, clipconstant)) + cx;
 		crnr[2].pt_Y =
 		 ConvertF16_32 (MulSF16 (crnr[2].pt_Y, clipconstant)) + cy;
 
 		crnr[3].pt_X =
-		 ConvertF16_32 (MulSF16 (crnr[3].pt_X, clipconstant)) + CX;
+		 ConvertF16_32 (MulSF16 (crnr[3].pt_X, clipconstant)) + cx;
 		crnr[3].pt_Y =
 		 ConvertF16_32 (MulSF16 (crnr[3].pt_Y, clipconstant)) + cy;
 
@@ -297,5 +297,5 @@ int32			factor;
 void
 initclip ()
 {
-	clipconstant = DivSF16 (Convert32_F16 (MAGIC), ZCLIP);
+	clipconstant = DivSF16 (Convert32_F16 (magic), ZCLIP);
 }
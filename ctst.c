@@ -177,6 +177,10 @@ frac16		scale = DEFAULT_SCALE;
 int32		throttleshift = 4;
 
 int32		cy = CY;
+int32		cx = CX, magic = MAGIC;
+int32		rendscale = 1;	/*  Internal resolution multiplier.  */
+frac16		drawdist = GRIDCUTOFF * ONE_F16;	/*  Draw distance.  */
+int32		gridcutoff = GRIDCUTOFF;
 
 int8		skiptitle;
 int8		laytest;
@@ -1018,11 +1022,11 @@ struct ExtDat	*ed;
 	z = ConvertF16_32 (ed->z);
 	prevl = prevr = x;
 
-	stopz = z + GRIDCUTOFF;
+	stopz = z + gridcutoff;
 	if (stopz > WORLDSIZ)	stopz = WORLDSIZ;
-	stopxl = x - GRIDCUTOFF;
+	stopxl = x - gridcutoff;
 	if (stopxl < 0)		stopxl = 0;
-	stopxr = x + GRIDCUTOFF;
+	stopxr = x + gridcutoff;
 	if (stopxr >= WORLDSIZ)	stopxr = WORLDSIZ - 1;
 
 	/*
@@ -1222,11 +1226,11 @@ struct ExtDat	*ed;
 	z = ConvertF16_32 (ed->z);
 	prevl = prevr = z;
 
-	stopx = x - GRIDCUTOFF;
+	stopx = x - gridcutoff;
 	if (stopx < 0)		stopx = 0;
-	stopzl = z - GRIDCUTOFF;
+	stopzl = z - gridcutoff;
 	if (stopzl < 0)		stopzl = 0;
-	stopzr = z + GRIDCUTOFF;
+	stopzr = z + gridcutoff;
 	if (stopzr >= WORLDSIZ)	stopzr = WORLDSIZ - 1;
 
 	/*
@@ -1434,11 +1438,11 @@ struct ExtDat	*ed;
 	z = ConvertF16_32 (ed->z);
 	prevl = prevr = x;
 
-	stopz = z - GRIDCUTOFF;
+	stopz = z - gridcutoff;
 	if (stopz < 0)		stopz = 0;
-	stopxl = x + GRIDCUTOFF;
+	stopxl = x + gridcutoff;
 	if (stopxl >= WORLDSIZ)	stopxl = WORLDSIZ - 1;
-	stopxr = x - GRIDCUTOFF;
+	stopxr = x - gridcutoff;
 	if (stopxr < 0)		stopxr = 0;
 
 	/*
@@ -1641,11 +1645,11 @@ struct ExtDat	*ed;
 	z = ConvertF16_32 (ed->z);
 	prevl = prevr = z;
 
-	stopx = x + GRIDCUTOFF;
+	stopx = x + gridcutoff;
 	if (stopx > WORLDSIZ)	stopx = WORLDSIZ;
-	stopzl = z + GRIDCUTOFF;
+	stopzl = z + gridcutoff;
 	if (stopzl >= WORLDSIZ)	stopzl = WORLDSIZ - 1;
-	stopzr = z - GRIDCUTOFF;
+	stopzr = z - gridcutoff;
 	if (stopzr < 0)		stopzr = 0;
 
 	/*
@@ -2190,10 +2194,11 @@ unloadwalls ()
 void
 openlevelstuff ()
 {
-	cy = CY;
+	cy = CY * rendscale;
 
 	/*  Load level geometry.  */
 	loadlevelmap (levelname);
+	resetmap ();
 
 	/*
 	 * Load wall art.
@@ -2308,6 +2313,8 @@ openstuff ()
 	 */
 	wide = rpvis->rp_Bitmap->bm_ClipWidth;
 	high = rpvis->rp_Bitmap->bm_ClipHeight;
+	cx = CX * rendscale;
+	magic = MAGIC * rendscale;
 	w = rpvis->rp_Bitmap->bm_Width;
 	h = rpvis->rp_Bitmap->bm_Height;
 	screenpages = (w * h * sizeof (int16) +
@@ -105,6 +105,11 @@ frac16 damagefade = 0;
 frac16 scale = 0x24000; // DEFAULT_SCALE
 int32 throttleshift = 4;
 int32 cy = CY;
+int32 cx = CX, magic = MAGIC;
+int32 rendscale = 1; // Internal resolution multiplier
+frac16 drawdist = GRIDCUTOFF * ONE_F16; // Draw distance in grid cells
+int32 gridcutoff = GRIDCUTOFF;
+int32 wide = 320, high = 240;
 
 int8 skiptitle = FALSE;
 int8 laytest = FALSE;
@@ -151,6 +156,28 @@ void kprintf(const char* format, ...)
     va_end(args);
 }
 
+// Switch the world projection to a new internal render resolution.  The
+// platform reallocates the screens; the next frame redraws them in full.
+void setrendscale(int32 n)
+{
+    rendscale = platform_set_render_scale(n);
+    cx = CX * rendscale;
+    cy = CY * rendscale;
+    magic = MAGIC * rendscale;
+}
+
+// Move the draw distance.  Extraction walks whole cells, so it reaches the
+// cell the distance falls in; the fade hides everything past the distance
+// itself, so small steps never pop.
+void setdrawdist(frac16 dist)
+{
+    if (dist < MINGRIDCUTOFF * ONE_F16) dist = MINGRIDCUTOFF * ONE_F16;
+    if (dist > MAXGRIDCUTOFF * ONE_F16) dist = MAXGRIDCUTOFF * ONE_F16;
+
+    drawdist = dist;
+    gridcutoff = (dist + ONE_F16 - 1) >> 16;
+}
+
 // Modified openstuff() function - platform initialization
 void openstuff(void)
 {
@@ -171,6 +198,12 @@ void openstuff(void)
     if (!rpvis || !rprend) {
         die("Failed to get platform rastports.\n");
     }
+
+    // The world is projected at the internal resolution; everything else
+    // keeps working in 3DO screen coordinates
+    setrendscale(platform_get_render_scale());
+    wide = rpvis->rp_Bitmap->bm_Width / rendscale;
+    high = rpvis->rp_Bitmap->bm_Height / rendscale;
     
     printf("Using platform rastports: rpvis->rp_BitmapItem=%d, rprend->rp_BitmapItem=%d\n", 
            rpvis->rp_BitmapItem, rprend->rp_BitmapItem);
@@ -337,7 +370,9 @@ int dogame(void)
         current_time = platform_get_ticks();
         
         if (current_time - last_frame_time >= frame_duration) {
+            platform_perf_start("DisplayScreen");
             DisplayScreen(rpvis->rp_ScreenItem, 0);
+            platform_perf_end("DisplayScreen");
             last_frame_time = current_time;
         }
 
@@ -376,6 +411,19 @@ int dogame(void)
         // Extract and render
         extractcels(campos.X, campos.Z, playerdir);
 
+        // Hold the frame budget by trading internal resolution
+        int32 n = platform_govern_resolution(platform_perf_last("extractcels") +
+                                             platform_perf_last("rendercels") +
+                                             platform_perf_last("DisplayScreen"));
+        if (n != rendscale) {
+            setrendscale(n);
+        }
+
+        // ...and draw distance, against what the world alone costs
+        setdrawdist(platform_govern_draw_distance(platform_perf_last("extractcels") +
+                                                  platform_perf_last("rendercels"),
+                                                  drawdist));
+
         // Limit frame rate
         WaitVBL(vblIO, 1);
     }
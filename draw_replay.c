@@ -0,0 +1,487 @@
+/*
+ * Draw-list replay
+ * Draws the frames of a draw-list capture (see capture_file in the config)
+ * through the software cel engine again and again, and reports the time
+ * each frame took, so a change to the rasterizer can be measured on real
+ * game frames rather than a synthetic scene.
+ *
+ *   DrawReplay [-save dir | -compare dir] [-tolerance n] capture [repeats] [bands]
+ *
+ * With bands the frames are drawn as that many bands one after another,
+ * the way the band workers split them.  Each frame's checksum is taken
+ * over every target once it is drawn; targets start out cleared, as
+ * clears and other non-cel drawing aren't in the capture.
+ *
+ * -save writes every target a frame draws on to dir as a BMP, and the
+ * median time of each frame to dir/times.txt, to serve as references.
+ * Each target is also saved faded (raster_fade_rgba32()) and then scaled
+ * up (upscale_rows()), as the display shows it, so the presentation
+ * loops are held to the references too.  -compare checks the frames
+ * against references saved earlier (from a capture of the same frames),
+ * failing any image with a color channel more than the tolerance (default
+ * 0) off, and sets the times beside the saved ones.  A rasterizer change
+ * can then be shown to leave the game's frames as they were, or as near
+ * as it means to, and how much faster it draws them.  The exit status is
+ * nonzero if any image fails, so the comparison can run as a test.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "platform/platform_capture.h"
+#include "platform/platform_upscale.h"
+
+#define MAX_BANDS 64
+#define BMP_HEADER 54
+
+// The fade levels and upscaling the references are shown through.  The
+// scale isn't a whole multiple, so every texel edge is blended.
+#define GOLDEN_FADE_R 224
+#define GOLDEN_FADE_G 160
+#define GOLDEN_FADE_B 96
+#define GOLDEN_UPSCALE_NUM 5
+#define GOLDEN_UPSCALE_DEN 3
+
+// What to do with each frame's pictures
+typedef struct Golden {
+    const char* dir;
+    int save;
+    int tolerance;
+    int images;             // Images saved or compared
+    int failed;             // Compared images that didn't match
+} Golden;
+
+static double now_ms(void)
+{
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static size_t target_bytes(const RasterTarget* rt)
+{
+    return (size_t)rt->stride * rt->height * (rt->rgb555 ? sizeof(uint16) : sizeof(uint32));
+}
+
+static uint32 checksum(const Capture* cap)
+{
+    uint32 sum = 0;
+    int32 i;
+
+    for (i = 0; i < cap->ntargets; i++) {
+        const uint32* p = (const uint32*)cap->targets[i].pixels;
+        size_t n = target_bytes(&cap->targets[i]) / sizeof(uint32);
+
+        while (n--) sum = sum * 31 + *p++;
+    }
+    return sum;
+}
+
+static void clear_targets(Capture* cap)
+{
+    int32 i;
+
+    for (i = 0; i < cap->ntargets; i++) {
+        memset(cap->targets[i].pixels, 0, target_bytes(&cap->targets[i]));
+    }
+}
+
+static void draw_frame(Capture* cap, int32 frame, int bands)
+{
+    int32 first = frame ? cap->frame_ends[frame - 1] : 0;
+    int32 i, b;
+
+    for (i = first; i < cap->frame_ends[frame]; i++) {
+        RasterTarget* rt = &cap->targets[cap->draws[i].target];
+        int32 height = rt->height;
+
+        for (b = 0; b < bands; b++) {
+            rt->clip_top = height * b / bands;
+            rt->clip_bottom = height * (b + 1) / bands;
+            raster_draw_list(rt, &cap->draws[i].list);
+        }
+        rt->clip_top = 0;
+        rt->clip_bottom = height;
+    }
+}
+
+static void put16(ubyte* p, uint32 v)
+{
+    p[0] = (ubyte)v;
+    p[1] = (ubyte)(v >> 8);
+}
+
+static void put32(ubyte* p, uint32 v)
+{
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+static uint32 get32(const ubyte* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+// An RGBA32 image as a bottom-up 24-bit BMP image, header included
+static ubyte* image_bmp(const uint32* pixels, int32 width, int32 height, size_t* size)
+{
+    size_t row = ((size_t)width * 3 + 3) & ~(size_t)3;
+    ubyte* bmp;
+    int32 x, y;
+
+    *size = BMP_HEADER + row * height;
+    if (!(bmp = (ubyte*)calloc(1, *size))) return NULL;
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put32(bmp + 2, (uint32)*size);
+    put32(bmp + 10, BMP_HEADER);
+    put32(bmp + 14, 40);
+    put32(bmp + 18, width);
+    put32(bmp + 22, height);
+    put16(bmp + 26, 1);
+    put16(bmp + 28, 24);
+    put32(bmp + 34, (uint32)(row * height));
+
+    for (y = 0; y < height; y++) {
+        ubyte* out = bmp + BMP_HEADER + row * (height - 1 - y);
+
+        for (x = 0; x < width; x++) {
+            uint32 c = pixels[y * width + x];
+
+            *out++ = (ubyte)(c >> 16);
+            *out++ = (ubyte)(c >> 8);
+            *out++ = (ubyte)c;
+        }
+    }
+    return bmp;
+}
+
+static ubyte* read_file(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+    ubyte* data = NULL;
+    long n;
+
+    if (!file) return NULL;
+    if (fseek(file, 0, SEEK_END) == 0 && (n = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0 &&
+        (data = (ubyte*)malloc(n)) != NULL && fread(data, 1, n, file) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    if (data) *size = (size_t)n;
+    fclose(file);
+    return data;
+}
+
+// Save or compare a frame's picture of target t, or of what's shown of
+// it when kind is "_fade" or "_up"
+static void golden_image(Golden* golden, int32 frame, int32 t, const char* kind,
+                         const uint32* pixels, int32 width, int32 height)
+{
+    char path[1024];
+    ubyte* bmp;
+    ubyte* ref;
+    size_t size, ref_size, i, over = 0;
+    int worst = 0;
+
+    snprintf(path, sizeof(path), "%s/frame%04d_%d%s.bmp", golden->dir, frame, t, kind);
+    if (!(bmp = image_bmp(pixels, width, height, &size))) {
+        printf("Out of memory for %s\n", path);
+        golden->failed++;
+        return;
+    }
+    golden->images++;
+
+    if (golden->save) {
+        FILE* file = fopen(path, "wb");
+
+        if (!file || fwrite(bmp, 1, size, file) != size) {
+            printf("Can't write %s\n", path);
+            golden->failed++;
+        }
+        if (file) fclose(file);
+        free(bmp);
+        return;
+    }
+
+    if (!(ref = read_file(path, &ref_size))) {
+        printf("frame %d: no reference %s\n", frame, path);
+        golden->failed++;
+        free(bmp);
+        return;
+    }
+    if (ref_size != size || memcmp(ref, bmp, BMP_HEADER) != 0 ||
+        get32(ref + 10) != BMP_HEADER) {
+        printf("frame %d: %s is not a %dx%d reference\n", frame, path, width, height);
+        golden->failed++;
+    } else {
+        // Count the pixels with any channel out by more than the tolerance
+        size_t row = (size - BMP_HEADER) / height;
+
+        for (i = 0; i < (size_t)height * row; i += row) {
+            const ubyte* a = bmp + BMP_HEADER + i;
+            const ubyte* b = ref + BMP_HEADER + i;
+            int32 x;
+
+            for (x = 0; x < width * 3; x += 3) {
+                int d, c, pixel = 0;
+
+                for (c = 0; c < 3; c++) {
+                    d = abs(a[x + c] - b[x + c]);
+                    if (d > pixel) pixel = d;
+                }
+                if (pixel > golden->tolerance) over++;
+                if (pixel > worst) worst = pixel;
+            }
+        }
+        if (over) {
+            printf("frame %d: target %d differs from %s in %lu pixel(s), by up to %d\n", frame,
+                   t, path, (unsigned long)over, worst);
+            golden->failed++;
+        }
+    }
+    free(ref);
+    free(bmp);
+}
+
+// Target t's picture, then faded and scaled up the way the display
+// shows a frame
+static void golden_target(Golden* golden, const Capture* cap, int32 frame, int32 t)
+{
+    const RasterTarget* rt = &cap->targets[t];
+    size_t n = (size_t)rt->width * rt->height;
+    Upscaler up;
+    uint32* image = (uint32*)malloc(n * sizeof(uint32));
+    uint32* faded = (uint32*)malloc(n * sizeof(uint32));
+    uint32* scaled = NULL;
+    int32 y;
+
+    memset(&up, 0, sizeof(up));
+    if (image && faded &&
+        upscaler_setup(&up, UPSCALE_SHARP_BILINEAR, rt->width, rt->height,
+                       rt->width * GOLDEN_UPSCALE_NUM / GOLDEN_UPSCALE_DEN,
+                       rt->height * GOLDEN_UPSCALE_NUM / GOLDEN_UPSCALE_DEN) == 0) {
+        scaled = (uint32*)malloc((size_t)up.width * up.height * sizeof(uint32));
+    }
+    if (!scaled) {
+        printf("frame %d: out of memory for target %d's pictures\n", frame, t);
+        golden->failed++;
+        goto done;
+    }
+
+    for (y = 0; y < rt->height; y++) {
+        uint32* row = image + (size_t)y * rt->width;
+
+        if (rt->rgb555)
+            raster_rgb555_to_rgba32(row, (const uint16*)rt->pixels + (size_t)y * rt->stride,
+                                    rt->width);
+        else
+            memcpy(row, (const uint32*)rt->pixels + (size_t)y * rt->stride,
+                   rt->width * sizeof(uint32));
+    }
+    raster_fade_rgba32(faded, image, n, GOLDEN_FADE_R, GOLDEN_FADE_G, GOLDEN_FADE_B);
+    upscale_rows(&up, scaled, up.width, faded, rt->width, 0, up.height);
+
+    golden_image(golden, frame, t, "", image, rt->width, rt->height);
+    golden_image(golden, frame, t, "_fade", faded, rt->width, rt->height);
+    golden_image(golden, frame, t, "_up", scaled, up.width, up.height);
+
+done:
+    upscaler_free(&up);
+    free(image);
+    free(faded);
+    free(scaled);
+}
+
+// The pictures of every target a frame drew on
+static void golden_frame(Golden* golden, const Capture* cap, int32 frame)
+{
+    int32 first = frame ? cap->frame_ends[frame - 1] : 0;
+    int32 t, i;
+
+    for (t = 0; t < cap->ntargets; t++) {
+        for (i = first; i < cap->frame_ends[frame]; i++) {
+            if (cap->draws[i].target == t) {
+                golden_target(golden, cap, frame, t);
+                break;
+            }
+        }
+    }
+}
+
+// Write the frames' median times, or set them beside the ones written
+static void golden_times(Golden* golden, const double* medians, int32 nframes)
+{
+    char path[1024];
+    double before = 0.0, after = 0.0, ms;
+    FILE* file;
+    int32 f, n;
+
+    snprintf(path, sizeof(path), "%s/times.txt", golden->dir);
+    if (golden->save) {
+        if (!(file = fopen(path, "w"))) {
+            printf("Can't write %s\n", path);
+            golden->failed++;
+            return;
+        }
+        for (f = 0; f < nframes; f++) fprintf(file, "%d %.4f\n", f, medians[f]);
+        fclose(file);
+        printf("Saved %d reference image(s) and times to %s\n", golden->images, golden->dir);
+        return;
+    }
+
+    if ((file = fopen(path, "r")) != NULL) {
+        while (fscanf(file, "%d %lf", &f, &ms) == 2) {
+            if (f >= 0 && f < nframes) {
+                before += ms;
+                after += medians[f];
+            }
+        }
+        fclose(file);
+        if (before > 0.0) {
+            printf("Reference frames took %.3f ms, now %.3f ms (%+.1f%%)\n", before, after,
+                   (after - before) * 100.0 / before);
+        }
+    }
+    n = golden->images - golden->failed;
+    printf("%d of %d image(s) match the references within %d\n", n < 0 ? 0 : n,
+           golden->images, golden->tolerance);
+}
+
+static int compare_ms(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char* argv[])
+{
+    Capture cap;
+    Golden golden;
+    const char* path;
+    int repeats = 20, bands = 1;
+    double* ms = NULL;
+    double* sorted = NULL;
+    double* medians = NULL;
+    uint32* sums = NULL;
+    double total, t0;
+    int32 f, i, cels;
+    int arg, r, mismatches = 0, status = 1;
+
+    memset(&golden, 0, sizeof(golden));
+    for (arg = 1; arg < argc && argv[arg][0] == '-'; arg += 2) {
+        if (arg + 1 >= argc) break;
+        if (strcmp(argv[arg], "-save") == 0) {
+            golden.dir = argv[arg + 1];
+            golden.save = 1;
+        } else if (strcmp(argv[arg], "-compare") == 0) {
+            golden.dir = argv[arg + 1];
+            golden.save = 0;
+        } else if (strcmp(argv[arg], "-tolerance") == 0) {
+            golden.tolerance = atoi(argv[arg + 1]);
+        } else {
+            break;
+        }
+    }
+    if (arg >= argc || argv[arg][0] == '-') {
+        printf("Usage: DrawReplay [-save dir | -compare dir] [-tolerance n] capture [repeats] "
+               "[bands]\n");
+        return 1;
+    }
+    path = argv[arg];
+    if (arg + 1 < argc) repeats = atoi(argv[arg + 1]);
+    if (arg + 2 < argc) bands = atoi(argv[arg + 2]);
+    if (repeats < 1) repeats = 1;
+    if (bands < 1) bands = 1;
+    if (bands > MAX_BANDS) bands = MAX_BANDS;
+
+    if (SDL_Init(SDL_INIT_TIMER) < 0) {
+        printf("SDL initialization failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    if (capture_load(&cap, path) < 0) {
+        SDL_Quit();
+        return 1;
+    }
+    if (!cap.nframes) {
+        printf("%s holds no frames\n", path);
+        goto done;
+    }
+
+    for (i = 0; i < cap.ntargets; i++) {
+        if (!(cap.targets[i].pixels = calloc(1, target_bytes(&cap.targets[i])))) {
+            printf("Out of memory for targets\n");
+            goto done;
+        }
+    }
+    ms = (double*)malloc((size_t)cap.nframes * repeats * sizeof(double));
+    sorted = (double*)malloc((size_t)cap.nframes * repeats * sizeof(double));
+    medians = (double*)malloc((size_t)cap.nframes * sizeof(double));
+    sums = (uint32*)malloc((size_t)cap.nframes * sizeof(uint32));
+    if (!ms || !sorted || !medians || !sums) {
+        printf("Out of memory for timings\n");
+        goto done;
+    }
+
+    for (i = 0, cels = 0; i < cap.ndraws; i++) cels += cap.draws[i].list.count;
+    printf("%s: %d frames, %d draw lists, %d cels, %d textures, %d target(s)\n", path,
+           cap.nframes, cap.ndraws, cels, cap.ntextures, cap.ntargets);
+    printf("%d repeats, %d band(s)\n\n", repeats, bands);
+
+    // A pass to warm up and take the checksums (and pictures) the timed
+    // passes must match
+    clear_targets(&cap);
+    for (f = 0; f < cap.nframes; f++) {
+        draw_frame(&cap, f, bands);
+        sums[f] = checksum(&cap);
+        if (golden.dir) golden_frame(&golden, &cap, f);
+    }
+
+    for (r = 0; r < repeats; r++) {
+        clear_targets(&cap);
+        for (f = 0; f < cap.nframes; f++) {
+            t0 = now_ms();
+            draw_frame(&cap, f, bands);
+            ms[f * repeats + r] = now_ms() - t0;
+            if (r == repeats - 1 && checksum(&cap) != sums[f]) mismatches++;
+        }
+    }
+
+    printf("frame  lists   cels    min ms    med ms    max ms   checksum\n");
+    for (f = 0; f < cap.nframes; f++) {
+        double* t = &ms[f * repeats];
+        int32 first = f ? cap.frame_ends[f - 1] : 0;
+
+        for (i = first, cels = 0; i < cap.frame_ends[f]; i++) cels += cap.draws[i].list.count;
+        qsort(t, repeats, sizeof(double), compare_ms);
+        medians[f] = t[repeats / 2];
+        printf("%5d  %5d  %5d  %8.3f  %8.3f  %8.3f   %08X\n", f, cap.frame_ends[f] - first, cels,
+               t[0], t[repeats / 2], t[repeats - 1], sums[f]);
+    }
+
+    // Spread over every frame of every repeat
+    memcpy(sorted, ms, (size_t)cap.nframes * repeats * sizeof(double));
+    qsort(sorted, (size_t)cap.nframes * repeats, sizeof(double), compare_ms);
+    for (i = 0, total = 0.0; i < cap.nframes * repeats; i++) total += sorted[i];
+    printf("\nms per frame: min %.3f  median %.3f  mean %.3f  p95 %.3f  max %.3f\n", sorted[0],
+           sorted[cap.nframes * repeats / 2], total / (cap.nframes * repeats),
+           sorted[(int32)(cap.nframes * repeats * 0.95)], sorted[cap.nframes * repeats - 1]);
+    if (mismatches) {
+        printf("%d frame(s) drew differently on the last repeat!\n", mismatches);
+    }
+    if (golden.dir) {
+        printf("\n");
+        golden_times(&golden, medians, cap.nframes);
+    }
+    status = mismatches || golden.failed;
+
+done:
+    for (i = 0; i < cap.ntargets; i++) free(cap.targets[i].pixels);
+    free(ms);
+    free(sorted);
+    free(medians);
+    free(sums);
+    capture_free(&cap);
+    SDL_Quit();
+    return status;
+}
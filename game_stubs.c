@@ -7,6 +7,7 @@
 #include "castle.h"
 #include "objects.h"
 #include "cinepak_decode.h"
+#include "platform/platform_raster.h"
 #include <stdarg.h>
 #include <time.h>
 #include <string.h>
@@ -56,6 +57,7 @@ void debug_printf(const char* format, ...) {
 // Forward declarations to avoid redefinition errors
 void fadeout(RastPort* rp, int32 frames);
 void fadeup(RastPort* rp, int32 frames);
+void installclut(RastPort* rp);
 
 // Forward declarations for 3DO graphics functions (implemented elsewhere)
 struct CelArray* parse3DO(char* filename);
@@ -105,6 +107,8 @@ void openlevelstuff(void)
         level_initialized = true;
     }
     
+    cy = CY * rendscale;
+
     // Load the actual level map for the current level
     printf("Opening level stuff, loading level map...\n");
     loadlevelmap("FloorPlan");  // Use the default level name directly
@@ -381,6 +385,7 @@ void extractcels(frac16 x, frac16 z, frac16 dir)
         frac16 x, z, angl, angr, sinl, cosl, sinr, cosr;
     } ed;
     
+    platform_perf_start("extractcels");
     ed.x = x;
     ed.z = z;
     
@@ -414,11 +419,14 @@ void extractcels(frac16 x, frac16 z, frac16 dir)
     
     processgrid();
     processvisobs();
+    platform_perf_end("extractcels");
     
     // Platform-specific rendering
     platform_wait_vbl(1);
+    platform_perf_start("rendercels");
     platform_clear_screen();
     rendercels();
+    platform_perf_end("rendercels");
 }
 
 // Graphics fade functions - authentic 3DO implementation  
@@ -427,7 +435,7 @@ void fadetoblank(RastPort* rp, int32 frames)
     // Fade screen to black over specified frames
     fadeout(rp, frames);
     SetRast(rp, 0);
-    platform_present_framebuffer();
+    installclut(rp);
 }
 
 void fadeout(RastPort* rp, int32 frames)
@@ -459,15 +467,9 @@ void fadetolevel(RastPort* rp, frac16 level)
     // Fade screen to specified brightness level (0 = black, ONE_F16 = full)
     if (!rp) return;
     
-    // Convert fixed-point level to 0-255 range for platform layer
-    uint32 brightness = (uint32)((level * 255) >> 16);
-    
-    // Apply fade effect to the entire screen
-    // In full implementation, this would modify the palette or apply a color overlay
-    // platform_set_screen_brightness(brightness);
-    
-    // For now, just track the fade level
-    (void)brightness;
+    // The 3DO scaled the screen's CLUT; the platform scales the frame
+    // as it is displayed, so nothing here touches the bitmap
+    platform_fade_screen(rp->rp_ScreenItem, level, level, level);
 }
 
 void installclut(RastPort* rp)
@@ -475,79 +477,8 @@ void installclut(RastPort* rp)
     // Install/update color lookup table
     if (!rp) return;
     
-    // In full implementation, this would update the graphics hardware palette
-    // For now, just ensure the display is properly configured
-    // platform_update_palette();
-}
-
-// Rendering line buffer functions - authentic 3DO implementation
-void resetlinebuf(uint32* linebuf)
-{
-    // Clear the line buffer for new frame
-    if (!linebuf) return;
-    
-    register int32* lb = (int32*)linebuf;
-    for (int i = 10; --i >= 0; )
-        *lb++ = ~0;
-}
-
-int islinefull(uint32* linebuf)
-{
-    // Check if line buffer is completely filled
-    if (!linebuf) return FALSE;
-    
-    register int32* lb = (int32*)linebuf;
-    for (int i = 10; --i >= 0; )
-        if (*lb++)
-            return FALSE;
-    
-    return TRUE;
-}
-
-int testmarklinebuf(uint32* linebuf, int32 lx, int32 rx)
-{
-    // Test and mark a horizontal span in the line buffer
-    register uint32 lm, rm;
-    
-    if (!linebuf || lx == rx) return FALSE;
-    
-    rx--;
-    if (lx > rx) {
-        lx ^= rx; rx ^= lx; lx ^= rx;  // Swap
-    }
-    if (lx >= 320 || rx < 0) return FALSE;
-    
-    if (lx < 0) lx = 0;
-    if (rx >= 320) rx = 320;
-    
-    // Check if region is already marked
-    register uint32* buf = &linebuf[lx >> 5];
-    lm = ~((1 << (lx & 31)) - 1);
-    rm = (1 << ((rx & 31) + 1)) - 1;
-    
-    if ((lx >> 5) == (rx >> 5)) {
-        // Single word case
-        uint32 mask = lm & rm;
-        if ((*buf & mask) != mask)
-            return FALSE;
-        *buf &= ~mask;  // Mark as used
-        return TRUE;
-    } else {
-        // Multi-word case
-        if ((*buf & lm) != lm) return FALSE;
-        for (uint32* p = buf + 1; p < &linebuf[rx >> 5]; p++) {
-            if (*p != ~0) return FALSE;
-        }
-        if ((linebuf[rx >> 5] & rm) != rm) return FALSE;
-        
-        // Mark the region
-        *buf &= ~lm;
-        for (uint32* p = buf + 1; p < &linebuf[rx >> 5]; p++) {
-            *p = 0;
-        }
-        linebuf[rx >> 5] &= ~rm;
-        return TRUE;
-    }
+    // Back to full brightness
+    platform_fade_screen(rp->rp_ScreenItem, ONE_F16, ONE_F16, ONE_F16);
 }
 
 // 3D projection and vertex processing - authentic 3DO implementation
@@ -593,9 +524,9 @@ void project(void)
             continue;
         }
         
-        // Perspective divide
-        dst->X = DivSF16(MulSF16(src->X, scale), src->Z) + Convert32_F16(CX);
-        dst->Y = DivSF16(MulSF16(src->Y, scale), src->Z) + Convert32_F16(CY);
+        // Perspective divide, at the internal render resolution
+        dst->X = DivSF16(MulSF16(src->X, scale * rendscale), src->Z) + Convert32_F16(cx);
+        dst->Y = DivSF16(MulSF16(src->Y, scale * rendscale), src->Z) + Convert32_F16(cy);
         dst->Z = src->Z;
     }
 }
@@ -920,11 +851,11 @@ void extract_north(ExtDat* ed)
     z = ConvertF16_32(ed->z);
     prevl = prevr = x;
 
-    stopz = z + GRIDCUTOFF;
+    stopz = z + gridcutoff;
     if (stopz > WORLDSIZ) stopz = WORLDSIZ;
-    stopxl = x - GRIDCUTOFF;
+    stopxl = x - gridcutoff;
     if (stopxl < 0) stopxl = 0;
-    stopxr = x + GRIDCUTOFF;
+    stopxr = x + gridcutoff;
     if (stopxr >= WORLDSIZ) stopxr = WORLDSIZ - 1;
 
     // Determine visible cels and left/right limits.
@@ -953,6 +884,10 @@ void extract_north(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (i != x && (me->me_VisFlags & VISF_WEST)) {
                 // Process west face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + WORLDSIZ + 1));
@@ -1009,6 +944,10 @@ void extract_north(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (me->me_VisFlags & VISF_EAST) {
                 // Process east face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + 1));
@@ -1091,11 +1030,11 @@ void extract_west(ExtDat* ed)
     z = ConvertF16_32(ed->z);
     prevl = prevr = z;
 
-    stopx = x - GRIDCUTOFF;
+    stopx = x - gridcutoff;
     if (stopx < 0) stopx = 0;
-    stopzl = z - GRIDCUTOFF;
+    stopzl = z - gridcutoff;
     if (stopzl < 0) stopzl = 0;
-    stopzr = z + GRIDCUTOFF;
+    stopzr = z + gridcutoff;
     if (stopzr >= WORLDSIZ) stopzr = WORLDSIZ - 1;
 
     // Determine visible cels and left/right limits.
@@ -1124,6 +1063,10 @@ void extract_west(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (i != z && (me->me_VisFlags & VISF_SOUTH)) {
                 // Process south face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx));
@@ -1180,6 +1123,10 @@ void extract_west(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (me->me_VisFlags & VISF_NORTH) {
                 // Process north face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + 1 + WORLDSIZ + 1));
@@ -1262,11 +1209,11 @@ void extract_south(ExtDat* ed)
     z = ConvertF16_32(ed->z);
     prevl = prevr = x;
 
-    stopz = z - GRIDCUTOFF;
+    stopz = z - gridcutoff;
     if (stopz < 0) stopz = 0;
-    stopxl = x + GRIDCUTOFF;
+    stopxl = x + gridcutoff;
     if (stopxl >= WORLDSIZ) stopxl = WORLDSIZ - 1;
-    stopxr = x - GRIDCUTOFF;
+    stopxr = x - gridcutoff;
     if (stopxr < 0) stopxr = 0;
 
     // Determine visible cels and left/right limits.
@@ -1295,6 +1242,10 @@ void extract_south(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (i != x && (me->me_VisFlags & VISF_EAST)) {
                 // Process east face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + 1));
@@ -1351,6 +1302,10 @@ void extract_south(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (me->me_VisFlags & VISF_WEST) {
                 // Process west face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + WORLDSIZ + 1));
@@ -1433,11 +1388,11 @@ void extract_east(ExtDat* ed)
     z = ConvertF16_32(ed->z);
     prevl = prevr = z;
 
-    stopx = x + GRIDCUTOFF;
+    stopx = x + gridcutoff;
     if (stopx > WORLDSIZ) stopx = WORLDSIZ;
-    stopzl = z + GRIDCUTOFF;
+    stopzl = z + gridcutoff;
     if (stopzl >= WORLDSIZ) stopzl = WORLDSIZ - 1;
-    stopzr = z - GRIDCUTOFF;
+    stopzr = z - gridcutoff;
     if (stopzr < 0) stopzr = 0;
 
     // Determine visible cels and left/right limits.
@@ -1466,6 +1421,10 @@ void extract_east(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (i != z && (me->me_VisFlags & VISF_NORTH)) {
                 // Process north face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx + 1 + WORLDSIZ + 1));
@@ -1522,6 +1481,10 @@ void extract_east(ExtDat* ed)
             if (!(me->me_Flags & MEF_ARTWORK) && !me->me_Obs)
                 continue;
 
+            // Out of room; the cels still to come are all farther away
+            if (nviso > MAXVISOBS - VISOBS_PER_CELL)
+                return;
+
             if (me->me_VisFlags & VISF_SOUTH) {
                 // Process south face.
                 SETBIT(vertsused, (vo->vo_LIdx = wvidx));
@@ -1988,10 +1951,12 @@ int dotitle(void)
         ccb->ccb_YPos = y_pos << 16;
         
         // Set up scaling (1:1 scaling)
-        ccb->ccb_HDX = ONE_F16;  // 1.0 in 16.16 fixed point
+        ccb->ccb_HDX = ONE_HD;   // 1.0 in 12.20 fixed point
         ccb->ccb_HDY = 0;
         ccb->ccb_VDX = 0; 
-        ccb->ccb_VDY = ONE_F16;  // 1.0 in 16.16 fixed point
+        ccb->ccb_VDY = ONE_VD;   // 1.0 in 16.16 fixed point
+        ccb->ccb_HDDX = 0;
+        ccb->ccb_HDDY = 0;
         
         printf("Rendering logo to screen...\n");
         printf("rpvis=%p, rpvis->rp_BitmapItem=%d\n", rpvis, rpvis ? rpvis->rp_BitmapItem : -1);
@@ -2085,20 +2050,45 @@ void DisplayFrameBuffer(uint32_t* buffer, int width, int height) {
     }
     
     uint32_t* screen_pixels = (uint32_t*)bitmap->bm_Buffer;
+    int32 bw = bitmap->bm_Width, bh = bitmap->bm_Height;
+    int32 s = bw / 320;
     
-    // Copy buffer to screen (assume both are 320x240 RGBA32)
-    if (width == 320 && height == 240) {
+    if (bitmap->bm_Format == BMF_RGB555) {
+        // 16-bit screens: narrow as we go, centered and replicated the same way
+        uint16* screen16 = (uint16*)bitmap->bm_Buffer;
+        int start_x = (320 - width) / 2;
+        int start_y = (240 - height) / 2;
+        
+        memset(screen16, 0, bw * bh * sizeof(uint16));
+        for (int y = 0; y < height && (start_y + y) < 240; y++) {
+            for (int sy = 0; sy < s; sy++) {
+                uint16* row = screen16 + ((start_y + y) * s + sy) * bw;
+                for (int x = 0; x < width && (start_x + x) < 320; x++) {
+                    for (int sx = 0; sx < s; sx++) {
+                        row[(start_x + x) * s + sx] = raster_rgb555(buffer[y * width + x]);
+                    }
+                }
+            }
+        }
+    } else if (width == 320 && height == 240 && s == 1) {
+        // Copy buffer to screen (assume both are 320x240 RGBA32)
         memcpy(screen_pixels, buffer, width * height * sizeof(uint32_t));
     } else {
-        // Clear screen and center the smaller buffer
-        memset(screen_pixels, 0, 320 * 240 * sizeof(uint32_t));
+        // Clear screen and center the smaller buffer, replicating each
+        // pixel to fill the internal render resolution
+        memset(screen_pixels, 0, bw * bh * sizeof(uint32_t));
         
         int start_x = (320 - width) / 2;
         int start_y = (240 - height) / 2;
         
         for (int y = 0; y < height && (start_y + y) < 240; y++) {
-            for (int x = 0; x < width && (start_x + x) < 320; x++) {
-                screen_pixels[(start_y + y) * 320 + (start_x + x)] = buffer[y * width + x];
+            for (int sy = 0; sy < s; sy++) {
+                uint32_t* row = screen_pixels + ((start_y + y) * s + sy) * bw;
+                for (int x = 0; x < width && (start_x + x) < 320; x++) {
+                    for (int sx = 0; sx < s; sx++) {
+                        row[(start_x + x) * s + sx] = buffer[y * width + x];
+                    }
+                }
             }
         }
     }
@@ -2365,7 +2355,79 @@ static uint32 min_uint32(uint32 a, uint32 b) {
     return b;
 }
 
-static void process_cel_texture(CCB* ccb, ubyte* pixel_data, uint32 data_size, uint32 width, uint32 height) {
+// Bits per pixel of a coded (PLUT-indexed) cel, or 0 if the cel is
+// uncoded or 16-bit
+static uint32 coded_cel_bpp(uint32 pre0) {
+    static const uint32 bits_per_pixel_table[] = {0, 1, 2, 4, 6, 8, 0, 0};
+    if (pre0 & 0x10) return 0;  // PRE0_LINEAR
+    return bits_per_pixel_table[pre0 & 0x7];
+}
+
+// Read count bits (up to 16) starting at bit offset bit, most significant first
+static uint32 read_cel_bits(const ubyte* data, uint32 size, uint32 bit, uint32 count) {
+    uint32 value = 0;
+    for (uint32 i = 0; i < count; i++, bit++) {
+        uint32 byte = bit >> 3;
+        value <<= 1;
+        if (byte < size) value |= (data[byte] >> (7 - (bit & 7))) & 1;
+    }
+    return value;
+}
+
+// Decode a coded cel to one PLUT index per texel.  Only the low five bits
+// of each pixel select a color; the rest are P-mode and multiplier bits
+// the cel engine doesn't use.  Transparent packets and anything past the
+// end of a row come out as TEX_INDEX_CLEAR.
+static void decode_coded_cel(ubyte* out, const ubyte* data, uint32 size, uint32 width,
+                             uint32 height, uint32 bpp, bool packed, uint32 pre1) {
+    memset(out, TEX_INDEX_CLEAR, width * height);
+
+    if (!packed) {
+        // Rows are a fixed number of words apart
+        uint32 woffset = bpp < 8 ? (pre1 >> 24) & 0xFF : (pre1 >> 16) & 0x3FF;
+        uint32 row_bytes = (woffset + 2) * 4;
+        for (uint32 line = 0; line < height && line * row_bytes < size; line++) {
+            uint32 bit = line * row_bytes * 8;
+            for (uint32 x = 0; x < width; x++, bit += bpp) {
+                out[line * width + x] = read_cel_bits(data, size, bit, bpp) & 0x1F;
+            }
+        }
+        return;
+    }
+
+    // Packed rows start with the word offset to the next row, then carry
+    // 2-bit type / 6-bit count packets: end of row, literal, transparent, repeat
+    uint32 pos = 0;
+    for (uint32 line = 0; line < height && pos < size; line++) {
+        uint32 offset_bits = bpp < 8 ? 8 : 16;
+        uint32 next = pos + ((read_cel_bits(data, size, pos * 8, offset_bits) & 0x3FF) + 2) * 4;
+        uint32 bit = pos * 8 + offset_bits;
+        uint32 x = 0;
+        ubyte* row = out + line * width;
+
+        while (x < width && bit + 8 <= next * 8) {
+            uint32 type = read_cel_bits(data, size, bit, 2);
+            uint32 count = read_cel_bits(data, size, bit + 2, 6) + 1;
+            bit += 8;
+            if (type == 0) break;
+            if (type == 1) {
+                for (; count && x < width; count--, bit += bpp) {
+                    row[x++] = read_cel_bits(data, size, bit, bpp) & 0x1F;
+                }
+            } else if (type == 2) {
+                x = min_uint32(x + count, width);
+            } else {
+                ubyte index = read_cel_bits(data, size, bit, bpp) & 0x1F;
+                bit += bpp;
+                for (; count && x < width; count--) row[x++] = index;
+            }
+        }
+        pos = next;
+    }
+}
+
+static void process_cel_texture(CCB* ccb, ubyte* pixel_data, uint32 data_size, uint32 width, uint32 height,
+                                uint32 pre0, uint32 pre1, uint16* plut) {
     printf("=== process_cel_texture() Entry ===\n");
     printf("ccb=%p, pixel_data=%p, data_size=%u, dimensions=%ux%u\n", 
            ccb, pixel_data, data_size, width, height);
@@ -2396,9 +2458,42 @@ static void process_cel_texture(CCB* ccb, ubyte* pixel_data, uint32 data_size, u
     
     tex->width = width;
     tex->height = height;
-    tex->format = 4; // RGBA32
+    tex->format = TEXFMT_RGBA32;
+    tex->tile_shift = 0;
+    tex->mip = NULL;
     tex->gl_id = NULL;
     
+    // Coded cels stay as PLUT indices, a quarter of the size of RGBA, and
+    // take their colors from ccb_PLUTPtr when drawn
+    bool is_packed = (ccb->ccb_Flags >> 9) & 1;  // CEL_FLAG_PACKED
+    uint32 preamble = 0;
+    if (!(ccb->ccb_Flags & CCB_CCBPRE) && data_size >= 8) {
+        // Preamble words lead the pixel data
+        pre0 = (pixel_data[0] << 24) | (pixel_data[1] << 16) | (pixel_data[2] << 8) | pixel_data[3];
+        pre1 = (pixel_data[4] << 24) | (pixel_data[5] << 16) | (pixel_data[6] << 8) | pixel_data[7];
+        preamble = is_packed ? 4 : 8;
+    }
+    uint32 coded_bpp = coded_cel_bpp(pre0);
+    if (plut && coded_bpp) {
+        ubyte* indices = (ubyte*)malloc(width * height);
+        if (!indices) {
+            printf("ERROR: Failed to allocate index buffer (%u bytes)\n", width * height);
+            free(tex);
+            return;
+        }
+        decode_coded_cel(indices, pixel_data + preamble, data_size - preamble, width, height,
+                         coded_bpp, is_packed, pre1);
+        tex->format = TEXFMT_INDEX8;
+        tex->data = indices;
+        platform_layout_texture(tex);
+        ccb->ccb_PLUTPtr = plut;
+        ccb->platform_texture = tex;
+        printf("Platform texture created: %ux%u, %u bpp coded, PLUT indexed at %p\n",
+               width, height, coded_bpp, tex);
+        printf("=== process_cel_texture() Exit ===\n");
+        return;
+    }
+    
     printf("Texture properties set: %dx%d, format=%d\n", tex->width, tex->height, tex->format);
     
     // Allocate RGBA pixel buffer
@@ -2450,7 +2545,6 @@ static void process_cel_texture(CCB* ccb, ubyte* pixel_data, uint32 data_size, u
     
     // Check CCB flags to determine format
     uint32 ccb_flags = ccb->ccb_Flags;
-    bool is_packed = (ccb_flags >> 9) & 1;  // CEL_FLAG_PACKED
     bool has_ccbpre = (ccb_flags >> 22) & 1; // CEL_FLAG_CCBPRE
     
     // Since we don't have direct access to PRE0 in the final CCB structure,
@@ -2777,6 +2871,7 @@ line_complete:
     
     printf("Setting texture data pointer...\n");
     tex->data = rgba_data;
+    platform_layout_texture(tex);
     
     printf("Assigning platform texture to CCB...\n");
     ccb->platform_texture = tex;
@@ -2918,7 +3013,9 @@ struct CelArray* parse3DO(char* filename)
             case 0x504C5554: // 'PLUT' - Pixel Lookup Table
                 printf("Parsing PLUT chunk\n");
                 plut_entries = read_be32(fp);
-                plut_data = (uint16*)malloc(plut_entries * sizeof(uint16));
+                // Short PLUTs (1-4 bpp cels) are padded out to the 32
+                // entries the cel engine indexes
+                plut_data = (uint16*)calloc(plut_entries < 32 ? 32 : plut_entries, sizeof(uint16));
                 if (plut_data) {
                     for (uint32 i = 0; i < plut_entries; i++) {
                         plut_data[i] = read_be16(fp);
@@ -2945,6 +3042,7 @@ struct CelArray* parse3DO(char* filename)
         CelArray* ca = (CelArray*)malloc(sizeof(CelArray));
         if (ca) {
             ca->ca_nCCBs = 1;
+            ca->ca_PLUT = NULL;
             ca->celptrs = (CCB**)malloc(sizeof(CCB*));
             if (ca->celptrs) {
                 ca->celptrs[0] = (CCB*)malloc(sizeof(CCB));
@@ -2962,12 +3060,16 @@ struct CelArray* parse3DO(char* filename)
                         ca->celptrs[0]->ccb_HDY = cel_control->ccb_hdy;
                         ca->celptrs[0]->ccb_VDX = cel_control->ccb_vdx;
                         ca->celptrs[0]->ccb_VDY = cel_control->ccb_vdy;
+                        ca->celptrs[0]->ccb_HDDX = cel_control->ccb_ddx;
+                        ca->celptrs[0]->ccb_HDDY = cel_control->ccb_ddy;
+                        ca->celptrs[0]->ccb_PIXC = cel_control->ccb_PPMPC;
                         printf("CCB configured from cel control chunk\n");
                     } else if (image_control) {
                         // Use image control data for CCB
                         ca->celptrs[0]->ccb_Flags = CCB_LAST | CCB_NPABS | CCB_LDSIZE | CCB_LDPRS | CCB_LDPPMP | CCB_YOXY | CCB_ACW;
                         ca->celptrs[0]->ccb_Width = image_control->w << 6;
                         ca->celptrs[0]->ccb_Height = image_control->h << 6;
+                        ca->celptrs[0]->ccb_PIXC = PPMP_MODE_NORMAL | (PPMP_MODE_NORMAL << PPMP_1_SHIFT);
                         printf("CCB configured from image control chunk\n");
                     }
                     
@@ -2978,15 +3080,27 @@ struct CelArray* parse3DO(char* filename)
                     if (pixel_data && pixel_data_size > 0) {
                         process_cel_texture(ca->celptrs[0], pixel_data, pixel_data_size, 
                                           cel_control ? cel_control->ccb_Width : image_control->w,
-                                          cel_control ? cel_control->ccb_Height : image_control->h);
+                                          cel_control ? cel_control->ccb_Height : image_control->h,
+                                          cel_control ? cel_control->ccb_PRE0 : 0,
+                                          cel_control ? cel_control->ccb_PRE1 : 0,
+                                          plut_entries ? plut_data : NULL);
                     }
+
+                    // Smaller copies of every frame, for monsters and
+                    // anything else drawn shrunk into the distance
+                    platform_build_cel_mips(ca);
                     
                     printf("Successfully created CelArray\n");
                     
-                    // Clean up temporary structures
+                    // Clean up temporary structures (the PLUT stays if an
+                    // indexed texture is drawn through it)
                     if (image_control) free(image_control);
                     if (cel_control) free(cel_control);
-                    if (plut_data) free(plut_data);
+                    if (plut_data && ca->celptrs[0]->ccb_PLUTPtr == plut_data) {
+                        ca->ca_PLUT = plut_data;
+                    } else if (plut_data) {
+                        free(plut_data);
+                    }
                     
                     return ca;
                 }
@@ -3022,6 +3136,9 @@ void freecelarray(struct CelArray* ca)
         }
         free(ca->celptrs);
     }
+    // The cels may have been pointed at other PLUTs since, so the one
+    // they were loaded with is freed from here rather than ccb_PLUTPtr
+    if (ca->ca_PLUT) free(ca->ca_PLUT);
     free(ca);
 }
 
@@ -14,10 +14,10 @@
 #include "objects.h"
 #include "imgfile.h"
 
-#include "app_proto.h"
-
 #include "font.h"
 
+#include "app_proto.h"
+
 extern int32	wide, high;
 extern uint32	ccbextra;
 extern RastPort *rprend, *rpvis;
@@ -210,7 +210,7 @@ char	*str;
 			TestText.TextPtr = genmsgs[i];
 			TestText.CoordX = genmsgsx[i];
 //			TestText.CoordY = 70+i*14;
-			FontPrint(&TestText);
+			printtext(&TestText);
 			TestText.CoordY += 14;
 	}
 
@@ -226,7 +226,7 @@ char	*str;
 				TestText.PLUTPtr = OptHiLitePLUT;
 			else
 				TestText.PLUTPtr = TestPLUT;
-			FontPrint(&TestText);
+			printtext(&TestText);
 
 			TestText.TextPtr = "No";
 			TestText.CoordX = 170;
@@ -234,7 +234,7 @@ char	*str;
 				TestText.PLUTPtr = TestPLUT;
 			else
 				TestText.PLUTPtr = OptHiLitePLUT;
-			FontPrint(&TestText);
+			printtext(&TestText);
 			resetjoydata ();
 			WaitVBL (vblIO, 1);
 
@@ -0,0 +1,212 @@
+/*  :ts=8 bk=0
+ *
+ * linebuf.c:	Span coverage buffer for the wall/object renderer.
+ *
+ * Replaces the fixed 320-column linebuf[10] and its ARM routines in
+ * misc.asm.  The buffer holds one bit per column of the render target
+ * and is tested and marked a whole word at a time, so the cost of a span
+ * grows with its width in words, not in pixels.
+ */
+#include "castle.h"
+
+
+#define	LB_ALLONES	(~(uint64) 0)
+
+
+/***************************************************************************
+ * Population count of a coverage word.
+ */
+static int32
+popcount64 (uint64 w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (__builtin_popcountll (w));
+#else
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return ((int32) ((w * 0x0101010101010101ULL) >> 56));
+#endif
+}
+
+/*
+ * Bit n of a word is column (word * LB_WORDBITS + n).  These return the
+ * mask of columns >= n and <= n within a word.
+ */
+#define	LEFTMASK(n)	(LB_ALLONES << (n))
+#define	RIGHTMASK(n)	(LB_ALLONES >> (LB_WORDBITS - 1 - (n)))
+
+
+/*
+ * Normalizes [lx, rx) to an inclusive, clipped column range.  Returns
+ * FALSE if nothing of it lands on the buffer.
+ */
+static int
+cliprange (lb, lxp, rxp)
+register struct LineBuf	*lb;
+int32			*lxp, *rxp;
+{
+	register int32	lx, rx;
+
+	lx = *lxp;
+	rx = *rxp;
+
+	if (lx == rx)
+		return (FALSE);
+
+	rx--;
+	if (lx > rx) {
+		lx ^= rx;  rx ^= lx;  lx ^= rx;
+	}
+	if (lx >= lb->lb_Width  ||  rx < 0)
+		return (FALSE);
+
+	if (lx < 0)			lx = 0;
+	if (rx >= lb->lb_Width)		rx = lb->lb_Width - 1;
+
+	*lxp = lx;
+	*rxp = rx;
+	return (TRUE);
+}
+
+
+/***************************************************************************
+ * Allocates a buffer wide enough for the given number of columns.
+ */
+int
+initlinebuf (lb, width)
+register struct LineBuf	*lb;
+int32			width;
+{
+	lb->lb_Width = width;
+	lb->lb_NWords = (width + LB_WORDBITS - 1) / LB_WORDBITS;
+	if (!(lb->lb_Bits = malloctype (lb->lb_NWords * sizeof (uint64),
+					MEMTYPE_ANY)))
+		return (FALSE);
+
+	resetlinebuf (lb);
+	return (TRUE);
+}
+
+void
+freelinebuf (lb)
+register struct LineBuf	*lb;
+{
+	if (lb->lb_Bits)	freetype (lb->lb_Bits), lb->lb_Bits = NULL;
+	lb->lb_Width = lb->lb_NWords = lb->lb_NOpen = 0;
+}
+
+
+/*
+ * Opens every column.  Bits past the last column are left clear so whole
+ * words can be tested without masking the tail.
+ */
+void
+resetlinebuf (lb)
+register struct LineBuf	*lb;
+{
+	register uint64	*w;
+	register int32	i;
+
+	if (!(w = lb->lb_Bits))
+		return;
+
+	for (i = lb->lb_NWords;  --i >= 0; )
+		*w++ = LB_ALLONES;
+
+	if (lb->lb_Width % LB_WORDBITS)
+		lb->lb_Bits[lb->lb_NWords - 1] =
+		 RIGHTMASK ((lb->lb_Width - 1) % LB_WORDBITS);
+
+	lb->lb_NOpen = lb->lb_Width;
+}
+
+
+/*
+ * TRUE once every column has been covered by something opaque.  The open
+ * column count is kept up to date by testmarklinebuf(), so this is free.
+ */
+int
+islinefull (lb)
+struct LineBuf	*lb;
+{
+	return (lb->lb_NOpen <= 0);
+}
+
+
+/*
+ * Returns TRUE if any column in [lx, rx) is still open.
+ */
+int
+testlinebuf (lb, lx, rx)
+register struct LineBuf	*lb;
+int32			lx, rx;
+{
+	register uint64	*w, lm, rm;
+	register int32	li, ri;
+
+	if (!cliprange (lb, &lx, &rx))
+		return (FALSE);
+
+	lm = LEFTMASK (lx % LB_WORDBITS);
+	rm = RIGHTMASK (rx % LB_WORDBITS);
+	li = lx / LB_WORDBITS;
+	ri = rx / LB_WORDBITS;
+	w = lb->lb_Bits;
+
+	if (li == ri)
+		return ((w[li] & lm & rm) != 0);
+
+	if (w[li] & lm)
+		return (TRUE);
+	while (++li < ri)
+		if (w[li])
+			return (TRUE);
+	return ((w[ri] & rm) != 0);
+}
+
+
+/*
+ * Returns TRUE if you need to draw a polygon; FALSE if you don't.
+ * The specified region is marked as used in both cases.
+ * Note: Marking a region actually means clearing the bits.
+ */
+int
+testmarklinebuf (lb, lx, rx)
+register struct LineBuf	*lb;
+int32			lx, rx;
+{
+	register uint64	*w, lm, rm, hit;
+	register int32	li, ri, closed;
+
+	if (!cliprange (lb, &lx, &rx))
+		return (FALSE);
+
+	lm = LEFTMASK (lx % LB_WORDBITS);
+	rm = RIGHTMASK (rx % LB_WORDBITS);
+	li = lx / LB_WORDBITS;
+	ri = rx / LB_WORDBITS;
+	w = lb->lb_Bits;
+
+	if (li == ri) {
+		hit = w[li] & lm & rm;
+		w[li] &= ~hit;
+		closed = popcount64 (hit);
+	} else {
+		hit = w[li] & lm;
+		w[li] &= ~lm;
+		closed = popcount64 (hit);
+		while (++li < ri) {
+			if (w[li]) {
+				closed += popcount64 (w[li]);
+				w[li] = 0;
+			}
+		}
+		hit = w[ri] & rm;
+		w[ri] &= ~rm;
+		closed += popcount64 (hit);
+	}
+
+	lb->lb_NOpen -= closed;
+	return (closed != 0);
+}
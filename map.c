@@ -5,9 +5,11 @@
  * Leo L. Schwab					9310.18
  */
 #include <types.h>
+#include <mem.h>
 #include <graphics.h>
 #include <event.h>
 #include <operamath.h>
+#include <string.h>
 
 #include "castle.h"
 #include "objects.h"
@@ -51,10 +53,18 @@
 #define	CY_NEEDLE	(YMARGIN + 34)
 
 #define	COLR_BG		MakeRGB15Pair (5, 3, 7)
+#define	COLR_BGPIXEL	MakeRGB15 (5, 3, 7)
 #define	COLR_SURF	MakeRGB15 (22, 16, 26)
 #define	COLR_MID	MakeRGB15 (16, 12, 18)
 #define	COLR_OUTER	MakeRGB15 (8, 2, 16)
 
+/*
+ * More changed cells than this between looks at the map, and it gets
+ * drawn again from scratch.
+ */
+#define	MAXMAPCHANGES	512
+
+
 enum	GlyphTypes {
 	GLYPH_PLAYER = 0,
 	GLYPH_NSDOOR,
@@ -68,6 +78,8 @@ enum	GlyphTypes {
 /***************************************************************************
  * Forward function declarations.  (Grrrr...)
  */
+static void	drawcell (struct RastPort *, int, int, int);
+static void	markcell (int, int);
 static void	drawcorner (struct RastPort *, int, int32, int32);
 static void	checkglyph (struct RastPort *, struct MapEntry *, int32, int32);
 static void	drawglyph (struct RastPort *, int, int32, int32);
@@ -93,6 +105,18 @@ static Vertex		needlequad[4], xfneedle[4];
 
 static CelArray		*ca_glyphs, *ca_compass, *ca_needle;
 
+/*
+ * The map as it was last shown, before the player and compass went on
+ * it, and the cells that have changed since.  Cells only ever get drawn
+ * into their own 3x3 block, so each can be brought up to date by itself.
+ */
+static void		*mapimage;
+static int32		mapimagesize;
+static int		mapvalid;
+static int32		nmapchanges;
+static uint16		mapchanges[MAXMAPCHANGES];
+static ubyte		mapmarks[WORLDSIZ * WORLDSIZ / 8];
+
 
 /***************************************************************************
  * Code.
@@ -101,7 +125,6 @@ int
 drawmap ()
 {
 	register CCB		*ccb;
-	register MapEntry	*me;
 	register int		i, x, z;
 	Matrix			unit, cam;
 	int32			px, pz;
@@ -109,67 +132,38 @@ drawmap ()
 	RastPort		*tmp;
 	Point			quad[4];
 
-	SetRast (rprend, COLR_BG);
-
-	for (z = WORLDSIZ;  --z >= 0; ) {
-		for (x = WORLDSIZ;  --x >= 0; ) {
-			me = &levelmap[z][x];
-			px = XORG + x + x + x;
-			pz = YORG - z - z - z;
-
-			if (me->me_Obs)
-				checkglyph (rprend, me, px, pz);
-
-			if (!(me->me_Flags & MEF_WALKSOLID))
-				continue;
-
-			if (i = me->me_VisFlags >> 4) {
-				ccb = ca_glyphs->celptrs[i];
-
-				ccb->ccb_XPos = px << 16;
-				ccb->ccb_YPos = pz << 16;
-				DrawCels (rprend->rp_BitmapItem, ccb);
-			}
-
-			i = 0;
-			if (z < WORLDSIZ - 1) {
-				mf = levelmap[z+1][x].me_VisFlags;
-				if (mf & MAPF_WEST)	i |= CORNF_NW;
-				if (mf & MAPF_EAST)	i |= CORNF_NE;
-			}
-
-			if (z) {
-				mf = levelmap[z-1][x].me_VisFlags;
-				if (mf & MAPF_WEST)	i |= CORNF_SW;
-				if (mf & MAPF_EAST)	i |= CORNF_SE;
-			}
-
-			if (x < WORLDSIZ - 1) {
-				mf = levelmap[z][x+1].me_VisFlags;
-				if (mf & MAPF_NORTH)	i |= CORNF_EN;
-				if (mf & MAPF_SOUTH)	i |= CORNF_ES;
-			}
-
-			if (x) {
-				mf = levelmap[z][x-1].me_VisFlags;
-				if (mf & MAPF_NORTH)	i |= CORNF_WN;
-				if (mf & MAPF_SOUTH)	i |= CORNF_WS;
-			}
-
-
-			if ((i & CORNF_NW_WN) == CORNF_NW_WN)
-				drawcorner (rprend, CORNER_NW, px, pz);
-
-			if ((i & CORNF_SW_WS) == CORNF_SW_WS)
-				drawcorner (rprend, CORNER_SW, px, pz);
+	if (mapvalid) {
+		/*
+		 * Start from the map as it was last shown and bring just the
+		 * cells that have changed since up to date.
+		 */
+		CopyVRAMPages (sportIO,
+			       rprend->rp_Bitmap->bm_Buffer, mapimage,
+			       screenpages, ~0L);
+
+		for (i = nmapchanges;  --i >= 0; ) {
+			x = mapchanges[i];
+			mapmarks[x >> 3] &= ~(1 << (x & 7));
+			drawcell (rprend, x & (WORLDSIZ - 1), x / WORLDSIZ, TRUE);
+		}
+	} else {
+		SetRast (rprend, COLR_BG);
 
-			if ((i & CORNF_SE_ES) == CORNF_SE_ES)
-				drawcorner (rprend, CORNER_SE, px, pz);
+		for (z = WORLDSIZ;  --z >= 0; )
+			for (x = WORLDSIZ;  --x >= 0; )
+				drawcell (rprend, x, z, FALSE);
 
-			if ((i & CORNF_NE_EN) == CORNF_NE_EN)
-				drawcorner (rprend, CORNER_NE, px, pz);
-		}
+		memset (mapmarks, 0, sizeof (mapmarks));
+		mapvalid = TRUE;
 	}
+	nmapchanges = 0;
+
+	/*
+	 * Keep it for next time.
+	 */
+	CopyVRAMPages (sportIO,
+		       mapimage, rprend->rp_Bitmap->bm_Buffer,
+		       screenpages, ~0L);
 
 	/*
 	 * Draw player.
@@ -230,6 +224,145 @@ drawmap ()
 }
 
 
+/***************************************************************************
+ * Keeping the map image up to date.
+ */
+void
+markmapcell (me)
+MapEntry	*me;
+{
+	register int	x, z;
+
+	if (!mapvalid)
+		return;		/*  It'll all be drawn anyway.  */
+
+	x = (me - &levelmap[0][0]) & (WORLDSIZ - 1);
+	z = (me - &levelmap[0][0]) / WORLDSIZ;
+
+	/*
+	 * The corners drawn in the cells around this one depend on its
+	 * flags, too.
+	 */
+	markcell (x, z);
+	if (x)			markcell (x - 1, z);
+	if (x < WORLDSIZ - 1)	markcell (x + 1, z);
+	if (z)			markcell (x, z - 1);
+	if (z < WORLDSIZ - 1)	markcell (x, z + 1);
+}
+
+void
+resetmap ()
+{
+	mapvalid = FALSE;
+	nmapchanges = 0;
+}
+
+
+static void
+markcell (x, z)
+int	x, z;
+{
+	register int	idx;
+
+	idx = z * WORLDSIZ + x;
+	if (mapmarks[idx >> 3] & (1 << (idx & 7)))
+		return;
+
+	if (nmapchanges >= MAXMAPCHANGES) {
+		/*  Quicker to start over.  */
+		mapvalid = FALSE;
+		return;
+	}
+	mapmarks[idx >> 3] |= 1 << (idx & 7);
+	mapchanges[nmapchanges++] = idx;
+}
+
+
+/***************************************************************************
+ * The bit that draws a cell: its doors and such, its walls and the corners
+ * where its walls meet its neighbors'.
+ */
+static ubyte	cellblock[] = {
+	0, 0,	1, 0,	2, 0,
+	0, 1,	1, 1,	2, 1,
+	0, 2,	1, 2,	2, 2
+};
+#define	NOFFS_CELL	(sizeof (cellblock) / 2)
+
+
+static void
+drawcell (rp, x, z, clear)
+RastPort	*rp;
+register int	x, z;
+int		clear;
+{
+	register CCB		*ccb;
+	register MapEntry	*me;
+	register int		i;
+	int32			px, pz;
+	int			mf;
+
+	me = &levelmap[z][x];
+	px = XORG + x + x + x;
+	pz = YORG - z - z - z;
+
+	if (clear)
+		drawpoints (rp, px, pz, cellblock, NOFFS_CELL, COLR_BGPIXEL);
+
+	if (me->me_Obs)
+		checkglyph (rp, me, px, pz);
+
+	if (!(me->me_Flags & MEF_WALKSOLID))
+		return;
+
+	if (i = me->me_VisFlags >> 4) {
+		ccb = ca_glyphs->celptrs[i];
+
+		ccb->ccb_XPos = px << 16;
+		ccb->ccb_YPos = pz << 16;
+		DrawCels (rp->rp_BitmapItem, ccb);
+	}
+
+	i = 0;
+	if (z < WORLDSIZ - 1) {
+		mf = levelmap[z+1][x].me_VisFlags;
+		if (mf & MAPF_WEST)	i |= CORNF_NW;
+		if (mf & MAPF_EAST)	i |= CORNF_NE;
+	}
+
+	if (z) {
+		mf = levelmap[z-1][x].me_VisFlags;
+		if (mf & MAPF_WEST)	i |= CORNF_SW;
+		if (mf & MAPF_EAST)	i |= CORNF_SE;
+	}
+
+	if (x < WORLDSIZ - 1) {
+		mf = levelmap[z][x+1].me_VisFlags;
+		if (mf & MAPF_NORTH)	i |= CORNF_EN;
+		if (mf & MAPF_SOUTH)	i |= CORNF_ES;
+	}
+
+	if (x) {
+		mf = levelmap[z][x-1].me_VisFlags;
+		if (mf & MAPF_NORTH)	i |= CORNF_WN;
+		if (mf & MAPF_SOUTH)	i |= CORNF_WS;
+	}
+
+
+	if ((i & CORNF_NW_WN) == CORNF_NW_WN)
+		drawcorner (rp, CORNER_NW, px, pz);
+
+	if ((i & CORNF_SW_WS) == CORNF_SW_WS)
+		drawcorner (rp, CORNER_SW, px, pz);
+
+	if ((i & CORNF_SE_ES) == CORNF_SE_ES)
+		drawcorner (rp, CORNER_SE, px, pz);
+
+	if ((i & CORNF_NE_EN) == CORNF_NE_EN)
+		drawcorner (rp, CORNER_NE, px, pz);
+}
+
+
 
 
 /***************************************************************************
@@ -443,6 +576,12 @@ loadmap ()
 	if (!(ca_needle = parse3DO ("Needle.cel")))
 		die ("Couldn't load needle image.\n");
 
+	mapimagesize = screenpages * GrafBase->gf_VRAMPageSize;
+	if (!(mapimage = AllocMem (mapimagesize,
+				   MEMTYPE_VRAM | MEMTYPE_STARTPAGE)))
+		die ("Couldn't allocate map image.\n");
+	mapvalid = FALSE;
+
 
 	for (i = ca_glyphs->ncels;  --i >= 0; ) {
 		ccb = ca_glyphs->celptrs[i];
@@ -490,6 +629,11 @@ loadmap ()
 void
 freemap ()
 {
+	if (mapimage) {
+		FreeMem (mapimage, mapimagesize);
+		mapimage = NULL;
+	}
+	mapvalid = FALSE;
 	if (ca_needle) {
 		freecelarray (ca_needle);
 		ca_needle = NULL;
@@ -109,7 +109,7 @@ extern int32	nobverts;
 
 extern CCB	*curccb;
 
-extern uint32	linebuf[];
+extern LineBuf	linebuf;
 
 
 /***************************************************************************
@@ -355,12 +355,13 @@ Vertex oldpos;
 		corner[3].pt_X = corner[0].pt_X;
 		corner[3].pt_Y = vp[0].Y;
 
-		if (!testlinebuf (linebuf, corner[0].pt_X, corner[1].pt_X))
+		if (!testlinebuf (&linebuf, corner[0].pt_X, corner[1].pt_X))
 			break;
 
 		ccb = curccb++;
 		ccb->ccb_Flags		= srcccb->ccb_Flags;
 		ccb->ccb_SourcePtr	= srcccb->ccb_SourcePtr;
+		ccb->platform_texture	= srcccb->platform_texture;
 		ccb->ccb_PLUTPtr	= srcccb->ccb_PLUTPtr;
 
 		if (om->om_Hits > 1) {
@@ -377,7 +378,7 @@ Vertex oldpos;
 //			ccb->ccb_PIXC = pixctable[om->om_CurFrame];
 //			ccb->ccb_PIXC = 0x1f811f81;	//  50%
 
-		FasterMapCel (ccb, corner);
+		rendmapcel (ccb, corner);
 		ccb->ccb_Flags &= ~CCB_LAST;
 
 		/*
@@ -406,7 +407,7 @@ Vertex oldpos;
 		register Vertex	*ov;
 
 		ov = obverts + om->ob.ob_VertIdx;
-		if (ov->X <= CX  &&  ov->Y >= CX) {
+		if (ov->X <= cx  &&  ov->Y >= cx) {
 			if (om->om_Hits) {
 				om->om_CurFrame	= 0;
 				if (!(--(om->om_Hits))) {
@@ -96,7 +96,7 @@ extern int32	nobverts;
 
 extern CCB	*curccb;
 
-extern uint32	linebuf[];
+extern LineBuf	linebuf;
 
 extern int32	nkeys;
 
@@ -234,15 +234,18 @@ void				*dat;
 		corner[3].pt_X = corner[0].pt_X;
 		corner[3].pt_Y = vp[0].Y;
 
-		if (!testlinebuf (linebuf, corner[0].pt_X, corner[1].pt_X))
+		if (!testlinebuf (&linebuf, corner[0].pt_X, corner[1].pt_X))
 			break;
 
 		ccb = curccb++;
 		img2ccb (ie, ccb);
 
-		FasterMapCel (ccb, corner);
+		rendmapcel (ccb, corner);
 		ccb->ccb_Flags &= ~CCB_LAST;
-		ob->ob.ob_Flags |= OBF_SAWME;
+		if (!(ob->ob.ob_Flags & OBF_SAWME)) {
+			ob->ob.ob_Flags |= OBF_SAWME;
+			markmapcell (ob->ob_ME);
+		}
 
 		break;
 	 }
@@ -271,6 +274,7 @@ void				*dat;
 				}
 			} else {
 				removeobfromme ((Object *) ob, ob->ob_ME);
+				markmapcell (ob->ob_ME);
 				if (!(ob->ob.ob_Flags & OBF_MOVE))
 					ob->ob.ob_State = OBS_INVALID;
 
@@ -105,7 +105,7 @@ extern int32	nobverts;
 
 extern CCB	*curccb;
 
-extern uint32	linebuf[];
+extern LineBuf	linebuf;
 extern Object	**obtab;
 extern int32	obtabsiz;
 
@@ -419,12 +419,13 @@ void				*dat;
 
 		corner[3].pt_X = corner[0].pt_X;
 
-		if (!testlinebuf (linebuf, corner[0].pt_X, corner[1].pt_X))
+		if (!testlinebuf (&linebuf, corner[0].pt_X, corner[1].pt_X))
 			break;
 
 		ccb = curccb++;
 		ccb->ccb_Flags		= srcccb->ccb_Flags;
 		ccb->ccb_SourcePtr	= srcccb->ccb_SourcePtr;
+		ccb->platform_texture	= srcccb->platform_texture;
 		ccb->ccb_PLUTPtr	= srcccb->ccb_PLUTPtr;
 		ccb->ccb_PIXC		= srcccb->ccb_PIXC;
 		ccb->ccb_PRE0		= srcccb->ccb_PRE0;
@@ -432,7 +433,7 @@ void				*dat;
 		ccb->ccb_Width		= srcccb->ccb_Width;
 		ccb->ccb_Height		= srcccb->ccb_Height;
 
-		FasterMapCel (ccb, corner);
+		rendmapcel (ccb, corner);
 		ccb->ccb_Flags &= ~CCB_LAST;
 
 		/*
@@ -468,7 +469,7 @@ void				*dat;
 		register Vertex	*ov;
 
 		ov = obverts + om->ob.ob_VertIdx;
-		if (ov->X <= CX  &&  ov->Y >= CX) {
+		if (ov->X <= cx  &&  ov->Y >= cx) {
 			om->ob.ob_State	= OBS_DYING;
 			om->om_CurFrame	= 0;
 			if (om->om_CurSeq == def_Spider.dm_SpiderShot) {
@@ -34,7 +34,7 @@ extern int32	nobverts;
 
 extern CCB	*curccb;
 
-extern uint32	linebuf[];
+extern LineBuf	linebuf;
 extern Object	**obtab;
 extern int32	obtabsiz;
 
@@ -294,12 +294,13 @@ void				*dat;
 		corner[3].pt_X = corner[0].pt_X;
 		corner[3].pt_Y = vp[0].Y;
 
-		if (!testlinebuf (linebuf, corner[0].pt_X, corner[1].pt_X))
+		if (!testlinebuf (&linebuf, corner[0].pt_X, corner[1].pt_X))
 			break;
 
 		ccb = curccb++;
 		ccb->ccb_Flags		= srcccb->ccb_Flags;
 		ccb->ccb_SourcePtr	= srcccb->ccb_SourcePtr;
+		ccb->platform_texture	= srcccb->platform_texture;
 		ccb->ccb_PLUTPtr	= srcccb->ccb_PLUTPtr;
 
 		if (oz->oz_Hits > 1) {
@@ -312,7 +313,7 @@ void				*dat;
 		ccb->ccb_Width		= srcccb->ccb_Width;
 		ccb->ccb_Height		= srcccb->ccb_Height;
 
-		FasterMapCel (ccb, corner);
+		rendmapcel (ccb, corner);
 		ccb->ccb_Flags &= ~CCB_LAST;
 
 		/*
@@ -344,7 +345,7 @@ void				*dat;
 		register Vertex	*ov;
 
 		ov = obverts + oz->ob.ob_VertIdx;
-		if (ov->X <= CX  &&  ov->Y >= CX) {
+		if (ov->X <= cx  &&  ov->Y >= cx) {
 			if (oz->oz_Hits) {
 				oz->oz_CurFrame	= 0;
 				if (!(--(oz->oz_Hits))) {
@@ -37,7 +37,7 @@ extern int32	playerhealth;
 extern int32	nkeys;
 extern frac16	damagefade;
 
-extern uint32	linebuf[];
+extern LineBuf	linebuf;
 
 extern uint32	ccbextra;
 
@@ -693,9 +693,11 @@ void				*dat;
 			      xfobverts + od->ob.ob_VertIdx,
 			      FALSE);
 
-		if (prevccb != curccb)
+		if (prevccb != curccb  &&  !(od->ob.ob_Flags & OBF_SAWME)) {
 			/*  Something was actually rendered.  */
 			od->ob.ob_Flags |= OBF_SAWME;
+			markmapcell (&levelmap[od->od_ZIdx][od->od_XIdx]);
+		}
 
 		break;
 	 }
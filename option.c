@@ -360,7 +360,7 @@ DoHighScoreScr( int32 newScore )
 			lineOfText.CoordX = firstItemXLoc;
 			lineOfText.TextPtr = theInfo.score[i].name;
 
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 
 			// Draw Number
 
@@ -369,7 +369,7 @@ DoHighScoreScr( int32 newScore )
 			lineOfText.CoordX = secondItemXLoc;
 			lineOfText.TextPtr = buff;
 
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 
 		// Instructions at end
@@ -382,20 +382,20 @@ DoHighScoreScr( int32 newScore )
 			{
 			lineOfText.CoordY += instrLineHeight;
 			lineOfText.TextPtr = noEditInstrStr;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 		else
 			{
 			lineOfText.TextPtr = editInstr1Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 
 			lineOfText.CoordY += instrLineHeight;
 			lineOfText.TextPtr = editInstr2Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 
 			lineOfText.CoordY += instrLineHeight;
 			lineOfText.TextPtr = editInstr3Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 
 		// Process High Score Entry
@@ -623,7 +623,7 @@ DoLoadGameScr( struct SaveGameRec *theGame )
 				 i + 1, theInfo.save[i].name);
 			lineOfText.TextPtr = buff;
 
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 
 		// Instructions at end
@@ -635,22 +635,22 @@ DoLoadGameScr( struct SaveGameRec *theGame )
 			{
 			lineOfText.CoordY = firstInstrYLoc;
 			lineOfText.TextPtr = loadInstr1Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 
 			lineOfText.CoordY += instrLineHeight;
 			lineOfText.TextPtr = loadInstr2Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 		else
 			{
 			lineOfText.CoordY = firstInstrYLoc;
 			lineOfText.TextPtr = loadInstr4Str;
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 
 		lineOfText.CoordY += instrLineHeight;
 		lineOfText.TextPtr = loadInstr3Str;
-		FontPrint(&lineOfText);
+		printtext(&lineOfText);
 
 		if ( curSelLine != -1 )
 			{
@@ -806,7 +806,7 @@ DoSaveGameScr( struct SaveGameRec *theGame )
 				 i + 1, theInfo.save[i].name);
 			lineOfText.TextPtr = buff;
 
-			FontPrint(&lineOfText);
+			printtext(&lineOfText);
 			}
 
 		// Instructions at end
@@ -816,15 +816,15 @@ DoSaveGameScr( struct SaveGameRec *theGame )
 
 		lineOfText.CoordY = firstInstrYLoc;
 		lineOfText.TextPtr = ((curEditLine == -1) ? saveInstr1Str : editInstr1Str);
-		FontPrint(&lineOfText);
+		printtext(&lineOfText);
 
 		lineOfText.CoordY += instrLineHeight;
 		lineOfText.TextPtr = ((curEditLine == -1) ? saveInstr2Str : editInstr2Str);
-		FontPrint(&lineOfText);
+		printtext(&lineOfText);
 
 		lineOfText.CoordY += instrLineHeight;
 		lineOfText.TextPtr = ((curEditLine == -1) ? saveInstr3Str : editInstr3Str);
-		FontPrint(&lineOfText);
+		printtext(&lineOfText);
 
 		// Process High Score Entry
 
@@ -0,0 +1,1530 @@
+/*
+ * cel_raster.c - Software cel engine shared by the platform back ends
+ *
+ * Cels are scan converted as convex quadrilaterals with fixed-point edge
+ * stepping.  Each covered pixel center is mapped back into the source
+ * image with an inverse affine transform, so the inner loop is a plain
+ * (u, v) step along the span.  Cels with non-zero HDDX/HDDY (the
+ * perspective walls built by buildcellist()) are drawn one source row at
+ * a time, each row being a thin quad with a constant v, unless the target
+ * asks for column walls (see column_wall()).
+ *
+ * Textures are either linear rows or square tiles (see
+ * raster_tile_texture()), of RGBA32 texels or of PLUT indices looked up
+ * through the cel's ccb_PLUTPtr as they are drawn; only the texel fetches
+ * care which.  The target is RGBA32, or RGB555 like the 3DO's own frame
+ * buffer, at half the bandwidth; texels are narrowed as they are stored.
+ * Cels that load a PIXC are run through the 3DO's pixel processor
+ * equation on the way (see set_blend()).
+ */
+
+#include "platform/platform_raster.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#endif
+
+#define FIX_ONE         (1 << 16)
+#define FIX_HALF        (1 << 15)
+#define FIX_LIMIT       ((int64)1 << 46)
+
+// Vertices further out than this (in 16.16) are pulled in so the edge
+// arithmetic can't overflow; anything out there is off screen anyway.
+#define COORD_LIMIT     ((int64)1 << 30)
+
+// Targets bigger than this (about what a core's share of the cache
+// holds) are filled with non-temporal stores; a fill that size would
+// only push out what the cels drawn over it need.
+#define STREAM_BYTES    ((size_t)2 << 20)
+
+// Widest texture checked for one color per row: the narrowest 16-bit
+// literal cel, and the shape of the backwall's floor/ceiling gradient
+#define FLAT_MAX_WIDTH  2
+
+// Source image and the mapping from destination pixels back into it
+typedef struct CelMap {
+    const uint32* texels;   // RGBA32 texels, or
+    const ubyte* indices;   // PLUT indices looked up through lut
+    const uint32* lut;      // The cel's 32 PLUT entries, expanded
+    int32 tw, th;
+    int keyed;              // Zero-alpha texels are transparent
+    const struct SpanFuncs* spans;  // Loops for the target and the blend
+    int32 mul, shift, dshift;       // Pixel processor (see set_blend())
+    uint32 p_cel, p_fb;             // Primary source masks
+    uint32 s_cel, s_fb, av;         // Secondary source masks, or a constant
+    int32 tshift;           // Tile size shift, 0 if linear
+    int32 tpitch;           // Tiles per row of tiles
+    int32 row;              // Source row, or -1 if v varies
+    int32 flat;             // Every source row is one color; spans are fills
+    int64 u00, v00;         // u, v at the center of pixel (0, 0), 16.16
+    int64 dudx, dudy;
+    int64 dvdx, dvdy;
+} CelMap;
+
+typedef struct QuadEdge {
+    int32 y_first, y_end;   // Scanlines whose centers the edge crosses
+    int64 x, dxdy;          // x at y_first, 16.16
+} QuadEdge;
+
+
+// First pixel whose center lies at or beyond the 16.16 coordinate v
+static inline int32 center_ceil(int64 v)
+{
+    return (int32)((v - FIX_HALF + (FIX_ONE - 1)) >> 16);
+}
+
+static inline int64 to_fix(double v)
+{
+    double f = v * FIX_ONE;
+    if (f > (double)FIX_LIMIT) return FIX_LIMIT;
+    if (f < -(double)FIX_LIMIT) return -FIX_LIMIT;
+    return (int64)(f < 0 ? f - 0.5 : f + 0.5);
+}
+
+static inline int64 to_coord(double v)
+{
+    int64 c = to_fix(v);
+    if (c > COORD_LIMIT) return COORD_LIMIT;
+    if (c < -COORD_LIMIT) return -COORD_LIMIT;
+    return c;
+}
+
+static inline int32 narrow(int64 v)
+{
+    if (v > 0x3FFFFFFF) return 0x3FFFFFFF;
+    if (v < -0x3FFFFFFF) return -0x3FFFFFFF;
+    return (int32)v;
+}
+
+static inline int32 clampi(int32 v, int32 hi)
+{
+    if (v < 0) return 0;
+    if (v > hi) return hi;
+    return v;
+}
+
+// Offset of the start of source row v, and of texel u from there, in a
+// tiled texture.  Adding the two gives the texel.
+static inline int32 tiled_row(const CelMap* m, int32 v)
+{
+    return (((v >> m->tshift) * m->tpitch) << (2 * m->tshift)) |
+           ((v & ((1 << m->tshift) - 1)) << m->tshift);
+}
+
+static inline int32 tiled_col(const CelMap* m, int32 u)
+{
+    return ((u >> m->tshift) << (2 * m->tshift)) | (u & ((1 << m->tshift) - 1));
+}
+
+static inline void* target_pixel(const RasterTarget* rt, int32 x, int32 y)
+{
+    size_t i = (size_t)y * rt->stride + x;
+
+    return rt->rgb555 ? (void*)((uint16*)rt->pixels + i) : (void*)((uint32*)rt->pixels + i);
+}
+
+// Texel i of the source, through the PLUT if the texture is indexed.
+// Indices past the PLUT (TEX_INDEX_CLEAR) are transparent.
+static inline uint32 texel(const CelMap* m, size_t i)
+{
+    uint32 t;
+
+    if (!m->lut)
+        return m->texels[i];
+    t = m->indices[i];
+    return m->lut[t & 31] & -(uint32)(t < 32);
+}
+
+
+/***************************************************************************
+ * Span loops.  dst is the span's first pixel, in the target's format.
+ */
+
+// What a span loop is instantiated for
+#define SPAN_RGB555     1       // Target pixels are RGB555, else RGBA32
+#define SPAN_BLEND      2       // Run the pixel processor (see set_blend())
+
+// Pixel i of the target as RGBA32
+static inline uint32 get(const void* dst, size_t i, int kind)
+{
+    return (kind & SPAN_RGB555) ? raster_rgba32(((const uint16*)dst)[i]) : ((const uint32*)dst)[i];
+}
+
+// The pixel processor on one pixel: t from the cel over old
+static inline uint32 blend1(const CelMap* m, uint32 t, uint32 old)
+{
+    uint32 p = (t & m->p_cel) | (old & m->p_fb);
+    uint32 s = (t & m->s_cel) | (old & m->s_fb) | m->av;
+    uint32 out = 0xFF000000, c;
+    int sh;
+
+    for (sh = 0; sh < 24; sh += 8) {
+        c = ((((p >> sh) & 0xFF) * m->mul >> m->shift) + ((s >> sh) & 0xFF)) >> m->dshift;
+        out |= (c > 0xFF ? 0xFF : c) << sh;
+    }
+    return out;
+}
+
+// Store texel t as pixel i, unless it's transparent and the cel is keyed
+static inline void put(void* dst, size_t i, uint32 t, const CelMap* m, int kind)
+{
+    if (m->keyed && !(t >> 24))
+        return;
+    if (kind & SPAN_BLEND)
+        t = blend1(m, t, get(dst, i, kind));
+    if (kind & SPAN_RGB555)
+        ((uint16*)dst)[i] = raster_rgb555(t);
+    else
+        ((uint32*)dst)[i] = t;
+}
+
+#ifdef RASTER_SSE2
+static inline __m128i clamp4(__m128i v, __m128i hi)
+{
+    __m128i gt;
+
+    v = _mm_andnot_si128(_mm_srai_epi32(v, 31), v);
+    gt = _mm_cmpgt_epi32(v, hi);
+    return _mm_or_si128(_mm_and_si128(gt, hi), _mm_andnot_si128(gt, v));
+}
+
+// Four RGB555 pixels, one per 32-bit lane, to RGBA32
+static inline __m128i widen4(__m128i c)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xFF000000),
+                                     _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x1F)), 19)),
+                        _mm_or_si128(_mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x3E0)), 6),
+                                     _mm_srli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x7C00)), 7)));
+}
+
+// Four RGBA32 pixels with each channel scaled by a level out of 256;
+// levels holds r, g, b, 256 in 16-bit lanes, twice over
+static inline __m128i fade4(__m128i c, __m128i levels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), levels), 8);
+    __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), levels), 8);
+
+    return _mm_packus_epi16(lo, hi);
+}
+
+// Two pixels' channels, widened to 16 bits, through the pixel processor
+static inline __m128i blend2(const CelMap* m, __m128i p, __m128i s)
+{
+    p = _mm_srl_epi16(_mm_mullo_epi16(p, _mm_set1_epi16((short)m->mul)), _mm_cvtsi32_si128(m->shift));
+    return _mm_srl_epi16(_mm_add_epi16(p, s), _mm_cvtsi32_si128(m->dshift));
+}
+
+static inline __m128i blend4(const CelMap* m, __m128i t, __m128i old)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p = _mm_or_si128(_mm_and_si128(t, _mm_set1_epi32((int)m->p_cel)),
+                             _mm_and_si128(old, _mm_set1_epi32((int)m->p_fb)));
+    __m128i s = _mm_or_si128(_mm_or_si128(_mm_and_si128(t, _mm_set1_epi32((int)m->s_cel)),
+                                          _mm_and_si128(old, _mm_set1_epi32((int)m->s_fb))),
+                             _mm_set1_epi32((int)m->av));
+
+    // Saturating pack clamps each channel to 255
+    return _mm_or_si128(_mm_packus_epi16(blend2(m, _mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(s, zero)),
+                                         blend2(m, _mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(s, zero))),
+                        _mm_set1_epi32((int)0xFF000000));
+}
+
+// Pixels i to i + 3 from four texels
+static inline void put4(void* dst, size_t i, __m128i t, const CelMap* m, int kind)
+{
+    __m128i clear = _mm_cmpeq_epi32(_mm_srli_epi32(t, 24), _mm_setzero_si128());
+
+    if (kind & SPAN_RGB555) {
+        const __m128i five = _mm_set1_epi32(0xF8);
+        uint16* p = (uint16*)dst + i;
+        __m128i old = _mm_loadl_epi64((const __m128i*)p);
+        __m128i c;
+
+        if (kind & SPAN_BLEND)
+            t = blend4(m, t, widen4(_mm_unpacklo_epi16(old, _mm_setzero_si128())));
+        c = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(t, five), 7),
+                                      _mm_and_si128(_mm_srli_epi32(t, 6), _mm_set1_epi32(0x3E0))),
+                         _mm_and_si128(_mm_srli_epi32(t, 19), _mm_set1_epi32(0x1F)));
+
+        // Values are at most 0x7FFF, so the saturating pack is exact
+        c = _mm_packs_epi32(c, c);
+        if (m->keyed) {
+            clear = _mm_packs_epi32(clear, clear);
+            c = _mm_or_si128(_mm_and_si128(clear, old), _mm_andnot_si128(clear, c));
+        }
+        _mm_storel_epi64((__m128i*)p, c);
+    } else {
+        uint32* p = (uint32*)dst + i;
+        __m128i old = _mm_loadu_si128((const __m128i*)p);
+
+        if (kind & SPAN_BLEND)
+            t = blend4(m, t, old);
+        if (m->keyed)
+            t = _mm_or_si128(_mm_and_si128(clear, old), _mm_andnot_si128(clear, t));
+        _mm_storeu_si128((__m128i*)p, t);
+    }
+}
+#endif
+
+static inline void span_affine(void* dst, int32 n, const CelMap* m,
+                               int32 u, int32 v, int32 du, int32 dv, int kind)
+{
+    int32 tw = m->tw;
+    int32 umax = m->tw - 1;
+    int32 vmax = m->th - 1;
+    int32 i = 0;
+
+#ifdef RASTER_SSE2
+    if (n >= 4 && m->tw < 32768 && m->th < 32768) {
+        __m128i uu = _mm_setr_epi32(u, u + du, u + 2 * du, u + 3 * du);
+        __m128i vv = _mm_setr_epi32(v, v + dv, v + 2 * dv, v + 3 * dv);
+        const __m128i ustep = _mm_set1_epi32(du * 4);
+        const __m128i vstep = _mm_set1_epi32(dv * 4);
+        const __m128i umaxv = _mm_set1_epi32(umax);
+        const __m128i vmaxv = _mm_set1_epi32(vmax);
+        // (tu | tv << 16) . (1 | tw << 16) == tv * tw + tu
+        const __m128i pitch = _mm_set1_epi32(1 | (tw << 16));
+        int32 idx[4];
+
+        for (; n - i >= 4; i += 4) {
+            __m128i tu = clamp4(_mm_srai_epi32(uu, 16), umaxv);
+            __m128i tv = clamp4(_mm_srai_epi32(vv, 16), vmaxv);
+            __m128i off = _mm_madd_epi16(_mm_or_si128(tu, _mm_slli_epi32(tv, 16)), pitch);
+
+            _mm_storeu_si128((__m128i*)idx, off);
+            put4(dst, i, _mm_setr_epi32((int)texel(m, idx[0]), (int)texel(m, idx[1]),
+                                        (int)texel(m, idx[2]), (int)texel(m, idx[3])), m, kind);
+            uu = _mm_add_epi32(uu, ustep);
+            vv = _mm_add_epi32(vv, vstep);
+        }
+        u = _mm_cvtsi128_si32(uu);
+        v = _mm_cvtsi128_si32(vv);
+    }
+#endif
+
+    for (; i < n; i++, u += du, v += dv)
+        put(dst, i, texel(m, clampi(v >> 16, vmax) * tw + clampi(u >> 16, umax)), m, kind);
+}
+
+static inline void span_affine_tiled(void* dst, int32 n, const CelMap* m,
+                                     int32 u, int32 v, int32 du, int32 dv, int kind)
+{
+    int32 umax = m->tw - 1;
+    int32 vmax = m->th - 1;
+    int32 i = 0;
+
+#ifdef RASTER_SSE2
+    if (n >= 4 && m->tw < 32768 && m->th < 32768 && (m->tpitch << (2 * m->tshift)) < 32768) {
+        __m128i uu = _mm_setr_epi32(u, u + du, u + 2 * du, u + 3 * du);
+        __m128i vv = _mm_setr_epi32(v, v + dv, v + 2 * dv, v + 3 * dv);
+        const __m128i ustep = _mm_set1_epi32(du * 4);
+        const __m128i vstep = _mm_set1_epi32(dv * 4);
+        const __m128i umaxv = _mm_set1_epi32(umax);
+        const __m128i vmaxv = _mm_set1_epi32(vmax);
+        const __m128i shift = _mm_cvtsi32_si128(m->tshift);
+        const __m128i mask = _mm_set1_epi32((1 << m->tshift) - 1);
+        // Tile (tu, tv) . (tile size, tile size * tiles per row) == tile offset
+        const __m128i pitch = _mm_set1_epi32((1 << (2 * m->tshift)) |
+                                             ((m->tpitch << (2 * m->tshift)) << 16));
+        int32 idx[4];
+
+        for (; n - i >= 4; i += 4) {
+            __m128i tu = clamp4(_mm_srai_epi32(uu, 16), umaxv);
+            __m128i tv = clamp4(_mm_srai_epi32(vv, 16), vmaxv);
+            __m128i tiles = _mm_madd_epi16(_mm_or_si128(_mm_srl_epi32(tu, shift),
+                                                        _mm_slli_epi32(_mm_srl_epi32(tv, shift), 16)),
+                                           pitch);
+            __m128i off = _mm_or_si128(_mm_sll_epi32(_mm_and_si128(tv, mask), shift),
+                                       _mm_and_si128(tu, mask));
+
+            _mm_storeu_si128((__m128i*)idx, _mm_or_si128(tiles, off));
+            put4(dst, i, _mm_setr_epi32((int)texel(m, idx[0]), (int)texel(m, idx[1]),
+                                        (int)texel(m, idx[2]), (int)texel(m, idx[3])), m, kind);
+            uu = _mm_add_epi32(uu, ustep);
+            vv = _mm_add_epi32(vv, vstep);
+        }
+        u = _mm_cvtsi128_si32(uu);
+        v = _mm_cvtsi128_si32(vv);
+    }
+#endif
+
+    for (; i < n; i++, u += du, v += dv)
+        put(dst, i, texel(m, tiled_row(m, clampi(v >> 16, vmax)) + tiled_col(m, clampi(u >> 16, umax))),
+            m, kind);
+}
+
+static inline void span_row_tiled(void* dst, int32 n, const CelMap* m, int32 u, int32 du,
+                                  int kind)
+{
+    size_t src = tiled_row(m, m->row);
+    int32 umax = m->tw - 1;
+    int32 i;
+
+    for (i = 0; i < n; i++, u += du)
+        put(dst, i, texel(m, src + tiled_col(m, clampi(u >> 16, umax))), m, kind);
+}
+
+static inline void span_row(void* dst, int32 n, const CelMap* m, int32 u, int32 du, int kind)
+{
+    size_t src = (size_t)m->row * m->tw;
+    int32 umax = m->tw - 1;
+    int32 i = 0;
+
+#ifdef RASTER_SSE2
+    if (n >= 4) {
+        __m128i uu = _mm_setr_epi32(u, u + du, u + 2 * du, u + 3 * du);
+        const __m128i ustep = _mm_set1_epi32(du * 4);
+        const __m128i umaxv = _mm_set1_epi32(umax);
+        int32 idx[4];
+
+        for (; n - i >= 4; i += 4) {
+            _mm_storeu_si128((__m128i*)idx, clamp4(_mm_srai_epi32(uu, 16), umaxv));
+            put4(dst, i, _mm_setr_epi32((int)texel(m, src + idx[0]), (int)texel(m, src + idx[1]),
+                                        (int)texel(m, src + idx[2]), (int)texel(m, src + idx[3])),
+                 m, kind);
+            uu = _mm_add_epi32(uu, ustep);
+        }
+        u = _mm_cvtsi128_si32(uu);
+    }
+#endif
+
+    for (; i < n; i++, u += du)
+        put(dst, i, texel(m, src + clampi(u >> 16, umax)), m, kind);
+}
+
+
+// One screen column down a single source row
+static inline void span_column(void* dst, int32 stride, int32 n, const CelMap* m, int32 row,
+                               int32 u, int32 du, int kind)
+{
+    int32 umax = m->tw - 1;
+    size_t i;
+
+    if (m->tshift) {
+        size_t src = tiled_row(m, row);
+
+        for (i = 0; n > 0; n--, i += stride, u += du)
+            put(dst, i, texel(m, src + tiled_col(m, clampi(u >> 16, umax))), m, kind);
+    } else {
+        size_t src = (size_t)row * m->tw;
+
+        for (i = 0; n > 0; n--, i += stride, u += du)
+            put(dst, i, texel(m, src + clampi(u >> 16, umax)), m, kind);
+    }
+}
+
+// Each loop is written once and instantiated per target format, with and
+// without the pixel processor, so those tests fold away and opaque cels
+// pay nothing for blending; a cel picks its set when it is set up.
+typedef struct SpanFuncs {
+    void (*affine)(void*, int32, const CelMap*, int32, int32, int32, int32);
+    void (*affine_tiled)(void*, int32, const CelMap*, int32, int32, int32, int32);
+    void (*row)(void*, int32, const CelMap*, int32, int32);
+    void (*row_tiled)(void*, int32, const CelMap*, int32, int32);
+    void (*column)(void*, int32, int32, const CelMap*, int32, int32, int32);
+} SpanFuncs;
+
+#define SPAN_KINDS(fmt, kind)                                                           \
+    static void affine_##fmt(void* d, int32 n, const CelMap* m, int32 u, int32 v,      \
+                             int32 du, int32 dv)                                        \
+    { span_affine(d, n, m, u, v, du, dv, kind); }                                       \
+    static void affine_tiled_##fmt(void* d, int32 n, const CelMap* m, int32 u, int32 v,\
+                                   int32 du, int32 dv)                                  \
+    { span_affine_tiled(d, n, m, u, v, du, dv, kind); }                                 \
+    static void row_##fmt(void* d, int32 n, const CelMap* m, int32 u, int32 du)        \
+    { span_row(d, n, m, u, du, kind); }                                                 \
+    static void row_tiled_##fmt(void* d, int32 n, const CelMap* m, int32 u, int32 du)  \
+    { span_row_tiled(d, n, m, u, du, kind); }                                           \
+    static void column_##fmt(void* d, int32 s, int32 n, const CelMap* m, int32 r,      \
+                             int32 u, int32 du)                                         \
+    { span_column(d, s, n, m, r, u, du, kind); }                                        \
+    static const SpanFuncs spans_##fmt = {                                              \
+        affine_##fmt, affine_tiled_##fmt, row_##fmt, row_tiled_##fmt, column_##fmt     \
+    };
+
+SPAN_KINDS(rgba32, 0)
+SPAN_KINDS(rgb555, SPAN_RGB555)
+SPAN_KINDS(rgba32_blend, SPAN_BLEND)
+SPAN_KINDS(rgb555_blend, SPAN_RGB555 | SPAN_BLEND)
+
+
+// n pixels of one color c, already in the target's format.  The bulk
+// goes out in aligned 16-byte stores, around the cache if stream is set
+// (the caller fences when it's done).
+static void fill_span(void* dst, int32 n, uint32 c, int rgb555, int stream)
+{
+    if (rgb555) {
+        uint16* d = (uint16*)dst;
+
+#ifdef RASTER_SSE2
+        const __m128i v = _mm_set1_epi16((short)c);
+
+        for (; n > 0 && ((uintptr_t)d & 15); n--)
+            *d++ = (uint16)c;
+        if (stream) {
+            for (; n >= 8; n -= 8, d += 8)
+                _mm_stream_si128((__m128i*)d, v);
+        } else {
+            for (; n >= 8; n -= 8, d += 8)
+                _mm_store_si128((__m128i*)d, v);
+        }
+#endif
+        while (n-- > 0)
+            *d++ = (uint16)c;
+    } else {
+        uint32* d = (uint32*)dst;
+
+#ifdef RASTER_SSE2
+        const __m128i v = _mm_set1_epi32((int)c);
+
+        for (; n > 0 && ((uintptr_t)d & 15); n--)
+            *d++ = c;
+        if (stream) {
+            for (; n >= 4; n -= 4, d += 4)
+                _mm_stream_si128((__m128i*)d, v);
+        } else {
+            for (; n >= 4; n -= 4, d += 4)
+                _mm_store_si128((__m128i*)d, v);
+        }
+#endif
+        while (n-- > 0)
+            *d++ = c;
+    }
+    (void)stream;
+}
+
+static int stream_fills(const RasterTarget* rt)
+{
+    return (size_t)rt->stride * rt->height * (rt->rgb555 ? 2 : 4) > STREAM_BYTES;
+}
+
+static void fill_fence(int stream)
+{
+#ifdef RASTER_SSE2
+    if (stream)
+        _mm_sfence();
+#endif
+    (void)stream;
+}
+
+// Does every row of the source hold a single color?  Only asked of very
+// narrow linear textures, which it takes a handful of reads to answer.
+static int flat_rows(const CelMap* m)
+{
+    int32 u, v;
+
+    if (m->tw > FLAT_MAX_WIDTH || m->tshift)
+        return 0;
+    for (v = 0; v < m->th; v++) {
+        size_t row = (size_t)v * m->tw;
+
+        for (u = 1; u < m->tw; u++) {
+            if (texel(m, row + u) != texel(m, row))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+
+/***************************************************************************
+ * Quad scan conversion.
+ */
+static int setup_edge(QuadEdge* e, int64 x0, int64 y0, int64 x1, int64 y1, int32 ys)
+{
+    int64 t;
+
+    if (y0 == y1)
+        return 0;
+    if (y0 > y1) {
+        t = x0;  x0 = x1;  x1 = t;
+        t = y0;  y0 = y1;  y1 = t;
+    }
+
+    e->y_first = center_ceil(y0);
+    e->y_end = center_ceil(y1);
+    if (e->y_first >= e->y_end || e->y_end <= ys)
+        return 0;
+
+    e->dxdy = ((x1 - x0) * FIX_ONE) / (y1 - y0);
+    e->x = x0 + (((((int64)e->y_first << 16) + FIX_HALF - y0) * e->dxdy) >> 16);
+
+    // Skipping ahead in whole steps keeps x identical to what stepping
+    // from y_first would have produced, whatever the clip window.
+    if (e->y_first < ys) {
+        e->x += (int64)(ys - e->y_first) * e->dxdy;
+        e->y_first = ys;
+    }
+    return 1;
+}
+
+static void scan_quad(const RasterTarget* rt, const int64 qx[4], const int64 qy[4],
+                      const CelMap* m)
+{
+    QuadEdge edges[4];
+    int64 ymin, ymax;
+    int32 ys, ye, y;
+    int i, n, stream = m->flat && stream_fills(rt);
+
+    ymin = ymax = qy[0];
+    for (i = 1; i < 4; i++) {
+        if (qy[i] < ymin) ymin = qy[i];
+        if (qy[i] > ymax) ymax = qy[i];
+    }
+
+    ys = center_ceil(ymin);
+    ye = center_ceil(ymax);
+    if (ys < rt->clip_top) ys = rt->clip_top;
+    if (ye > rt->clip_bottom) ye = rt->clip_bottom;
+    if (ys >= ye)
+        return;
+
+    for (i = n = 0; i < 4; i++)
+        n += setup_edge(&edges[n], qx[i], qy[i], qx[(i + 1) & 3], qy[(i + 1) & 3], ys);
+    if (n < 2)
+        return;
+
+    for (y = ys; y < ye; y++) {
+        int64 xl = INT64_MAX, xr = INT64_MIN;
+        int32 x0, x1;
+
+        for (i = 0; i < n; i++) {
+            QuadEdge* e = &edges[i];
+
+            if (y < e->y_first || y >= e->y_end)
+                continue;
+            if (e->x < xl) xl = e->x;
+            if (e->x > xr) xr = e->x;
+            e->x += e->dxdy;
+        }
+        if (xl >= xr)
+            continue;
+
+        x0 = center_ceil(xl);
+        x1 = center_ceil(xr);
+        if (x0 < 0) x0 = 0;
+        if (x1 > rt->width) x1 = rt->width;
+        if (x0 >= x1)
+            continue;
+
+        {
+            void* dst = target_pixel(rt, x0, y);
+            int32 u = narrow(m->u00 + y * m->dudy + x0 * m->dudx);
+
+            if (m->flat) {
+                // v doesn't change along the span, and neither does the
+                // color whatever u is
+                int32 v = narrow(m->v00 + y * m->dvdy + x0 * m->dvdx);
+                uint32 t = texel(m, (size_t)clampi(v >> 16, m->th - 1) * m->tw);
+
+                if (!m->keyed || (t >> 24))
+                    fill_span(dst, x1 - x0, rt->rgb555 ? raster_rgb555(t) : t, rt->rgb555, stream);
+            } else if (m->row >= 0) {
+                if (m->tshift)
+                    m->spans->row_tiled(dst, x1 - x0, m, u, narrow(m->dudx));
+                else
+                    m->spans->row(dst, x1 - x0, m, u, narrow(m->dudx));
+            } else {
+                int32 v = narrow(m->v00 + y * m->dvdy + x0 * m->dvdx);
+
+                if (m->tshift)
+                    m->spans->affine_tiled(dst, x1 - x0, m, u, v, narrow(m->dudx), narrow(m->dvdx));
+                else
+                    m->spans->affine(dst, x1 - x0, m, u, v, narrow(m->dudx), narrow(m->dvdx));
+            }
+        }
+    }
+    fill_fence(stream);
+}
+
+// Point the map at a texture.  Indexed textures are read through lut.
+static void set_texture(CelMap* m, const PlatformTexture* tex, const uint32* lut)
+{
+    if (tex->format == TEXFMT_INDEX8) {
+        m->texels = NULL;
+        m->indices = (const ubyte*)tex->data;
+        m->lut = lut;
+    } else {
+        m->texels = (const uint32*)tex->data;
+        m->indices = NULL;
+        m->lut = NULL;
+    }
+    m->tw = tex->width;
+    m->th = tex->height;
+    m->tshift = tex->tile_shift;
+    m->tpitch = m->tshift ? (m->tw + (1 << m->tshift) - 1) >> m->tshift : 0;
+}
+
+/*
+ * Wall cels are stored transposed: H runs straight down the screen and
+ * each source row becomes a strip of screen columns, so the left and right
+ * edges are vertical and the top and bottom edges are straight lines.
+ * Drawn a column at a time, each column is one run down one source row,
+ * set up with a single divide, instead of a stack of thin row quads.
+ * The column's run and u only depend on the column, so any clip window
+ * gives the same pixels.
+ */
+static void column_wall(const RasterTarget* rt, const CelMap* m, double px, double py,
+                        double hy, double vx, double vy, double hddy)
+{
+    double xa = px, xb = px + m->th * vx;
+    int32 xs, xe, x;
+
+    if (xa > xb) {
+        double t = xa;
+        xa = xb;
+        xb = t;
+    }
+    xs = center_ceil(to_coord(xa));
+    xe = center_ceil(to_coord(xb));
+    if (xs < 0) xs = 0;
+    if (xe > rt->width) xe = rt->width;
+
+    for (x = xs; x < xe; x++) {
+        double r = (x + 0.5 - px) / vx;     // Source row under this column
+        double top = py + r * vy;
+        double step = hy + r * hddy;        // Screen pixels per texel
+        double bottom = top + m->tw * step;
+        int32 ys, ye;
+        int64 u, du;
+
+        if (step > -1e-9 && step < 1e-9)
+            continue;
+        if (step > 0) {
+            ys = center_ceil(to_coord(top));
+            ye = center_ceil(to_coord(bottom));
+        } else {
+            ys = center_ceil(to_coord(bottom));
+            ye = center_ceil(to_coord(top));
+        }
+        if (ys >= ye)
+            continue;
+
+        du = to_fix(1.0 / step);
+        u = to_fix((ys + 0.5 - top) / step);
+        if (ys < rt->clip_top) {
+            u += (int64)(rt->clip_top - ys) * du;
+            ys = rt->clip_top;
+        }
+        if (ye > rt->clip_bottom) ye = rt->clip_bottom;
+        if (ys >= ye)
+            continue;
+
+        m->spans->column(target_pixel(rt, x, ys), rt->stride, ye - ys, m,
+                    clampi((int32)r, m->th - 1), narrow(u), narrow(du));
+    }
+}
+
+/*
+ * Set up the pixel processor from the cel's PIXC, if it loads one.
+ * Every pixel uses the P-mode 0 word, and the multiplier always comes
+ * from the word itself.  Returns 0 if the word leaves the cel's pixels as
+ * they are, so the cel can take the opaque loops.
+ */
+static int set_blend(CelMap* m, uint32 pixc, uint32 flags)
+{
+    uint32 ppmp = (pixc >> PPMP_0_SHIFT) & 0xFFFF;
+    uint32 second = ppmp & PPMPC_2S_MASK;
+
+    if (!(flags & CCB_LDPPMP))
+        return 0;
+
+    m->mul = ((ppmp & PPMPC_MF_MASK) >> PPMPC_MF_SHIFT) + 1;
+    m->shift = (ppmp & PPMPC_SF_MASK) >> PPMPC_SF_SHIFT;
+    if (!m->shift)
+        m->shift = 4;
+    m->dshift = ppmp & PPMPC_2D_MASK;
+    if (!(ppmp & PPMPC_1S_CFBD) && second == PPMPC_2S_0 && m->mul == 1 << m->shift && !m->dshift)
+        return 0;
+
+    m->p_cel = (ppmp & PPMPC_1S_CFBD) ? 0 : 0xFFFFFFFF;
+    m->p_fb = ~m->p_cel;
+    m->s_cel = second == PPMPC_2S_PDC ? 0xFFFFFFFF : 0;
+    m->s_fb = second == PPMPC_2S_CFBD ? 0xFFFFFFFF : 0;
+    m->av = second == PPMPC_2S_CCB ? (((ppmp & PPMPC_AV_MASK) >> PPMPC_AV_SHIFT) << 3) * 0x010101 : 0;
+    return 1;
+}
+
+// Build the inverse of the mapping  p = o + u * a + v * b
+static int setup_map(CelMap* m, double ox, double oy, double ax, double ay,
+                     double bx, double by, double u0, double v0)
+{
+    double det = ax * by - ay * bx;
+    double dudx, dudy, dvdx, dvdy, cx, cy;
+
+    if (det > -1e-12 && det < 1e-12)
+        return 0;
+
+    dudx = by / det;
+    dudy = -bx / det;
+    dvdx = -ay / det;
+    dvdy = ax / det;
+
+    cx = 0.5 - ox;
+    cy = 0.5 - oy;
+    m->u00 = to_fix(u0 + cx * dudx + cy * dudy);
+    m->v00 = to_fix(v0 + cx * dvdx + cy * dvdy);
+    m->dudx = to_fix(dudx);
+    m->dudy = to_fix(dudy);
+    m->dvdx = to_fix(dvdx);
+    m->dvdy = to_fix(dvdy);
+    return 1;
+}
+
+
+// A cel's 32-entry RGB555 PLUT expanded for indexed textures, kept for
+// as long as the cels being drawn keep pointing at the same PLUT.  A
+// zero entry is transparent, like an all-zero pixel out of the 3DO's PLUT.
+typedef struct LutCache {
+    const void* plut;       // What lut was expanded from, or NULL
+    uint32 lut[32];
+} LutCache;
+
+static const uint32* cached_lut(LutCache* cache, const void* plut)
+{
+    const uint16* p = (const uint16*)plut;
+    int i;
+
+    if (cache->plut != plut) {
+        for (i = 0; i < 32; i++)
+            cache->lut[i] = p[i] ? raster_rgba32(p[i]) : 0;
+        cache->plut = plut;
+    }
+    return cache->lut;
+}
+
+
+/***************************************************************************
+ * Entry points.
+ */
+void raster_target_from_bitmap(RasterTarget* rt, Bitmap* bitmap)
+{
+    rt->rgb555 = bitmap->bm_Format == BMF_RGB555;
+    rt->pixels = bitmap->bm_Buffer;
+    rt->width = bitmap->bm_Width;
+    rt->height = bitmap->bm_Height;
+    rt->stride = bitmap->bm_BytesPerRow / (rt->rgb555 ? 2 : 4);
+    rt->clip_top = 0;
+    rt->clip_bottom = bitmap->bm_Height;
+    rt->scale = 1;
+    rt->column_walls = 0;
+}
+
+void raster_rgb555_to_rgba32(uint32* dst, const uint16* src, size_t n)
+{
+    size_t i = 0;
+
+#ifdef RASTER_SSE2
+    for (; n - i >= 8; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+
+        _mm_storeu_si128((__m128i*)(dst + i), widen4(_mm_unpacklo_epi16(c, _mm_setzero_si128())));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), widen4(_mm_unpackhi_epi16(c, _mm_setzero_si128())));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = raster_rgba32(src[i]);
+}
+
+void raster_fill_rows(const RasterTarget* rt, int32 top, const uint32* colors, int32 nrows)
+{
+    int32 y = top > rt->clip_top ? top : rt->clip_top;
+    int32 end = top + nrows < rt->clip_bottom ? top + nrows : rt->clip_bottom;
+    int stream = stream_fills(rt);
+
+    for (; y < end; y++) {
+        uint32 c = colors[y - top];
+
+        fill_span(target_pixel(rt, 0, y), rt->width, rt->rgb555 ? raster_rgb555(c) : c,
+                  rt->rgb555, stream);
+    }
+    fill_fence(stream);
+}
+
+void raster_overlay(void* dst, const void* src, size_t n, int rgb555)
+{
+    size_t i = 0;
+
+    if (rgb555) {
+        uint16* d = (uint16*)dst;
+        const uint16* s = (const uint16*)src;
+
+#ifdef RASTER_SSE2
+        for (; n - i >= 8; i += 8) {
+            __m128i c = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i keep = _mm_cmpeq_epi16(c, _mm_setzero_si128());
+            __m128i old = _mm_loadu_si128((const __m128i*)(d + i));
+
+            _mm_storeu_si128((__m128i*)(d + i),
+                             _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, c)));
+        }
+#endif
+        for (; i < n; i++) {
+            if (s[i])
+                d[i] = s[i];
+        }
+    } else {
+        uint32* d = (uint32*)dst;
+        const uint32* s = (const uint32*)src;
+
+#ifdef RASTER_SSE2
+        for (; n - i >= 4; i += 4) {
+            __m128i c = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i keep = _mm_cmpeq_epi32(_mm_srli_epi32(c, 24), _mm_setzero_si128());
+            __m128i old = _mm_loadu_si128((const __m128i*)(d + i));
+
+            _mm_storeu_si128((__m128i*)(d + i),
+                             _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, c)));
+        }
+#endif
+        for (; i < n; i++) {
+            if (s[i] >> 24)
+                d[i] = s[i];
+        }
+    }
+}
+
+int raster_diff_box(const void* frame, size_t frame_pitch, void* copy, size_t copy_pitch,
+                    int bpp, int32 box[4])
+{
+    int32 left = box[2], top = box[3], right = box[0], bottom = box[1];
+    int32 y;
+
+    for (y = box[1]; y < box[3]; y++) {
+        const ubyte* a = (const ubyte*)frame + (size_t)y * frame_pitch;
+        ubyte* b = (ubyte*)copy + (size_t)y * copy_pitch;
+        size_t l = (size_t)box[0] * bpp, r = (size_t)box[2] * bpp;
+
+        if (l >= r || memcmp(a + l, b + l, r - l) == 0)
+            continue;
+
+        // memcmp() found a difference; close in on it from both ends
+        while (a[l] == b[l])
+            l++;
+        while (a[r - 1] == b[r - 1])
+            r--;
+        l -= l % bpp;
+        r += (bpp - r % bpp) % bpp;
+        memcpy(b + l, a + l, r - l);
+
+        if ((int32)(l / bpp) < left) left = (int32)(l / bpp);
+        if ((int32)(r / bpp) > right) right = (int32)(r / bpp);
+        if (y < top) top = y;
+        bottom = y + 1;
+    }
+
+    if (left >= right) {
+        box[0] = box[1] = box[2] = box[3] = 0;
+        return 0;
+    }
+    box[0] = left;
+    box[1] = top;
+    box[2] = right;
+    box[3] = bottom;
+    return 1;
+}
+
+static inline uint32 fade_pixel(uint32 c, int32 r, int32 g, int32 b)
+{
+    return (c & 0xFF000000) | ((((c >> 16) & 0xFF) * b >> 8) << 16) |
+           ((((c >> 8) & 0xFF) * g >> 8) << 8) | ((c & 0xFF) * r >> 8);
+}
+
+void raster_fade_rgba32(uint32* dst, const uint32* src, size_t n, int32 r, int32 g, int32 b)
+{
+    size_t i = 0;
+
+#ifdef RASTER_SSE2
+    const __m128i levels = _mm_set_epi16(256, (short)b, (short)g, (short)r,
+                                         256, (short)b, (short)g, (short)r);
+
+    for (; n - i >= 4; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+
+        _mm_storeu_si128((__m128i*)(dst + i), fade4(c, levels));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = fade_pixel(src[i], r, g, b);
+}
+
+void raster_fade_rgb555_to_rgba32(uint32* dst, const uint16* src, size_t n,
+                                  int32 r, int32 g, int32 b)
+{
+    size_t i = 0;
+
+#ifdef RASTER_SSE2
+    const __m128i levels = _mm_set_epi16(256, (short)b, (short)g, (short)r,
+                                         256, (short)b, (short)g, (short)r);
+
+    for (; n - i >= 8; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         fade4(widen4(_mm_unpacklo_epi16(c, _mm_setzero_si128())), levels));
+        _mm_storeu_si128((__m128i*)(dst + i + 4),
+                         fade4(widen4(_mm_unpackhi_epi16(c, _mm_setzero_si128())), levels));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = fade_pixel(raster_rgba32(src[i]), r, g, b);
+}
+
+int raster_tile_texture(PlatformTexture* tex, int tile_shift)
+{
+    const ubyte* src = (const ubyte*)tex->data;
+    size_t bpt = tex->format == TEXFMT_INDEX8 ? 1 : sizeof(uint32);
+    ubyte* dst;
+    int32 size, pitch, rows, u, v;
+    CelMap m;
+
+    if (tile_shift < 0 || tile_shift > RASTER_MAX_TILE_SHIFT)
+        return 0;
+    if (!tile_shift || tex->tile_shift || !src || tex->width <= 0 || tex->height <= 0)
+        return tile_shift == tex->tile_shift;
+
+    // Edge tiles are padded out to full size
+    size = 1 << tile_shift;
+    pitch = (tex->width + size - 1) >> tile_shift;
+    rows = (tex->height + size - 1) >> tile_shift;
+    dst = (ubyte*)calloc((size_t)pitch * rows << (2 * tile_shift), bpt);
+    if (!dst)
+        return 0;
+    if (bpt == 1)
+        memset(dst, TEX_INDEX_CLEAR, (size_t)pitch * rows << (2 * tile_shift));
+
+    m.tshift = tile_shift;
+    m.tpitch = pitch;
+    for (v = 0; v < tex->height; v++) {
+        ubyte* row = dst + tiled_row(&m, v) * bpt;
+
+        for (u = 0; u < tex->width; u++, src += bpt)
+            memcpy(row + tiled_col(&m, u) * bpt, src, bpt);
+    }
+
+    free(tex->data);
+    tex->data = dst;
+    tex->tile_shift = tile_shift;
+    return 1;
+}
+
+static size_t texel_offset(const CelMap* m, int32 x, int32 y)
+{
+    return m->tshift ? (size_t)(tiled_row(m, y) + tiled_col(m, x)) : (size_t)y * m->tw + x;
+}
+
+// Average a 2x2 block (clipped to the texture) of opaque texels.  The
+// result is opaque if at least half the block was, so silhouettes keep
+// their size from level to level.
+static uint32 box_filter(const CelMap* m, int32 x, int32 y)
+{
+    uint32 r = 0, g = 0, b = 0, t;
+    int32 n = 0, total = 0, dx, dy;
+
+    for (dy = 0; dy < 2 && y + dy < m->th; dy++) {
+        for (dx = 0; dx < 2 && x + dx < m->tw; dx++) {
+            t = m->texels[texel_offset(m, x + dx, y + dy)];
+            total++;
+            if (!(t >> 24))
+                continue;
+            r += t & 0xFF;
+            g += (t >> 8) & 0xFF;
+            b += (t >> 16) & 0xFF;
+            n++;
+        }
+    }
+    if (!n || n * 2 < total)
+        return 0;
+    return 0xFF000000 | ((b / n) << 16) | ((g / n) << 8) | (r / n);
+}
+
+// Indices can't be averaged without the PLUT, so an indexed level takes
+// the first opaque index of the block, under the same coverage rule.
+static ubyte index_filter(const CelMap* m, int32 x, int32 y)
+{
+    ubyte first = TEX_INDEX_CLEAR, t;
+    int32 n = 0, total = 0, dx, dy;
+
+    for (dy = 0; dy < 2 && y + dy < m->th; dy++) {
+        for (dx = 0; dx < 2 && x + dx < m->tw; dx++) {
+            t = m->indices[texel_offset(m, x + dx, y + dy)];
+            total++;
+            if (t == TEX_INDEX_CLEAR)
+                continue;
+            if (!n++)
+                first = t;
+        }
+    }
+    return n * 2 < total ? TEX_INDEX_CLEAR : first;
+}
+
+int raster_build_mips(PlatformTexture* tex)
+{
+    PlatformTexture* level = tex;
+    size_t bpt = tex->format == TEXFMT_INDEX8 ? 1 : sizeof(uint32);
+    int levels = 0;
+
+    if (tex->mip || !tex->data)
+        return 0;
+
+    while (level->width > 1 && level->height > 1) {
+        PlatformTexture* mip;
+        void* data;
+        CelMap m;
+        int32 x, y, i = 0;
+
+        if (!(mip = (PlatformTexture*)malloc(sizeof(*mip))))
+            break;
+        *mip = *level;
+        mip->width = (level->width + 1) >> 1;
+        mip->height = (level->height + 1) >> 1;
+        mip->tile_shift = 0;
+        mip->mip = NULL;
+        if (!(data = malloc((size_t)mip->width * mip->height * bpt))) {
+            free(mip);
+            break;
+        }
+        mip->data = data;
+
+        set_texture(&m, level, NULL);
+        for (y = 0; y < level->height; y += 2) {
+            for (x = 0; x < level->width; x += 2, i++) {
+                if (bpt == 1)
+                    ((ubyte*)data)[i] = index_filter(&m, x, y);
+                else
+                    ((uint32*)data)[i] = box_filter(&m, x, y);
+            }
+        }
+
+        // Levels share the top level's layout
+        raster_tile_texture(mip, level->tile_shift);
+        level->mip = mip;
+        level = mip;
+        levels++;
+    }
+    return levels;
+}
+
+// Draw one cel from its fields: XPos and YPos in pos, and HDX, HDY, VDX,
+// VDY, HDDX and HDDY in delta, as a draw list keeps them.  Indexed
+// textures are looked up through plut, expanded by way of luts.
+static int draw_cel(const RasterTarget* rt, const PlatformTexture* tex, const void* plut,
+                    LutCache* luts, const frac16* pos, const frac16* delta, uint32 pixc,
+                    uint32 flags)
+{
+    const uint32* lut = NULL;
+    CelMap m;
+    double px, py, hx, hy, vx, vy, hddx, hddy, det;
+    int64 qx[4], qy[4];
+    int32 w, h, r;
+    int blend;
+
+    w = tex->width;
+    h = tex->height;
+
+    px = pos[0] / 65536.0;
+    py = pos[1] / 65536.0;
+    hx = delta[0] / 1048576.0;
+    hy = delta[1] / 1048576.0;
+    vx = delta[2] / 65536.0;
+    vy = delta[3] / 65536.0;
+    hddx = delta[4] / 1048576.0;
+    hddy = delta[5] / 1048576.0;
+
+    if (!delta[0] && !delta[1] && !delta[2] && !delta[3]) {
+        // Never mapped; draw it 1:1 like the old blitter did.
+        hx = vy = 1.0;
+    }
+
+    if (rt->scale > 1) {
+        double s = rt->scale;
+
+        px *= s;    py *= s;
+        hx *= s;    hy *= s;
+        vx *= s;    vy *= s;
+        hddx *= s;  hddy *= s;
+    }
+
+    // Winding test.  An unrotated cel (H right, V down) is clockwise.
+    det = hx * vy - hy * vx;
+    if (flags & (CCB_ACW | CCB_ACCW)) {
+        if (det > 0 && !(flags & CCB_ACW))
+            return 0;
+        if (det < 0 && !(flags & CCB_ACCW))
+            return 0;
+    }
+
+    // Cheap reject for cels that miss the clip window entirely (the
+    // common case when each band of a frame is drawn separately).  The
+    // row quads of a bilinear cel all lie within its corners' bounds.
+    {
+        double cy[4], ymin, ymax;
+        int i;
+
+        cy[0] = py;
+        cy[1] = py + w * hy;
+        cy[2] = py + w * (hy + h * hddy) + h * vy;
+        cy[3] = py + h * vy;
+        ymin = ymax = cy[0];
+        for (i = 1; i < 4; i++) {
+            if (cy[i] < ymin) ymin = cy[i];
+            if (cy[i] > ymax) ymax = cy[i];
+        }
+        if (center_ceil(to_coord(ymax)) <= rt->clip_top ||
+            center_ceil(to_coord(ymin)) >= rt->clip_bottom)
+            return 0;
+    }
+
+    if (tex->format == TEXFMT_INDEX8) {
+        if (!plut)
+            return 0;
+        lut = cached_lut(luts, plut);
+    }
+    set_texture(&m, tex, lut);
+    m.keyed = !(flags & CCB_BGND);
+    m.flat = 0;
+    if ((blend = set_blend(&m, pixc, flags)))
+        m.spans = rt->rgb555 ? &spans_rgb555_blend : &spans_rgba32_blend;
+    else
+        m.spans = rt->rgb555 ? &spans_rgb555 : &spans_rgba32;
+
+    if (rt->column_walls && !delta[0] && !delta[4] && delta[2]) {
+        column_wall(rt, &m, px, py, hy, vx, vy, hddy);
+        return 1;
+    }
+
+    if ((hddx < 0 ? -hddx : hddx) + (hddy < 0 ? -hddy : hddy) < 0.0625 / ((double)w * h)) {
+        // Parallelogram; one quad covers the whole cel.  Drawn smaller
+        // than its texture, it samples the smallest mip level whose
+        // texels still cover no more than a pixel each.
+        while (tex->mip) {
+            double sx = (double)w / tex->mip->width;
+            double sy = (double)h / tex->mip->height;
+
+            if ((det < 0 ? -det : det) * sx * sy > 1.0)
+                break;
+            tex = tex->mip;
+            w = tex->width;
+            h = tex->height;
+            hx *= sx;   hy *= sx;
+            vx *= sy;   vy *= sy;
+            det *= sx * sy;
+            set_texture(&m, tex, lut);
+        }
+
+        if (!setup_map(&m, px, py, hx, hy, vx, vy, 0.0, 0.0))
+            return 0;
+        m.row = -1;
+
+        // Unrotated with one color per row (the backwall): the spans
+        // are plain fills
+        m.flat = !blend && !m.dvdx && flat_rows(&m);
+
+        qx[0] = to_coord(px);                   qy[0] = to_coord(py);
+        qx[1] = to_coord(px + w * hx);          qy[1] = to_coord(py + w * hy);
+        qx[2] = to_coord(px + w * hx + h * vx); qy[2] = to_coord(py + w * hy + h * vy);
+        qx[3] = to_coord(px + h * vx);          qy[3] = to_coord(py + h * vy);
+        scan_quad(rt, qx, qy, &m);
+        return 1;
+    }
+
+    // HDX/HDY change from row to row; draw each source row as its own
+    // quad.  Adjacent rows share their edge exactly, so nothing cracks.
+    for (r = 0; r < h; r++) {
+        double x0 = px + r * vx, y0 = py + r * vy;
+        double x1 = x0 + vx, y1 = y0 + vy;
+        double h0x = hx + r * hddx, h0y = hy + r * hddy;
+        double h1x = h0x + hddx, h1y = h0y + hddy;
+
+        qx[0] = to_coord(x0);
+        qy[0] = to_coord(y0);
+        qx[1] = to_coord(x0 + w * h0x);
+        qy[1] = to_coord(y0 + w * h0y);
+        qx[2] = to_coord(x1 + w * h1x);
+        qy[2] = to_coord(y1 + w * h1y);
+        qx[3] = to_coord(x1);
+        qy[3] = to_coord(y1);
+
+        if (!setup_map(&m, x0, y0, h0x + 0.5 * hddx, h0y + 0.5 * hddy,
+                       vx + 0.5 * w * hddx, vy + 0.5 * w * hddy, 0.0, (double)r))
+            continue;
+        m.row = r;
+        scan_quad(rt, qx, qy, &m);
+    }
+    return 1;
+}
+
+int raster_draw_cel(const RasterTarget* rt, const CCB* ccb)
+{
+    const PlatformTexture* tex;
+    LutCache luts;
+    frac16 pos[2], delta[6];
+
+    if (!rt || !rt->pixels || !ccb)
+        return 0;
+    tex = ccb->platform_texture;
+    if (!tex || !tex->data || tex->width <= 0 || tex->height <= 0)
+        return 0;
+
+    pos[0] = ccb->ccb_XPos;
+    pos[1] = ccb->ccb_YPos;
+    delta[0] = ccb->ccb_HDX;
+    delta[1] = ccb->ccb_HDY;
+    delta[2] = ccb->ccb_VDX;
+    delta[3] = ccb->ccb_VDY;
+    delta[4] = ccb->ccb_HDDX;
+    delta[5] = ccb->ccb_HDDY;
+    luts.plut = NULL;
+    return draw_cel(rt, tex, ccb->ccb_PLUTPtr, &luts, pos, delta, ccb->ccb_PIXC, ccb->ccb_Flags);
+}
+
+int raster_draw_cels(const RasterTarget* rt, const CCB* ccb)
+{
+    int drawn = 0;
+
+    for (; ccb; ccb = ccb->ccb_NextPtr) {
+        if (!(ccb->ccb_Flags & CCB_SKIP))
+            drawn += raster_draw_cel(rt, ccb);
+        if (ccb->ccb_Flags & CCB_LAST)
+            break;
+    }
+    return drawn;
+}
+
+// raster_cel_bounds() from a cel's fields, laid out as for draw_cel()
+static int cel_bounds(const RasterTarget* rt, const PlatformTexture* tex, const frac16* pos,
+                      const frac16* delta, int32 box[4])
+{
+    double px, py, hx, hy, vx, vy, hddx, hddy, s;
+    double cx[4], cy[4], lo[2], hi[2];
+    int32 w, h;
+    int i;
+
+    // The same mapping draw_cel() starts from
+    w = tex->width;
+    h = tex->height;
+    s = rt->scale > 1 ? rt->scale : 1;
+    px = pos[0] / 65536.0 * s;
+    py = pos[1] / 65536.0 * s;
+    hx = delta[0] / 1048576.0 * s;
+    hy = delta[1] / 1048576.0 * s;
+    vx = delta[2] / 65536.0 * s;
+    vy = delta[3] / 65536.0 * s;
+    hddx = delta[4] / 1048576.0 * s;
+    hddy = delta[5] / 1048576.0 * s;
+    if (!delta[0] && !delta[1] && !delta[2] && !delta[3])
+        hx = vy = s;
+
+    // Both edges of a cel with HDDX/HDDY are straight lines through the
+    // rows, so its corners bound it
+    cx[0] = px;
+    cy[0] = py;
+    cx[1] = px + w * hx;
+    cy[1] = py + w * hy;
+    cx[2] = px + w * (hx + h * hddx) + h * vx;
+    cy[2] = py + w * (hy + h * hddy) + h * vy;
+    cx[3] = px + h * vx;
+    cy[3] = py + h * vy;
+    lo[0] = hi[0] = cx[0];
+    lo[1] = hi[1] = cy[0];
+    for (i = 1; i < 4; i++) {
+        if (cx[i] < lo[0]) lo[0] = cx[i];
+        if (cx[i] > hi[0]) hi[0] = cx[i];
+        if (cy[i] < lo[1]) lo[1] = cy[i];
+        if (cy[i] > hi[1]) hi[1] = cy[i];
+    }
+
+    // A pixel of slack for rounding, then clipped to the target
+    for (i = 0; i < 2; i++) {
+        double limit = i ? rt->height : rt->width;
+
+        lo[i] = lo[i] < 1.0 ? 0.0 : lo[i] > limit ? limit : lo[i] - 1.0;
+        hi[i] = hi[i] < 0.0 ? 0.0 : hi[i] + 2.0 > limit ? limit : hi[i] + 2.0;
+        box[i] = (int32)lo[i];
+        box[i + 2] = (int32)hi[i];
+    }
+    return box[0] < box[2] && box[1] < box[3];
+}
+
+int raster_cel_bounds(const RasterTarget* rt, const CCB* ccb, int32 box[4])
+{
+    const PlatformTexture* tex;
+    frac16 pos[2], delta[6];
+
+    if (!rt || !ccb)
+        return 0;
+    tex = ccb->platform_texture;
+    if (!tex || !tex->data || tex->width <= 0 || tex->height <= 0)
+        return 0;
+
+    pos[0] = ccb->ccb_XPos;
+    pos[1] = ccb->ccb_YPos;
+    delta[0] = ccb->ccb_HDX;
+    delta[1] = ccb->ccb_HDY;
+    delta[2] = ccb->ccb_VDX;
+    delta[3] = ccb->ccb_VDY;
+    delta[4] = ccb->ccb_HDDX;
+    delta[5] = ccb->ccb_HDDY;
+    return cel_bounds(rt, tex, pos, delta, box);
+}
+
+
+/***************************************************************************
+ * Draw lists.  The geometry, texture and state of each cel sit in their
+ * own arrays; a band of a frame reads down the rows array alone to find
+ * its cels, and everything else only for the cels it draws.  Those go
+ * straight from the arrays to draw_cel(), the same code a CCB goes
+ * through, so a list draws exactly what its chain would.
+ */
+
+// Room for capacity cels, moving the old entries over.  All the arrays
+// share one block, pointers first so each stays aligned.
+static int list_grow(RasterDrawList* list, int32 capacity)
+{
+    size_t n = (size_t)capacity;
+    ubyte* block;
+    RasterDrawList grown;
+
+    block = (ubyte*)malloc(n * (sizeof(*list->texture) + sizeof(*list->plut) +
+                                sizeof(*list->rows) + sizeof(*list->pos) +
+                                sizeof(*list->delta) + sizeof(*list->pixc) +
+                                sizeof(*list->flags)));
+    if (!block)
+        return 0;
+
+    grown = *list;
+    grown.block = block;
+    grown.capacity = capacity;
+    grown.texture = (const PlatformTexture**)block;
+    grown.plut = (const void**)(grown.texture + n);
+    grown.rows = (int32(*)[2])(grown.plut + n);
+    grown.pos = (frac16(*)[2])(grown.rows + n);
+    grown.delta = (frac16(*)[6])(grown.pos + n);
+    grown.pixc = (uint32*)(grown.delta + n);
+    grown.flags = grown.pixc + n;
+
+    if (list->count) {
+        size_t c = (size_t)list->count;
+
+        memcpy(grown.texture, list->texture, c * sizeof(*list->texture));
+        memcpy(grown.plut, list->plut, c * sizeof(*list->plut));
+        memcpy(grown.rows, list->rows, c * sizeof(*list->rows));
+        memcpy(grown.pos, list->pos, c * sizeof(*list->pos));
+        memcpy(grown.delta, list->delta, c * sizeof(*list->delta));
+        memcpy(grown.pixc, list->pixc, c * sizeof(*list->pixc));
+        memcpy(grown.flags, list->flags, c * sizeof(*list->flags));
+    }
+    free(list->block);
+    *list = grown;
+    return 1;
+}
+
+void raster_list_free(RasterDrawList* list)
+{
+    free(list->block);
+    memset(list, 0, sizeof(*list));
+}
+
+int raster_list_add(RasterDrawList* list, const CCB* ccb)
+{
+    const PlatformTexture* tex = ccb->platform_texture;
+    double py, hy, vy, hddy, cy[4], ymin, ymax;
+    int32 w, h, i;
+
+    if (!tex || !tex->data || tex->width <= 0 || tex->height <= 0)
+        return 0;
+    if (list->count == list->capacity &&
+        !list_grow(list, list->capacity ? list->capacity * 2 : 64))
+        return -1;
+
+    // Rows the cel's corners reach, as draw_cel()'s band test
+    // sees them before scaling, with a row to spare each way for rounding
+    w = tex->width;
+    h = tex->height;
+    py = ccb->ccb_YPos / 65536.0;
+    hy = ccb->ccb_HDY / 1048576.0;
+    vy = ccb->ccb_VDY / 65536.0;
+    hddy = ccb->ccb_HDDY / 1048576.0;
+    if (!ccb->ccb_HDX && !ccb->ccb_HDY && !ccb->ccb_VDX && !ccb->ccb_VDY)
+        vy = 1.0;
+    cy[0] = py;
+    cy[1] = py + w * hy;
+    cy[2] = py + w * (hy + h * hddy) + h * vy;
+    cy[3] = py + h * vy;
+    ymin = ymax = cy[0];
+    for (i = 1; i < 4; i++) {
+        if (cy[i] < ymin) ymin = cy[i];
+        if (cy[i] > ymax) ymax = cy[i];
+    }
+    ymin = ymin < -(1 << 24) ? -(1 << 24) : ymin > (1 << 24) ? (1 << 24) : ymin;
+    ymax = ymax < -(1 << 24) ? -(1 << 24) : ymax > (1 << 24) ? (1 << 24) : ymax;
+
+    i = list->count++;
+    list->texture[i] = tex;
+    list->plut[i] = ccb->ccb_PLUTPtr;
+    list->rows[i][0] = (int32)ymin - 1;
+    list->rows[i][1] = (int32)ymax + 1;
+    list->pos[i][0] = ccb->ccb_XPos;
+    list->pos[i][1] = ccb->ccb_YPos;
+    list->delta[i][0] = ccb->ccb_HDX;
+    list->delta[i][1] = ccb->ccb_HDY;
+    list->delta[i][2] = ccb->ccb_VDX;
+    list->delta[i][3] = ccb->ccb_VDY;
+    list->delta[i][4] = ccb->ccb_HDDX;
+    list->delta[i][5] = ccb->ccb_HDDY;
+    list->pixc[i] = ccb->ccb_PIXC;
+    list->flags[i] = ccb->ccb_Flags & ~CCB_LAST;
+    return 1;
+}
+
+int raster_list_add_cels(RasterDrawList* list, const CCB* ccb)
+{
+    int added = 0;
+
+    for (; ccb; ccb = ccb->ccb_NextPtr) {
+        if (!(ccb->ccb_Flags & CCB_SKIP)) {
+            int r = raster_list_add(list, ccb);
+
+            if (r < 0)
+                return -1;
+            added += r;
+        }
+        if (ccb->ccb_Flags & CCB_LAST)
+            break;
+    }
+    return added;
+}
+
+int raster_draw_list(const RasterTarget* rt, const RasterDrawList* list)
+{
+    int32 s = rt->scale > 1 ? rt->scale : 1;
+    int32 top = rt->clip_top, bottom = rt->clip_bottom;
+    int drawn = 0;
+    LutCache luts;
+    int32 i;
+
+    if (!rt->pixels)
+        return 0;
+
+    // Cels loaded together share a PLUT, so it's mostly expanded once
+    luts.plut = NULL;
+    for (i = 0; i < list->count; i++) {
+        // Can't reach the clip window; draw_cel() would say the same
+        if ((int64)list->rows[i][1] * s <= top || (int64)list->rows[i][0] * s >= bottom)
+            continue;
+        drawn += draw_cel(rt, list->texture[i], list->plut[i], &luts, list->pos[i],
+                          list->delta[i], list->pixc[i], list->flags[i]);
+    }
+    return drawn;
+}
+
+int raster_list_bounds(const RasterTarget* rt, const RasterDrawList* list, int32 i, int32 box[4])
+{
+    if (i < 0 || i >= list->count)
+        return 0;
+    return cel_bounds(rt, list->texture[i], list->pos[i], list->delta[i], box);
+}
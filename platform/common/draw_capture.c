@@ -0,0 +1,472 @@
+/*
+ * draw_capture.c - Recording draw lists and reading them back
+ *
+ * A recording is a header and a run of records, each led by its tag:
+ *
+ *   TEXTURE  id, width, height, format, tile_shift, has_mips, texels
+ *   LIST     target, width, height, rgb555, scale, column_walls, count,
+ *            then per cel: texture id, has_plut, flags, PIXC, XPos, YPos,
+ *            the six deltas and, if it has one, a 32-entry PLUT
+ *   FRAME    (nothing)
+ *
+ * Everything is int32, apart from texels and PLUT entries.
+ */
+
+#include "platform/platform_capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REC_TEXTURE     1
+#define REC_LIST        2
+#define REC_FRAME       3
+
+#define PLUT_ENTRIES    32
+
+// Sanity limits for reading
+#define MAX_DIMENSION   8192
+#define MAX_LIST_CELS   (1 << 20)
+
+// A texture already in the file.  The pointer alone isn't enough to know
+// it again: textures are freed and others allocated in their place when a
+// level is loaded, and a few (the automap, the text runs) are redrawn in
+// place, so the texels are hashed too, once a list.
+typedef struct CapturedTexture {
+    const PlatformTexture* tex;
+    const void* data;
+    int32 width, height, format;
+    uint32 hash;
+    int32 stamp;            // Last list the hash was checked for
+} CapturedTexture;
+
+static FILE* g_file = NULL;
+static int32 g_frames_left = 0;
+static int32 g_stamp = 0;
+static CapturedTexture* g_textures = NULL;
+static int32 g_ntextures = 0;
+static int32 g_texture_space = 0;
+
+// Bytes of texel data, with tiled textures' edge tiles padded out
+static size_t texture_bytes(int32 width, int32 height, int32 format, int32 tile_shift)
+{
+    size_t bpt = format == TEXFMT_INDEX8 ? 1 : sizeof(uint32);
+
+    if (tile_shift) {
+        int32 size = 1 << tile_shift;
+
+        width = (width + size - 1) & ~(size - 1);
+        height = (height + size - 1) & ~(size - 1);
+    }
+    return (size_t)width * height * bpt;
+}
+
+// FNV-1a, a word at a time
+static uint32 texture_hash(const PlatformTexture* tex)
+{
+    size_t n = texture_bytes(tex->width, tex->height, tex->format, tex->tile_shift);
+    const ubyte* p = (const ubyte*)tex->data;
+    uint32 hash = 2166136261u, word;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        memcpy(&word, p + i, 4);
+        hash = (hash ^ word) * 16777619u;
+    }
+    for (; i < n; i++)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static void put_ints(const int32* v, int n)
+{
+    fwrite(v, sizeof(int32), n, g_file);
+}
+
+// The texture's id in the file, writing it out if it's new.  -1 if out
+// of memory.
+static int32 texture_id(const PlatformTexture* tex)
+{
+    CapturedTexture* ct;
+    int32 i, rec[7];
+    uint32 hash;
+
+    // The newest record of a texture is the only one that can match
+    for (i = g_ntextures - 1; i >= 0; i--) {
+        if (g_textures[i].tex == tex)
+            break;
+    }
+    if (i >= 0) {
+        ct = &g_textures[i];
+        if (ct->stamp == g_stamp)
+            return i;
+        hash = texture_hash(tex);
+        if (ct->data == tex->data && ct->width == tex->width && ct->height == tex->height &&
+            ct->format == tex->format && ct->hash == hash) {
+            ct->stamp = g_stamp;
+            return i;
+        }
+    } else {
+        hash = texture_hash(tex);
+    }
+
+    if (g_ntextures == g_texture_space) {
+        int32 space = g_texture_space ? g_texture_space * 2 : 256;
+        CapturedTexture* grown = (CapturedTexture*)realloc(g_textures, space * sizeof(*grown));
+
+        if (!grown)
+            return -1;
+        g_textures = grown;
+        g_texture_space = space;
+    }
+    ct = &g_textures[g_ntextures];
+    ct->tex = tex;
+    ct->data = tex->data;
+    ct->width = tex->width;
+    ct->height = tex->height;
+    ct->format = tex->format;
+    ct->hash = hash;
+    ct->stamp = g_stamp;
+
+    rec[0] = REC_TEXTURE;
+    rec[1] = g_ntextures;
+    rec[2] = tex->width;
+    rec[3] = tex->height;
+    rec[4] = tex->format;
+    rec[5] = tex->tile_shift;
+    rec[6] = tex->mip != NULL;
+    put_ints(rec, 7);
+    fwrite(tex->data, 1, texture_bytes(tex->width, tex->height, tex->format, tex->tile_shift),
+           g_file);
+    return g_ntextures++;
+}
+
+int capture_start(const char* path, int32 frames)
+{
+    int32 version = CAPTURE_VERSION;
+
+    capture_stop();
+    if (frames <= 0)
+        return 0;
+    if (!(g_file = fopen(path, "wb"))) {
+        printf("Can't create capture file %s\n", path);
+        return -1;
+    }
+    fwrite(CAPTURE_MAGIC, 1, 8, g_file);
+    put_ints(&version, 1);
+    g_frames_left = frames;
+    printf("Capturing %d frames of draw lists to %s\n", frames, path);
+    return 0;
+}
+
+int capture_active(void)
+{
+    return g_file != NULL;
+}
+
+void capture_list(const RasterTarget* rt, int32 target, const RasterDrawList* list)
+{
+    int32 rec[8], cel[12];
+    int32 i;
+
+    if (!g_file || !list->count)
+        return;
+
+    // Textures go in ahead of the list that first uses them
+    g_stamp++;
+    for (i = 0; i < list->count; i++) {
+        if (texture_id(list->texture[i]) < 0) {
+            printf("Out of memory capturing draw lists\n");
+            capture_stop();
+            return;
+        }
+    }
+
+    rec[0] = REC_LIST;
+    rec[1] = target;
+    rec[2] = rt->width;
+    rec[3] = rt->height;
+    rec[4] = rt->rgb555;
+    rec[5] = rt->scale;
+    rec[6] = rt->column_walls;
+    rec[7] = list->count;
+    put_ints(rec, 8);
+
+    for (i = 0; i < list->count; i++) {
+        const PlatformTexture* tex = list->texture[i];
+        int has_plut = tex->format == TEXFMT_INDEX8 && list->plut[i];
+
+        cel[0] = texture_id(tex);
+        cel[1] = has_plut;
+        cel[2] = (int32)list->flags[i];
+        cel[3] = (int32)list->pixc[i];
+        cel[4] = list->pos[i][0];
+        cel[5] = list->pos[i][1];
+        memcpy(&cel[6], list->delta[i], 6 * sizeof(int32));
+        put_ints(cel, 12);
+        if (has_plut)
+            fwrite(list->plut[i], sizeof(uint16), PLUT_ENTRIES, g_file);
+    }
+}
+
+void capture_frame(void)
+{
+    int32 rec = REC_FRAME;
+
+    if (!g_file)
+        return;
+    put_ints(&rec, 1);
+    if (--g_frames_left <= 0)
+        capture_stop();
+}
+
+void capture_stop(void)
+{
+    if (g_file) {
+        if (ferror(g_file) | fclose(g_file))
+            printf("Error writing capture file\n");
+        else
+            printf("Capture finished\n");
+        g_file = NULL;
+    }
+    free(g_textures);
+    g_textures = NULL;
+    g_ntextures = g_texture_space = 0;
+    g_frames_left = 0;
+    g_stamp = 0;
+}
+
+
+/***************************************************************************
+ * Reading.  The whole recording is held in memory, so replaying it
+ * measures the rasterizer and not the disk.
+ */
+
+// Grow an array by doubling until it holds need elements
+static int reserve(void** array, int32* space, int32 need, size_t size)
+{
+    void* grown;
+    int32 n;
+
+    if (need <= *space)
+        return 1;
+    for (n = *space ? *space : 64; n < need; n *= 2)
+        ;
+    if (!(grown = realloc(*array, (size_t)n * size)))
+        return 0;
+    *array = grown;
+    *space = n;
+    return 1;
+}
+
+static int get_ints(FILE* file, int32* v, int n)
+{
+    return fread(v, sizeof(int32), n, file) == (size_t)n;
+}
+
+static int read_texture(Capture* cap, FILE* file, int32* space)
+{
+    PlatformTexture* tex;
+    int32 rec[6];
+    size_t bytes;
+
+    if (!get_ints(file, rec, 6))
+        return 0;
+    if (rec[0] != cap->ntextures || rec[1] <= 0 || rec[1] > MAX_DIMENSION || rec[2] <= 0 ||
+        rec[2] > MAX_DIMENSION || (rec[3] != TEXFMT_INDEX8 && rec[3] != TEXFMT_RGBA32) ||
+        rec[4] < 0 || rec[4] > RASTER_MAX_TILE_SHIFT)
+        return 0;
+    if (!reserve((void**)&cap->textures, space, cap->ntextures + 1, sizeof(*cap->textures)))
+        return 0;
+
+    // Each on its own, so the lists' pointers to them stay put
+    if (!(tex = (PlatformTexture*)calloc(1, sizeof(*tex))))
+        return 0;
+    cap->textures[cap->ntextures++] = tex;
+    tex->width = rec[1];
+    tex->height = rec[2];
+    tex->format = rec[3];
+    tex->tile_shift = rec[4];
+    bytes = texture_bytes(tex->width, tex->height, tex->format, tex->tile_shift);
+    if (!(tex->data = malloc(bytes)))
+        return 0;
+    if (fread(tex->data, 1, bytes, file) != bytes)
+        return 0;
+    if (rec[5])
+        raster_build_mips(tex);
+    return 1;
+}
+
+// The target's index, adding it if it's new.  Bitmaps of the same size
+// and format (the two screens, the HUD) stay apart by their ids.
+static int32 find_target(Capture* cap, const int32* rec, int32* space, int32* id_space)
+{
+    RasterTarget* rt;
+    int32 i;
+
+    for (i = 0; i < cap->ntargets; i++) {
+        rt = &cap->targets[i];
+        if (cap->target_ids[i] == rec[0] && rt->width == rec[1] && rt->height == rec[2] &&
+            rt->rgb555 == rec[3] && rt->scale == rec[4] && rt->column_walls == rec[5])
+            return i;
+    }
+    if (!reserve((void**)&cap->targets, space, cap->ntargets + 1, sizeof(*rt)) ||
+        !reserve((void**)&cap->target_ids, id_space, cap->ntargets + 1, sizeof(int32)))
+        return -1;
+
+    cap->target_ids[cap->ntargets] = rec[0];
+
+    rt = &cap->targets[cap->ntargets];
+    memset(rt, 0, sizeof(*rt));
+    rt->width = rec[1];
+    rt->height = rec[2];
+    rt->stride = rec[1];
+    rt->rgb555 = rec[3];
+    rt->scale = rec[4];
+    rt->column_walls = rec[5];
+    rt->clip_bottom = rt->height;
+    return cap->ntargets++;
+}
+
+static int read_list(Capture* cap, FILE* file, int32* space, int32* target_space,
+                     int32* id_space, int32* plut_space)
+{
+    CaptureDraw* draw;
+    int32 rec[7], cel[12];
+    int32 i;
+
+    if (!get_ints(file, rec, 7))
+        return 0;
+    if (rec[1] <= 0 || rec[1] > MAX_DIMENSION || rec[2] <= 0 || rec[2] > MAX_DIMENSION ||
+        rec[4] < 1 || rec[6] < 0 || rec[6] > MAX_LIST_CELS)
+        return 0;
+    if (!reserve((void**)&cap->draws, space, cap->ndraws + 1, sizeof(*draw)))
+        return 0;
+
+    draw = &cap->draws[cap->ndraws];
+    memset(draw, 0, sizeof(*draw));
+    cap->ndraws++;
+    if ((draw->target = find_target(cap, rec, target_space, id_space)) < 0)
+        return 0;
+
+    // PLUTs are numbered from 1 until the pool stops moving
+    for (i = 0; i < rec[6]; i++) {
+        CCB ccb;
+
+        if (!get_ints(file, cel, 12) || cel[0] < 0 || cel[0] >= cap->ntextures)
+            return 0;
+        memset(&ccb, 0, sizeof(ccb));
+        ccb.platform_texture = cap->textures[cel[0]];
+        ccb.ccb_Flags = (uint32)cel[2];
+        ccb.ccb_PIXC = (uint32)cel[3];
+        ccb.ccb_XPos = cel[4];
+        ccb.ccb_YPos = cel[5];
+        ccb.ccb_HDX = cel[6];
+        ccb.ccb_HDY = cel[7];
+        ccb.ccb_VDX = cel[8];
+        ccb.ccb_VDY = cel[9];
+        ccb.ccb_HDDX = cel[10];
+        ccb.ccb_HDDY = cel[11];
+        if (cel[1]) {
+            if (!reserve((void**)&cap->pluts, plut_space, (cap->npluts + 1) * PLUT_ENTRIES,
+                         sizeof(uint16)))
+                return 0;
+            if (fread(cap->pluts + (size_t)cap->npluts * PLUT_ENTRIES, sizeof(uint16),
+                      PLUT_ENTRIES, file) != PLUT_ENTRIES)
+                return 0;
+            ccb.ccb_PLUTPtr = (void*)(size_t)++cap->npluts;
+        }
+        if (raster_list_add(&draw->list, &ccb) < 0)
+            return 0;
+    }
+    return 1;
+}
+
+int capture_load(Capture* cap, const char* path)
+{
+    FILE* file;
+    char magic[8];
+    int32 version, tag, i, j;
+    int32 texture_space = 0, target_space = 0, draw_space = 0, frame_space = 0;
+    int32 id_space = 0, plut_space = 0;
+    int ok = 1;
+
+    memset(cap, 0, sizeof(*cap));
+    if (!(file = fopen(path, "rb"))) {
+        printf("Can't open capture file %s\n", path);
+        return -1;
+    }
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, CAPTURE_MAGIC, 8) != 0 ||
+        !get_ints(file, &version, 1) || version != CAPTURE_VERSION) {
+        printf("%s isn't a capture file this version can read\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    while (ok && get_ints(file, &tag, 1)) {
+        switch (tag) {
+        case REC_TEXTURE:
+            ok = read_texture(cap, file, &texture_space);
+            break;
+        case REC_LIST:
+            ok = read_list(cap, file, &draw_space, &target_space, &id_space, &plut_space);
+            break;
+        case REC_FRAME:
+            ok = reserve((void**)&cap->frame_ends, &frame_space, cap->nframes + 1, sizeof(int32));
+            if (ok)
+                cap->frame_ends[cap->nframes++] = cap->ndraws;
+            break;
+        default:
+            ok = 0;
+            break;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        printf("Capture file %s is damaged or truncated\n", path);
+        capture_free(cap);
+        return -1;
+    }
+
+    // Draws after the last frame ended never made it to the screen
+    for (i = cap->nframes ? cap->frame_ends[cap->nframes - 1] : 0; i < cap->ndraws; i++)
+        raster_list_free(&cap->draws[i].list);
+    cap->ndraws = cap->nframes ? cap->frame_ends[cap->nframes - 1] : 0;
+
+    // Now the PLUT pool has stopped moving, turn offsets into pointers
+    for (i = 0; i < cap->ndraws; i++) {
+        RasterDrawList* list = &cap->draws[i].list;
+
+        for (j = 0; j < list->count; j++) {
+            if (list->plut[j])
+                list->plut[j] = cap->pluts + ((size_t)list->plut[j] - 1) * PLUT_ENTRIES;
+        }
+    }
+    return 0;
+}
+
+void capture_free(Capture* cap)
+{
+    int32 i;
+
+    for (i = 0; i < cap->ntextures; i++) {
+        PlatformTexture* tex = cap->textures[i];
+
+        while (tex) {
+            PlatformTexture* next = tex->mip;
+
+            free(tex->data);
+            free(tex);
+            tex = next;
+        }
+    }
+    for (i = 0; i < cap->ndraws; i++)
+        raster_list_free(&cap->draws[i].list);
+    free(cap->textures);
+    free(cap->targets);
+    free(cap->target_ids);
+    free(cap->draws);
+    free(cap->frame_ends);
+    free(cap->pluts);
+    memset(cap, 0, sizeof(*cap));
+}
@@ -0,0 +1,120 @@
+#include "platform/platform_governor.h"
+
+/*
+ * Dynamic resolution governor
+ * Pixel work grows with the square of the scale, so the cost of the next
+ * step up is predicted from the current average before taking it.
+ */
+
+#define SETTLE_FRAMES   8       // Frames to average after a change before acting
+#define DROP_FRAMES     12      // Consecutive slow frames before stepping down
+#define RAISE_FRAMES    120     // Consecutive roomy frames before stepping up
+#define DROP_MARGIN     1.10    // Step down above target * DROP_MARGIN
+#define RAISE_MARGIN    0.85    // Step up if the prediction is below target * RAISE_MARGIN
+#define SMOOTHING       0.125   // Weight of the newest frame in the average
+
+static int clamp_scale(const ResGovernor* gov, int scale)
+{
+    if (scale < gov->min_scale) scale = gov->min_scale;
+    if (scale > gov->max_scale) scale = gov->max_scale;
+    return scale;
+}
+
+static void change_scale(ResGovernor* gov, int scale)
+{
+    gov->scale = scale;
+    gov->samples = 0;
+    gov->over_frames = 0;
+    gov->under_frames = 0;
+}
+
+void res_governor_init(ResGovernor* gov, int min_scale, int max_scale, int scale,
+                       double target_ms)
+{
+    if (min_scale < 1) min_scale = 1;
+    if (max_scale < min_scale) max_scale = min_scale;
+
+    gov->min_scale = min_scale;
+    gov->max_scale = max_scale;
+    gov->target_ms = target_ms;
+    gov->avg_ms = 0.0;
+    change_scale(gov, clamp_scale(gov, scale));
+}
+
+int res_governor_update(ResGovernor* gov, double frame_ms)
+{
+    double up;
+
+    if (gov->samples++ == 0) {
+        gov->avg_ms = frame_ms;
+    } else {
+        gov->avg_ms += (frame_ms - gov->avg_ms) * SMOOTHING;
+    }
+    if (gov->samples < SETTLE_FRAMES || gov->target_ms <= 0.0) {
+        return gov->scale;
+    }
+
+    // Over budget: count towards a step down
+    if (gov->avg_ms > gov->target_ms * DROP_MARGIN) {
+        gov->under_frames = 0;
+        if (++gov->over_frames >= DROP_FRAMES && gov->scale > gov->min_scale) {
+            change_scale(gov, gov->scale - 1);
+        }
+        return gov->scale;
+    }
+    gov->over_frames = 0;
+
+    // Would the next scale up still fit?
+    up = (double)(gov->scale + 1) / gov->scale;
+    if (gov->scale < gov->max_scale && gov->avg_ms * up * up < gov->target_ms * RAISE_MARGIN) {
+        if (++gov->under_frames >= RAISE_FRAMES) {
+            change_scale(gov, gov->scale + 1);
+        }
+    } else {
+        gov->under_frames = 0;
+    }
+    return gov->scale;
+}
+
+
+/*
+ * Draw distance governor
+ * The band between the two margins is where the distance stays put.
+ * Drawing less comes back faster than drawing more is given out.
+ */
+
+#define DIST_DROP_STEP  0.125   // Cells per frame while over budget
+#define DIST_RAISE_STEP 0.03125 // Cells per frame while well under budget
+#define DIST_RAISE_MARGIN 0.75  // Reach further below target * DIST_RAISE_MARGIN
+
+void dist_governor_init(DistGovernor* gov, double min_dist, double max_dist, double target_ms)
+{
+    if (max_dist < min_dist) max_dist = min_dist;
+
+    gov->min_dist = min_dist;
+    gov->max_dist = max_dist;
+    gov->target_ms = target_ms;
+    gov->avg_ms = 0.0;
+    gov->samples = 0;
+}
+
+double dist_governor_update(DistGovernor* gov, double cost_ms, double dist)
+{
+    if (gov->samples++ == 0) {
+        gov->avg_ms = cost_ms;
+    } else {
+        gov->avg_ms += (cost_ms - gov->avg_ms) * SMOOTHING;
+    }
+
+    if (gov->samples >= SETTLE_FRAMES && gov->target_ms > 0.0) {
+        if (gov->avg_ms > gov->target_ms * DROP_MARGIN) {
+            dist -= DIST_DROP_STEP;
+        } else if (gov->avg_ms < gov->target_ms * DIST_RAISE_MARGIN) {
+            dist += DIST_RAISE_STEP;
+        }
+    }
+
+    if (dist < gov->min_dist) dist = gov->min_dist;
+    if (dist > gov->max_dist) dist = gov->max_dist;
+    return dist;
+}
@@ -0,0 +1,549 @@
+/*
+ * upscale.c - CPU window upscaler
+ *
+ * The integer modes expand each source row once per band and copy it
+ * down for the rest of its output rows, so most of the work is plain
+ * stores.  Sharp bilinear is ordinary bilinear filtering with the
+ * fraction between two texels pushed out towards 0 or 1, so only the
+ * output pixels straddling a texel edge get blended; output rows that
+ * land on the same source rows with the same weight are copies too.
+ *
+ * RGBA32 channels are blended two at a time in 32-bit words (or in 16-bit
+ * SIMD lanes), with weights out of 256.
+ */
+
+#include "platform/platform_upscale.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UPSCALE_SSE2 1
+#endif
+
+// AVX2 is compiled in with a target attribute and only used if the CPU
+// has it
+#if defined(UPSCALE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define UPSCALE_AVX2 1
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UPSCALE_NEON 1
+#endif
+
+#define ALPHA_MASK      0xFF000000
+#define HALF_MASK       0x007F7F7F      // Color bits left after a shift right by one
+
+// Widest frame sharp bilinear takes (the rows it blends live on the stack)
+#define UPSCALE_MAX_WIDTH 2048
+
+typedef struct UpscaleFuncs {
+    // Repeat each of n pixels k times
+    void (*expand)(uint32* dst, const uint32* src, int32 n, int32 k);
+    // Halve the color of n pixels, keeping alpha; dst may be src
+    void (*darken)(uint32* dst, const uint32* src, int32 n);
+    // Blend n pixels of row b into row a, weight w out of 256
+    void (*blend_rows)(uint32* dst, const uint32* a, const uint32* b, int32 n, int32 w);
+    // n output pixels from a row, blending each column's texel pair
+    void (*resample)(uint32* dst, const uint32* row, const int32* cols, const uint16* weights,
+                     int32 n);
+    const char* name;
+} UpscaleFuncs;
+
+static inline uint32 lerp_pixel(uint32 a, uint32 b, uint32 w)
+{
+    uint32 rb = (((a & 0xFF00FF) * (256 - w) + (b & 0xFF00FF) * w) >> 8) & 0xFF00FF;
+    uint32 ag = (((a >> 8) & 0xFF00FF) * (256 - w) + ((b >> 8) & 0xFF00FF) * w) & 0xFF00FF00;
+    return rb | ag;
+}
+
+
+/***************************************************************************
+ * Plain C
+ */
+static void expand_c(uint32* dst, const uint32* src, int32 n, int32 k)
+{
+    int32 i, j;
+
+    for (i = 0; i < n; i++) {
+        uint32 c = src[i];
+        for (j = 0; j < k; j++) *dst++ = c;
+    }
+}
+
+static void darken_c(uint32* dst, const uint32* src, int32 n)
+{
+    int32 i;
+
+    for (i = 0; i < n; i++) dst[i] = ((src[i] >> 1) & HALF_MASK) | (src[i] & ALPHA_MASK);
+}
+
+static void blend_rows_c(uint32* dst, const uint32* a, const uint32* b, int32 n, int32 w)
+{
+    int32 i;
+
+    for (i = 0; i < n; i++) dst[i] = lerp_pixel(a[i], b[i], w);
+}
+
+static void resample_c(uint32* dst, const uint32* row, const int32* cols, const uint16* weights,
+                       int32 n)
+{
+    int32 x;
+
+    for (x = 0; x < n; x++) dst[x] = lerp_pixel(row[cols[x]], row[cols[x] + 1], weights[x]);
+}
+
+static const UpscaleFuncs funcs_c = { expand_c, darken_c, blend_rows_c, resample_c, "C" };
+
+
+/***************************************************************************
+ * SSE2
+ */
+#ifdef UPSCALE_SSE2
+static void expand_sse2(uint32* dst, const uint32* src, int32 n, int32 k)
+{
+    int32 i = 0;
+
+    switch (k) {
+    case 2:
+        for (; i + 4 <= n; i += 4, dst += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(v, v));
+        }
+        break;
+    case 3:
+        for (; i + 4 <= n; i += 4, dst += 12) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+            _mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+        }
+        break;
+    case 4:
+        for (; i + 4 <= n; i += 4, dst += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, 0x00));
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, 0x55));
+            _mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, 0xAA));
+            _mm_storeu_si128((__m128i*)(dst + 12), _mm_shuffle_epi32(v, 0xFF));
+        }
+        break;
+    }
+    expand_c(dst, src + i, n - i, k);
+}
+
+static void darken_sse2(uint32* dst, const uint32* src, int32 n)
+{
+    const __m128i half = _mm_set1_epi32(HALF_MASK);
+    const __m128i alpha = _mm_set1_epi32((int)ALPHA_MASK);
+    int32 i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        v = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 1), half), _mm_and_si128(v, alpha));
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    darken_c(dst + i, src + i, n - i);
+}
+
+// a * (256 - w) + b * w on 16-bit channels; w is in every lane of the
+// pixel it weighs.  Products stay under 65536, so unsigned 16-bit
+// arithmetic is exact.
+static inline __m128i lerp_sse2(__m128i a, __m128i b, __m128i w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(256);
+    __m128i wlo = _mm_unpacklo_epi32(w, w), whi = _mm_unpackhi_epi32(w, w);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(one, wlo)),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wlo));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(one, whi)),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), whi));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+
+// Four weights out of 256, each in both halves of its pixel's lane
+static inline __m128i weights_sse2(const uint16* w)
+{
+    __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)w), _mm_setzero_si128());
+    return _mm_or_si128(v, _mm_slli_epi32(v, 16));
+}
+
+static void blend_rows_sse2(uint32* dst, const uint32* a, const uint32* b, int32 n, int32 w)
+{
+    const __m128i vw = _mm_set1_epi32(w | (w << 16));
+    int32 i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = lerp_sse2(_mm_loadu_si128((const __m128i*)(a + i)),
+                              _mm_loadu_si128((const __m128i*)(b + i)), vw);
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    blend_rows_c(dst + i, a + i, b + i, n - i, w);
+}
+
+static void resample_sse2(uint32* dst, const uint32* row, const int32* cols,
+                          const uint16* weights, int32 n)
+{
+    int32 x = 0;
+
+    // No gather, but the loads are cheap next to the blend
+    for (; x + 4 <= n; x += 4) {
+        const int32* c = cols + x;
+        __m128i a = _mm_setr_epi32(row[c[0]], row[c[1]], row[c[2]], row[c[3]]);
+        __m128i b = _mm_setr_epi32(row[c[0] + 1], row[c[1] + 1], row[c[2] + 1], row[c[3] + 1]);
+        _mm_storeu_si128((__m128i*)(dst + x), lerp_sse2(a, b, weights_sse2(weights + x)));
+    }
+    resample_c(dst + x, row, cols + x, weights + x, n - x);
+}
+
+static const UpscaleFuncs funcs_sse2 = {
+    expand_sse2, darken_sse2, blend_rows_sse2, resample_sse2, "SSE2"
+};
+#endif
+
+
+/***************************************************************************
+ * AVX2
+ */
+#ifdef UPSCALE_AVX2
+AVX2_FUNC static void expand_avx2(uint32* dst, const uint32* src, int32 n, int32 k)
+{
+    int32 i = 0;
+
+    switch (k) {
+    case 2: {
+        const __m256i lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+        const __m256i hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+        for (; i + 8 <= n; i += 8, dst += 16) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(v, lo));
+            _mm256_storeu_si256((__m256i*)(dst + 8), _mm256_permutevar8x32_epi32(v, hi));
+        }
+        break;
+    }
+    case 3: {
+        const __m256i p0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+        const __m256i p1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+        const __m256i p2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+        for (; i + 8 <= n; i += 8, dst += 24) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(v, p0));
+            _mm256_storeu_si256((__m256i*)(dst + 8), _mm256_permutevar8x32_epi32(v, p1));
+            _mm256_storeu_si256((__m256i*)(dst + 16), _mm256_permutevar8x32_epi32(v, p2));
+        }
+        break;
+    }
+    case 4: {
+        const __m256i p0 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+        const __m256i p1 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+        const __m256i p2 = _mm256_setr_epi32(4, 4, 4, 4, 5, 5, 5, 5);
+        const __m256i p3 = _mm256_setr_epi32(6, 6, 6, 6, 7, 7, 7, 7);
+        for (; i + 8 <= n; i += 8, dst += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(v, p0));
+            _mm256_storeu_si256((__m256i*)(dst + 8), _mm256_permutevar8x32_epi32(v, p1));
+            _mm256_storeu_si256((__m256i*)(dst + 16), _mm256_permutevar8x32_epi32(v, p2));
+            _mm256_storeu_si256((__m256i*)(dst + 24), _mm256_permutevar8x32_epi32(v, p3));
+        }
+        break;
+    }
+    }
+    expand_c(dst, src + i, n - i, k);
+}
+
+AVX2_FUNC static void darken_avx2(uint32* dst, const uint32* src, int32 n)
+{
+    const __m256i half = _mm256_set1_epi32(HALF_MASK);
+    const __m256i alpha = _mm256_set1_epi32((int)ALPHA_MASK);
+    int32 i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        v = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(v, 1), half),
+                            _mm256_and_si256(v, alpha));
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    darken_c(dst + i, src + i, n - i);
+}
+
+// As lerp_sse2(), eight pixels at a time
+AVX2_FUNC static inline __m256i lerp_avx2(__m256i a, __m256i b, __m256i w)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(256);
+    __m256i wlo = _mm256_unpacklo_epi32(w, w), whi = _mm256_unpackhi_epi32(w, w);
+    __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_sub_epi16(one, wlo)),
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), wlo));
+    __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_sub_epi16(one, whi)),
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), whi));
+    return _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+}
+
+AVX2_FUNC static void blend_rows_avx2(uint32* dst, const uint32* a, const uint32* b, int32 n,
+                                      int32 w)
+{
+    const __m256i vw = _mm256_set1_epi32(w | (w << 16));
+    int32 i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = lerp_avx2(_mm256_loadu_si256((const __m256i*)(a + i)),
+                              _mm256_loadu_si256((const __m256i*)(b + i)), vw);
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    blend_rows_c(dst + i, a + i, b + i, n - i, w);
+}
+
+AVX2_FUNC static void resample_avx2(uint32* dst, const uint32* row, const int32* cols,
+                                    const uint16* weights, int32 n)
+{
+    int32 x = 0;
+
+    for (; x + 8 <= n; x += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(cols + x));
+        __m256i a = _mm256_i32gather_epi32((const int*)row, c, 4);
+        __m256i b = _mm256_i32gather_epi32((const int*)(row + 1), c, 4);
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(weights + x)));
+        w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+        _mm256_storeu_si256((__m256i*)(dst + x), lerp_avx2(a, b, w));
+    }
+    resample_c(dst + x, row, cols + x, weights + x, n - x);
+}
+
+static const UpscaleFuncs funcs_avx2 = {
+    expand_avx2, darken_avx2, blend_rows_avx2, resample_avx2, "AVX2"
+};
+#endif
+
+
+/***************************************************************************
+ * NEON
+ */
+#ifdef UPSCALE_NEON
+static void expand_neon(uint32* dst, const uint32* src, int32 n, int32 k)
+{
+    int32 i = 0;
+
+    if (k == 2) {
+        for (; i + 4 <= n; i += 4, dst += 8) {
+            uint32x4_t v = vld1q_u32(src + i);
+            uint32x4x2_t z = vzipq_u32(v, v);
+            vst1q_u32(dst, z.val[0]);
+            vst1q_u32(dst + 4, z.val[1]);
+        }
+    } else if (k == 4) {
+        for (; i + 4 <= n; i += 4, dst += 16) {
+            uint32x4_t v = vld1q_u32(src + i);
+            vst1q_u32(dst, vdupq_n_u32(vgetq_lane_u32(v, 0)));
+            vst1q_u32(dst + 4, vdupq_n_u32(vgetq_lane_u32(v, 1)));
+            vst1q_u32(dst + 8, vdupq_n_u32(vgetq_lane_u32(v, 2)));
+            vst1q_u32(dst + 12, vdupq_n_u32(vgetq_lane_u32(v, 3)));
+        }
+    }
+    expand_c(dst, src + i, n - i, k);
+}
+
+static void darken_neon(uint32* dst, const uint32* src, int32 n)
+{
+    const uint32x4_t alpha = vdupq_n_u32(ALPHA_MASK);
+    int32 i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t v = vld1q_u32(src + i);
+        uint32x4_t d = vreinterpretq_u32_u8(vshrq_n_u8(vreinterpretq_u8_u32(v), 1));
+        vst1q_u32(dst + i, vbslq_u32(alpha, v, d));
+    }
+    darken_c(dst + i, src + i, n - i);
+}
+
+static void blend_rows_neon(uint32* dst, const uint32* a, const uint32* b, int32 n, int32 w)
+{
+    int32 i = 0;
+
+    // Widened to 16 bits, as lerp_pixel() does it
+    for (; i + 4 <= n; i += 4) {
+        uint8x16_t va = vreinterpretq_u8_u32(vld1q_u32(a + i));
+        uint8x16_t vb = vreinterpretq_u8_u32(vld1q_u32(b + i));
+        uint16x8_t lo = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(va)), (uint16)(256 - w)),
+                                    vmovl_u8(vget_low_u8(vb)), (uint16)w);
+        uint16x8_t hi = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(va)), (uint16)(256 - w)),
+                                    vmovl_u8(vget_high_u8(vb)), (uint16)w);
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8))));
+    }
+    blend_rows_c(dst + i, a + i, b + i, n - i, w);
+}
+
+static const UpscaleFuncs funcs_neon = {
+    expand_neon, darken_neon, blend_rows_neon, resample_c, "NEON"
+};
+#endif
+
+
+static const UpscaleFuncs* g_funcs = NULL;
+
+static const UpscaleFuncs* pick_funcs(void)
+{
+    if (!g_funcs) {
+        g_funcs = &funcs_c;
+#ifdef UPSCALE_SSE2
+        g_funcs = &funcs_sse2;
+#endif
+#ifdef UPSCALE_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) g_funcs = &funcs_avx2;
+#endif
+#ifdef UPSCALE_NEON
+        g_funcs = &funcs_neon;
+#endif
+    }
+    return g_funcs;
+}
+
+const char* upscale_cpu(void)
+{
+    return pick_funcs()->name;
+}
+
+// Texel and weight for each output pixel along one axis.  The fraction
+// between texels is stretched by the scale about its midpoint, so the
+// blend happens over about one output pixel at each texel edge.
+static void sharp_axis(int32* index, uint16* weight, int32 n, int32 src_n, double scale)
+{
+    double sharpen = scale > 1.0 ? scale : 1.0;
+    int32 i;
+
+    for (i = 0; i < n; i++) {
+        double u = (i + 0.5) / scale - 0.5;
+        int32 t = (int32)(u + 1.0) - 1;     // floor for u > -1
+        double f = ((u - t) - 0.5) * sharpen + 0.5;
+
+        if (f < 0.0) f = 0.0;
+        if (f > 1.0) f = 1.0;
+        if (t < 0) {
+            t = 0;
+            f = 0.0;
+        }
+        if (t >= src_n - 1) {
+            t = src_n - 2;
+            f = 1.0;
+        }
+        index[i] = t;
+        weight[i] = (uint16)(f * 256.0 + 0.5);
+    }
+}
+
+void upscaler_free(Upscaler* up)
+{
+    free(up->cols);
+    free(up->col_weights);
+    free(up->rows);
+    free(up->row_weights);
+    memset(up, 0, sizeof(*up));
+}
+
+int upscaler_setup(Upscaler* up, int32 mode, int32 src_width, int32 src_height,
+                   int32 win_width, int32 win_height)
+{
+    if (up->width && mode == up->mode && src_width == up->src_width &&
+        src_height == up->src_height && win_width == up->win_width &&
+        win_height == up->win_height) {
+        return 0;
+    }
+    upscaler_free(up);
+    pick_funcs();
+
+    up->mode = mode;
+    up->src_width = src_width;
+    up->src_height = src_height;
+    up->win_width = win_width;
+    up->win_height = win_height;
+
+    if (mode == UPSCALE_SHARP_BILINEAR && src_width > 1 && src_height > 1 &&
+        src_width <= UPSCALE_MAX_WIDTH) {
+        double sx = (double)win_width / src_width, sy = (double)win_height / src_height;
+        double scale = sx < sy ? sx : sy;
+
+        up->factor = 0;
+        up->width = (int32)(src_width * scale);
+        up->height = (int32)(src_height * scale);
+        up->cols = (int32*)malloc(up->width * sizeof(int32));
+        up->col_weights = (uint16*)malloc((up->width + 8) * sizeof(uint16));
+        up->rows = (int32*)malloc(up->height * sizeof(int32));
+        up->row_weights = (uint16*)malloc(up->height * sizeof(uint16));
+        if (!up->cols || !up->col_weights || !up->rows || !up->row_weights) {
+            upscaler_free(up);
+            return -1;
+        }
+        sharp_axis(up->cols, up->col_weights, up->width, src_width, scale);
+        sharp_axis(up->rows, up->row_weights, up->height, src_height, scale);
+    } else {
+        int32 kx = win_width / src_width, ky = win_height / src_height;
+
+        up->factor = kx < ky ? kx : ky;
+        if (up->factor < 1) up->factor = 1;
+        up->width = src_width * up->factor;
+        up->height = src_height * up->factor;
+    }
+    return 0;
+}
+
+void upscale_rows(const Upscaler* up, uint32* dst, int32 dst_pitch,
+                  const uint32* src, int32 src_pitch, int32 top, int32 bottom)
+{
+    const UpscaleFuncs* f = g_funcs;
+    int32 y;
+
+    if (top < 0) top = 0;
+    if (bottom > up->height) bottom = up->height;
+
+    if (up->mode == UPSCALE_SHARP_BILINEAR && up->cols) {
+        uint32 blended[UPSCALE_MAX_WIDTH];
+
+        for (y = top; y < bottom; y++) {
+            uint32* d = dst + (size_t)y * dst_pitch;
+            int32 r = up->rows[y];
+
+            int32 w = up->row_weights[y];
+
+            if (y > top && r == up->rows[y - 1] && w == up->row_weights[y - 1]) {
+                memcpy(d, d - dst_pitch, up->width * sizeof(uint32));
+            } else {
+                // Blend the two source rows first, so each texel is blended
+                // down once rather than at every output pixel it covers
+                const uint32* row = src + (size_t)r * src_pitch;
+                if (w == 256) {
+                    row += src_pitch;
+                } else if (w) {
+                    f->blend_rows(blended, row, row + src_pitch, up->src_width, w);
+                    row = blended;
+                }
+                f->resample(d, row, up->cols, up->col_weights, up->width);
+            }
+        }
+        return;
+    }
+
+    for (y = top; y < bottom; y++) {
+        uint32* d = dst + (size_t)y * dst_pitch;
+        int32 sub = y % up->factor;
+        int dark = up->mode == UPSCALE_SCANLINE && up->factor > 1 && sub == up->factor - 1;
+
+        // The row above is a bright copy of the same source row, unless
+        // this is the first row of the band
+        if (sub && y > top) {
+            if (dark) {
+                f->darken(d, d - dst_pitch, up->width);
+            } else {
+                memcpy(d, d - dst_pitch, up->width * sizeof(uint32));
+            }
+        } else {
+            f->expand(d, src + (size_t)(y / up->factor) * src_pitch, up->src_width, up->factor);
+            if (dark) f->darken(d, d, up->width);
+        }
+    }
+}
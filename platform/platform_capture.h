@@ -0,0 +1,61 @@
+#ifndef PLATFORM_CAPTURE_H
+#define PLATFORM_CAPTURE_H
+
+#include "platform_raster.h"
+
+/*
+ * Draw-list capture
+ * Records every draw list a run of frames hands the cel engine, with the
+ * textures and PLUTs the cels use, so the same frames can be drawn again
+ * away from the game (see DrawReplay).  Textures are written once, the
+ * first time a cel uses them; PLUTs go in with each cel, as they are
+ * rewritten from frame to frame.  The file is in the byte order of the
+ * machine that made it.
+ */
+
+#define CAPTURE_MAGIC   "EFMMDRAW"
+#define CAPTURE_VERSION 1
+
+// Start recording the next frames to a file, ending the recording
+// already going if there is one.  Returns 0, or -1 if the file can't be
+// created.
+int capture_start(const char* path, int32 frames);
+
+// Nonzero while recording
+int capture_active(void);
+
+// Record a list drawn into a target.  target tells the bitmaps apart.
+void capture_list(const RasterTarget* rt, int32 target, const RasterDrawList* list);
+
+// A frame was shown.  The file is closed after the last one.
+void capture_frame(void);
+
+// Close the file, however many frames it holds
+void capture_stop(void);
+
+// A recording read back
+typedef struct CaptureDraw {
+    int32 target;           // Index into targets
+    RasterDrawList list;
+} CaptureDraw;
+
+typedef struct Capture {
+    int32 ntextures;
+    PlatformTexture** textures;
+    int32 ntargets;
+    RasterTarget* targets;  // Sized and formatted, pixels NULL
+    int32* target_ids;      // The bitmap each target was recorded from
+    int32 ndraws;
+    CaptureDraw* draws;
+    int32 nframes;
+    int32* frame_ends;      // One past each frame's last draw
+    int32 npluts;
+    uint16* pluts;          // 32 entries for every cel that has one
+} Capture;
+
+// Read a recording.  Textures that had mip levels get them rebuilt.
+// Returns 0, or -1 (with a message) if the file can't be read.
+int capture_load(Capture* cap, const char* path);
+void capture_free(Capture* cap);
+
+#endif // PLATFORM_CAPTURE_H
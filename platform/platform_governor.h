@@ -0,0 +1,54 @@
+#ifndef PLATFORM_GOVERNOR_H
+#define PLATFORM_GOVERNOR_H
+
+/*
+ * Dynamic resolution governor
+ * Watches the per-frame render cost and steps the internal render scale
+ * between configured bounds to hold a target frame time.  Dropping a step
+ * needs a short run of slow frames; raising one needs a much longer run of
+ * frames that would still fit the budget at the larger scale, so the scale
+ * doesn't flip back and forth around the threshold.
+ */
+
+typedef struct ResGovernor {
+    int min_scale;
+    int max_scale;
+    int scale;              // Scale currently in use
+    double target_ms;       // Frame cost to hold
+    double avg_ms;          // Smoothed frame cost at the current scale
+    int samples;            // Frames averaged since the last change
+    int over_frames;        // Consecutive frames over budget
+    int under_frames;       // Consecutive frames with room for a step up
+} ResGovernor;
+
+void res_governor_init(ResGovernor* gov, int min_scale, int max_scale, int scale,
+                       double target_ms);
+
+// Feed one frame's render cost in milliseconds.  Returns the scale to
+// render the next frame at.
+int res_governor_update(ResGovernor* gov, double frame_ms);
+
+/*
+ * Draw distance governor
+ * Holds the cost of extracting and rasterizing the world to a budget by
+ * moving the draw distance a fraction of a grid cell per frame.  Distant
+ * walls are already faded to black at the distance, so a gradual change
+ * can't be seen as a pop; it is the rate, not a run of frames, that keeps
+ * it from hunting.
+ */
+
+typedef struct DistGovernor {
+    double min_dist;        // Grid cells
+    double max_dist;
+    double target_ms;       // Extraction + rasterization cost to hold
+    double avg_ms;          // Smoothed cost
+    int samples;
+} DistGovernor;
+
+void dist_governor_init(DistGovernor* gov, double min_dist, double max_dist, double target_ms);
+
+// Feed one frame's world cost in milliseconds and the distance it was
+// drawn at.  Returns the distance for the next frame.
+double dist_governor_update(DistGovernor* gov, double cost_ms, double dist);
+
+#endif // PLATFORM_GOVERNOR_H
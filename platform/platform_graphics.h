@@ -13,14 +13,25 @@ typedef struct CCB CCB;
 typedef struct CelArray CelArray;
 typedef struct RastPort RastPort;
 typedef struct ScreenItem ScreenItem;
+typedef struct RasterDrawList RasterDrawList;
+
+// Texture formats.  Indexed textures hold one PLUT index (0-31) per
+// texel and take their colors from the drawing cel's ccb_PLUTPtr (32
+// RGB555 entries), so a cel can be recolored or faded by pointing it at
+// another PLUT.
+#define TEXFMT_INDEX8 1
+#define TEXFMT_RGBA32 4
+#define TEX_INDEX_CLEAR 0xFF    // Transparent texel in an indexed texture
 
 // Platform-specific texture structure (shared between modules)
 typedef struct PlatformTexture {
     void* gl_id;      // OpenGL texture ID (or other platform-specific ID)
     int width;        // Texture width
     int height;       // Texture height  
-    int format;       // Pixel format (4 = RGBA32)
+    int format;       // TEXFMT_INDEX8 or TEXFMT_RGBA32
+    int tile_shift;   // 0 = linear rows, else square tiles of 1 << tile_shift
     void* data;       // Pixel data buffer
+    struct PlatformTexture* mip;  // Next mip level (half size), or NULL
 } PlatformTexture;
 
 // Graphics context structure (replaces 3DO GrafCon)
@@ -36,9 +47,12 @@ typedef struct Bitmap {
     int32 bm_Width;
     int32 bm_Height;
     int32 bm_BytesPerRow;
-    uint32 bm_Format;
+    uint32 bm_Format;   // BMF_RGBA32 or BMF_RGB555
 } Bitmap;
 
+#define BMF_RGBA32 0
+#define BMF_RGB555 1
+
 // Screen structure (replaces 3DO Screen)
 typedef struct Screen {
     Item sc_ScreenItem;
@@ -68,6 +82,8 @@ typedef struct CCB {
     frac16 ccb_HDY;   // Horizontal delta Y  
     frac16 ccb_VDX;   // Vertical delta X
     frac16 ccb_VDY;   // Vertical delta Y
+    frac16 ccb_HDDX;  // Per-row change to HDX
+    frac16 ccb_HDDY;  // Per-row change to HDY
     
     // Cel dimensions
     int32 ccb_Width;
@@ -98,24 +114,179 @@ typedef struct CCB {
 #define CCB_ACW         0x00040000
 #define CCB_ACCW        0x00020000
 #define CCB_TWD         0x00010000
+#define CCB_ACE         0x00004000
+#define CCB_BGND        0x00000020
+#define CCB_NOBLK       0x00000010
+
+// Pixel processor control (ccb_PIXC, from 3DO).  Two 16-bit PPMP words;
+// P-mode 0 pixels use the low one.  Each pixel comes out as
+// ((primary * MF / SF) + secondary) / 2D.
+#define PPMP_0_SHIFT    0
+#define PPMP_1_SHIFT    16
+#define PPMPC_1S_MASK   0x00008000  // Primary source
+#define PPMPC_1S_PDC    0x00000000  //   the cel's pixel
+#define PPMPC_1S_CFBD   0x00008000  //   the frame buffer's
+#define PPMPC_MS_MASK   0x00006000  // Multiplier select
+#define PPMPC_MS_CCB    0x00000000
+#define PPMPC_MF_MASK   0x00001C00  // Multiply by MF + 1
+#define PPMPC_MF_SHIFT  10
+#define PPMPC_MF_1      0x00000000
+#define PPMPC_MF_2      0x00000400
+#define PPMPC_MF_3      0x00000800
+#define PPMPC_MF_4      0x00000C00
+#define PPMPC_MF_5      0x00001000
+#define PPMPC_MF_6      0x00001400
+#define PPMPC_MF_7      0x00001800
+#define PPMPC_MF_8      0x00001C00
+#define PPMPC_SF_MASK   0x00000300  // Then divide
+#define PPMPC_SF_SHIFT  8
+#define PPMPC_SF_2      0x00000100
+#define PPMPC_SF_4      0x00000200
+#define PPMPC_SF_8      0x00000300
+#define PPMPC_SF_16     0x00000000
+#define PPMPC_2S_MASK   0x000000C0  // Secondary source
+#define PPMPC_2S_SHIFT  6
+#define PPMPC_2S_0      0x00000000  //   nothing
+#define PPMPC_2S_CCB    0x00000040  //   the AV value
+#define PPMPC_2S_CFBD   0x00000080  //   the frame buffer's pixel
+#define PPMPC_2S_PDC    0x000000C0  //   the cel's pixel
+#define PPMPC_AV_MASK   0x0000003E
+#define PPMPC_AV_SHIFT  1
+#define PPMPC_2D_MASK   0x00000001  // Final divide
+#define PPMPC_2D_1      0x00000000
+#define PPMPC_2D_2      0x00000001
+
+#define PPMP_MODE_NORMAL  0x1F00    // Cel pixel as is
+#define PPMP_MODE_AVERAGE 0x1F81    // Half cel, half frame buffer
 
 // Cel Array structure (replaces 3DO CelArray)
 typedef struct CelArray {
     int32 ca_nCCBs;
     CCB** celptrs;
+    uint16* ca_PLUT;    // PLUT the coded cels were loaded with, or NULL
 } CelArray;
 
 // Graphics initialization and cleanup
 int platform_init_graphics(int width, int height, bool fullscreen);
 void platform_shutdown_graphics(void);
 
+// Number of horizontal bands (threads) DrawCels() rasterizes with;
+// 0 = one per CPU core, 1 = single-threaded.  Returns the count in use.
+int platform_set_raster_threads(int count);
+
+// Draw wall cels (H axis straight down the screen) a column at a time
+// rather than through the general quad path.  Off by default: it samples
+// each column's exact perspective, so about one wall pixel in ten comes
+// out a texel off from the quad path.
+void platform_set_column_walls(bool enabled);
+
+// Texel layout for cel textures loaded from now on: 0 (or 1) keeps linear
+// rows, 4 or 8 stores them in 4x4 or 8x8 tiles.  Returns the size in use.
+// platform_layout_texture() puts a freshly decoded texture in that layout.
+int platform_set_texture_tiles(int size);
+void platform_layout_texture(PlatformTexture* tex);
+
+// Give every frame of a cel array a mip chain, so it costs fewer texel
+// reads (and aliases less) when drawn small.  parse3DO() does this for
+// every cel array it loads.  Returns the number of frames that got one.
+int platform_build_cel_mips(CelArray* ca);
+
+// Record the draw lists of the next frames shown to a file, for the
+// DrawReplay benchmark.  No path or no frames stops a recording under way.
+// Returns 0, or -1 if the file can't be created.
+int platform_set_capture(const char* path, int frames);
+
+// Internal render resolution as a multiple (1-4) of the 320x240 3DO screen.
+// Existing screens are reallocated (and cleared) at the new size; cel
+// coordinates remain in 3DO pixels.
+int platform_set_render_scale(int scale);
+int platform_get_render_scale(void);
+
+// Keep the screens in RGB555, the 3DO's own pixel format, instead of
+// RGBA32: cels, SetRast() and the rest draw 16-bit pixels, and the frame
+// is widened for display in one pass when it is shown.  Existing screens
+// are reallocated (and cleared).
+void platform_set_rgb555_screens(bool enabled);
+
+// Ready frames on a thread of its own: DisplayScreen() hands the frame
+// over and returns, and the thread widens, fades and upscales it into
+// staging memory while the game draws the next one.  The renderer stays
+// on the game thread, which uploads and presents the readied frame at its
+// next DisplayScreen() or WaitVBL().  The screens share a third buffer so
+// drawing never waits on the thread.  Queue depth, added latency and
+// dropped frames show in the perf report.  On by default.
+void platform_set_async_present(bool enabled);
+
+// Upload only what changed: drawing notes the box of each screen it
+// touches, and DisplayScreen() compares that box against a copy of what
+// is on display, so readying and uploading cost the pixels that actually
+// differ.  Menus and other static screens that redraw in full every frame
+// come down to a compare and a line or two of text.  On by default.
+void platform_set_dirty_present(bool enabled);
+
+// Scale frames up to the window on the CPU rather than in the renderer:
+// 0 leaves it to the renderer, 1 is the largest whole multiple that fits,
+// 2 sharp bilinear (fills the window at the frame's aspect, soft only at
+// texel edges), 3 whole multiples with dimmed scanlines.  The work is
+// split across threads (0 = one per CPU core).  Returns the mode in use.
+int platform_set_upscale(int mode, int threads);
+
+// Dynamic resolution: when enabled, platform_govern_resolution() is fed
+// each frame's render cost and moves the render scale between min_scale
+// and max_scale to hold target_ms.  Returns the scale for the next frame.
+void platform_set_dynamic_resolution(bool enabled, int min_scale, int max_scale, double target_ms);
+int platform_govern_resolution(double frame_ms);
+
+// Adaptive draw distance: when enabled, platform_govern_draw_distance() is
+// fed the cost of extracting and rasterizing the world and the distance
+// (in grid cells, 16.16) it was drawn at, and returns the distance to draw
+// the next frame at, between min_dist and max_dist.  Disabled, the
+// distance is returned unchanged.
+void platform_set_adaptive_draw_distance(bool enabled, double min_dist, double max_dist,
+                                         double target_ms);
+frac16 platform_govern_draw_distance(double cost_ms, frac16 dist);
+
+// Performance counters (timers and gauges), reported by platform_perf_report()
+void platform_perf_start(const char* name);
+void platform_perf_end(const char* name);
+double platform_perf_last(const char* name);
+void platform_perf_set(const char* name, double value);
+void platform_perf_report(void);
+
 // Screen management (replaces 3DO screen functions)
 int CreateScreenGroup(Item* screen_items, void* tags);
 int DisplayScreen(Item screen_item, uint32 value);
 int DeleteScreenGroup(Item* screen_items);
 
+// Scale a screen's red, green and blue as it is displayed, the way the
+// 3DO faded a screen by reloading its CLUT.  Levels are 16.16, from 0
+// (black) to 1.0 (as drawn).  The bitmap isn't touched; the levels are
+// applied in the pass that readies the frame for display, and a screen
+// that is showing is shown again at its new levels.
+void platform_fade_screen(Item screen_item, frac16 r, frac16 g, frac16 b);
+
+// Retained HUD layer.  The gun and the readouts on it change far less
+// often than the world under them, so they're drawn into a layer that is
+// kept between frames.  platform_hud_begin() takes a key summing up all
+// the HUD shows.  If it differs from last time it clears the layer and
+// returns its bitmap item to draw the HUD into (with DrawCels() and the
+// rest, in 3DO coordinates); if not it returns 0 and the HUD isn't drawn
+// at all.  platform_hud_composite() then lays the layer over a screen
+// bitmap in one masked blit.  Redrawn and skipped frames are counted in
+// the perf report as hud_redrawn and hud_skipped.  Nothing the SDL build
+// compiles calls these yet: their one caller is drawhud() in shoot.c,
+// which comes in with the rest of the world drawing (rendercels() in
+// game_stubs.c doesn't draw the gun), and the 3DO build has them draw
+// straight onto the screen (threedo_compat.h).
+Item platform_hud_begin(Item bitmap_item, uint32 key);
+void platform_hud_composite(Item bitmap_item);
+
 // Drawing functions (replaces 3DO drawing functions)
 int DrawCels(Item bitmap_item, CCB* ccb);
+
+// Draw a packed draw list (see platform_raster.h).  DrawCels() packs its
+// chain into one and comes here.
+int platform_draw_list(Item bitmap_item, const RasterDrawList* list);
 int SetRast(RastPort* rp, uint32 color);
 int CopyVRAMPages(Item vram_io, void* dest, void* src, int32 pages, uint32 mask);
 int SetVRAMPages(Item vram_io, void* dest, uint32 value, int32 pages, uint32 mask);
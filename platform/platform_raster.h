@@ -0,0 +1,148 @@
+#ifndef PLATFORM_RASTER_H
+#define PLATFORM_RASTER_H
+
+#include "platform_graphics.h"
+#include <stddef.h>
+
+/*
+ * Software cel engine
+ * Replaces the 3DO cel hardware: maps a cel's source pixels onto the
+ * quadrilateral described by ccb_XPos/YPos and the HDX/HDY/VDX/VDY/HDDX/HDDY
+ * deltas, using the same fixed-point formats as the original hardware
+ * (HDX/HDY/HDDX/HDDY are 12.20, positions and VDX/VDY are 16.16).
+ */
+
+// Destination for the cel engine.  Only scanlines in
+// [clip_top, clip_bottom) are ever written, and every pixel comes out the
+// same whatever the clip window is, so a frame can be split into
+// horizontal bands and drawn by several threads at once.
+typedef struct RasterTarget {
+    void* pixels;        // RGBA32 pixels, or RGB555 if rgb555 is set
+    int32 rgb555;
+    int32 width;
+    int32 height;
+    int32 stride;        // Pitch in pixels
+    int32 clip_top;
+    int32 clip_bottom;
+    int32 scale;         // Target pixels per unit of cel coordinates
+    int32 column_walls;  // Draw transposed (wall) cels a column at a time
+} RasterTarget;
+
+// Set up a target covering the whole bitmap, in its format, at a scale
+// of 1, with column walls off
+void raster_target_from_bitmap(RasterTarget* rt, Bitmap* bitmap);
+
+// RGBA32 to RGB555 (the 3DO's layout, red in bits 10-14) and back
+static inline uint16 raster_rgb555(uint32 rgba)
+{
+    return (uint16)(((rgba & 0xF8) << 7) | ((rgba >> 6) & 0x3E0) | ((rgba >> 19) & 0x1F));
+}
+
+static inline uint32 raster_rgba32(uint16 c)
+{
+    return 0xFF000000 | ((uint32)(c & 0x1F) << 19) | ((uint32)(c & 0x3E0) << 6) |
+           ((uint32)(c & 0x7C00) >> 7);
+}
+
+// Widen n RGB555 pixels to opaque RGBA32, for display
+void raster_rgb555_to_rgba32(uint32* dst, const uint16* src, size_t n);
+
+// Scale the red, green and blue of n pixels by levels out of 256 (256
+// leaves a channel as it is), for display.  dst may be src.  The RGB555
+// form widens in the same pass.
+void raster_fade_rgba32(uint32* dst, const uint32* src, size_t n, int32 r, int32 g, int32 b);
+void raster_fade_rgb555_to_rgba32(uint32* dst, const uint16* src, size_t n,
+                                  int32 r, int32 g, int32 b);
+
+// Fill nrows whole rows of the target, from row top down, each with its
+// own RGBA32 color, honoring the clip window.  A memory-bound pass of
+// aligned SIMD stores, non-temporal when the target is too big to stay
+// in cache.  Cels with one color per row (the backwall gradient) are
+// drawn this way by raster_draw_cel() too.
+void raster_fill_rows(const RasterTarget* rt, int32 top, const uint32* colors, int32 nrows);
+
+// Lay n pixels of a layer over dst, in the target's format, copying
+// only the pixels something was drawn on: nonzero alpha in RGBA32, or
+// nonzero at all in RGB555 (the 3DO's transparent color).
+void raster_overlay(void* dst, const void* src, size_t n, int rgb555);
+
+// Compare the box { left, top, right, bottom } (right and bottom
+// exclusive) of a frame with a copy of it, bpp bytes a pixel, pitches in
+// bytes.  The copy is brought up to date and the box narrowed down to the
+// pixels that differed.  Returns 0, with an empty box, if none did.
+int raster_diff_box(const void* frame, size_t frame_pitch, void* copy, size_t copy_pitch,
+                    int bpp, int32 box[4]);
+
+// Largest tile: 8x8 texels
+#define RASTER_MAX_TILE_SHIFT 3
+
+// Rearrange a linear texture into square tiles of 1 << tile_shift texels
+// a side, so texels that are near each other in any direction share cache
+// lines.  Pays off for cels drawn rotated or scaled down; wall cels are
+// read along their rows and are better left linear.  The data is
+// reallocated with malloc().  Returns 1 if the texture ends up in the
+// requested layout, 0 if it can't be converted (the texture is left as
+// it was).
+int raster_tile_texture(PlatformTexture* tex, int tile_shift);
+
+// Build a chain of half-size mip levels below a texture, down to one
+// texel wide or high, hanging off tex->mip, in the texture's layout.  Cels whose texture has a
+// chain are drawn from the level nearest their size on screen (walls and
+// other perspective cels always use the full texture).  Returns the
+// number of levels built.
+int raster_build_mips(PlatformTexture* tex);
+
+// Draw a single cel, ignoring its chain links.  Returns 1 if the cel
+// was rasterized, 0 if it was culled or had nothing to draw.
+int raster_draw_cel(const RasterTarget* rt, const CCB* ccb);
+
+// Walk a cel chain the way DrawCels() does (honoring CCB_SKIP and
+// CCB_LAST).  Returns the number of cels rasterized.
+int raster_draw_cels(const RasterTarget* rt, const CCB* ccb);
+
+// Box of target pixels a cel could draw on, whatever the clip window, as
+// { left, top, right, bottom } with right and bottom exclusive.  Errs on
+// the large side.  Returns 0 if the cel can't touch the target.
+int raster_cel_bounds(const RasterTarget* rt, const CCB* ccb, int32 box[4]);
+
+// A frame's cels packed into parallel arrays, one entry per cel, in
+// drawing order.  The rasterizer walks it front to back instead of
+// chasing ccb_NextPtr through whole CCBs, and a band only reads the rows
+// of cels that miss it.  Zero it before first use.
+struct RasterDrawList {
+    int32 count;
+    int32 capacity;
+    const PlatformTexture** texture;
+    const void** plut;
+    int32 (*rows)[2];       // Top and bottom rows the cel could reach, unscaled
+    frac16 (*pos)[2];       // XPos, YPos
+    frac16 (*delta)[6];     // HDX, HDY, VDX, VDY, HDDX, HDDY
+    uint32* pixc;
+    uint32* flags;          // Never CCB_LAST
+    void* block;            // All of the above
+};
+
+// Empty a list, keeping its memory
+static inline void raster_list_clear(RasterDrawList* list)
+{
+    list->count = 0;
+}
+
+void raster_list_free(RasterDrawList* list);
+
+// Append a cel.  Returns 1, 0 if it has no texture to draw (nothing is
+// added), or -1 if out of memory.
+int raster_list_add(RasterDrawList* list, const CCB* ccb);
+
+// Append a cel chain, walking it the way DrawCels() does.  Returns the
+// number of cels added, or -1 if out of memory.
+int raster_list_add_cels(RasterDrawList* list, const CCB* ccb);
+
+// Draw a list.  The same pixels as raster_draw_cels() on the chain it
+// was made from.  Returns the number of cels rasterized.
+int raster_draw_list(const RasterTarget* rt, const RasterDrawList* list);
+
+// raster_cel_bounds() for cel i of a list
+int raster_list_bounds(const RasterTarget* rt, const RasterDrawList* list, int32 i, int32 box[4]);
+
+#endif // PLATFORM_RASTER_H
@@ -100,6 +100,7 @@ typedef uint32 Color;
 #define MakeCLUTColorEntry(idx,r,g,b) (((idx) << 24) | ((r) << 16) | ((g) << 8) | (b))
 
 // Memory allocation types (replacing 3DO MEMTYPE flags)
+#define MEMTYPE_ANY       0x00000000
 #define MEMTYPE_NORMAL    0x00000001
 #define MEMTYPE_VRAM      0x00000002  
 #define MEMTYPE_CEL       0x00000004
@@ -0,0 +1,51 @@
+#ifndef PLATFORM_UPSCALE_H
+#define PLATFORM_UPSCALE_H
+
+#include "platform_graphics.h"
+
+/*
+ * Window upscaler
+ * Scales a finished RGBA32 frame up to the window on the CPU, for
+ * machines where the renderer would otherwise stretch it with a software
+ * bilinear filter.  Output is made a band of rows at a time and bands
+ * don't depend on each other, so a frame can be split across threads.
+ * The inner loops are picked at run time for the CPU: AVX2, SSE2, NEON or
+ * plain C.
+ */
+
+#define UPSCALE_NONE            0   // Leave it to the renderer
+#define UPSCALE_INTEGER         1   // Largest whole multiple that fits, nearest texel
+#define UPSCALE_SHARP_BILINEAR  2   // Fill the window at the frame's aspect, blending
+                                    // only across the edges between texels
+#define UPSCALE_SCANLINE        3   // UPSCALE_INTEGER with the last row of every
+                                    // texel row at half brightness
+
+typedef struct Upscaler {
+    int32 mode;
+    int32 src_width, src_height;
+    int32 win_width, win_height;
+    int32 width, height;    // Output size
+    int32 factor;           // Multiple, in the integer modes
+    int32* cols;            // Sharp bilinear: left texel for each output column,
+    uint16* col_weights;    // and the right one's weight out of 256
+    int32* rows;            // Likewise for rows, top texel
+    uint16* row_weights;
+} Upscaler;
+
+// Size the output for a frame and a window and build what the mode needs.
+// Does nothing if none of them have changed, so it can be called every
+// frame.  The integer modes never scale down; with the window smaller
+// than the frame they come out at 1x.  Returns 0, or -1 if out of memory
+// (the upscaler is then left empty).  Zero the Upscaler before first use.
+int upscaler_setup(Upscaler* up, int32 mode, int32 src_width, int32 src_height,
+                   int32 win_width, int32 win_height);
+void upscaler_free(Upscaler* up);
+
+// Make output rows [top, bottom) from the frame.  Pitches are in pixels.
+void upscale_rows(const Upscaler* up, uint32* dst, int32 dst_pitch,
+                  const uint32* src, int32 src_pitch, int32 top, int32 bottom);
+
+// Which loops upscale_rows() runs on this CPU
+const char* upscale_cpu(void);
+
+#endif // PLATFORM_UPSCALE_H
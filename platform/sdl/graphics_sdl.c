@@ -1,4 +1,8 @@
 #include "platform/platform_graphics.h"
+#include "platform/platform_raster.h"
+#include "platform/platform_governor.h"
+#include "platform/platform_upscale.h"
+#include "platform/platform_capture.h"
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include <GL/gl.h>
@@ -21,6 +25,45 @@ static int g_screen_height = 240;
 static int g_window_width = 640;
 static int g_window_height = 480;
 
+// Internal render resolution.  Screen bitmaps are allocated at this many
+// times the 3DO resolution; cel coordinates stay in 3DO pixels and are
+// scaled up by the cel engine, so only the projection has to know.
+#define MAX_RENDER_SCALE 4
+static int g_render_scale = 1;
+static int g_screen_format = BMF_RGBA32;
+static SDL_Texture* g_present_texture = NULL; // Streaming texture screens are shown through
+static GLuint g_present_gl_texture = 0;
+static int g_present_width = 0, g_present_height = 0;
+static uint32* g_present_pixels = NULL;     // RGB555 or faded screens readied for GL
+static size_t g_present_size = 0;
+static void release_present_textures(void);
+static void present_sync(void);
+static void present_wait(const void* buffer);
+static void start_present_thread(void);
+static void stop_present_thread(void);
+static void stop_upscale_workers(void);
+static Bitmap* lookup_bitmap(Item bitmap_item);
+static void* g_spare_buffer = NULL;         // Third screen buffer (see DisplayScreen())
+static int32 g_screen_fade[4][3];           // Per-channel display levels out of 256
+static Item g_shown_screen = 0;             // Last screen passed to DisplayScreen()
+static uint32* g_clear_rows = NULL;         // clearscreen()'s color for each row
+static int g_clear_height = 0;
+static int32 g_clear_ceiling, g_clear_floor, g_clear_cy;
+
+// Retained HUD layer (see platform_hud_begin())
+#define HUD_BITMAP_ITEM 16
+static Bitmap g_hud_bitmap;
+static bool g_hud_valid = false;            // Holds what g_hud_key describes
+static uint32 g_hud_key;
+static int g_hud_top = -1, g_hud_bottom;    // Rows drawn on; top < 0 until found
+static uint32 g_hud_redrawn = 0, g_hud_skipped = 0;
+static bool g_dynres_enabled = false;
+static ResGovernor g_governor;
+
+// Adaptive draw distance
+static bool g_drawdist_enabled = false;
+static DistGovernor g_dist_governor;
+
 // Simulated 3DO structures
 static GraphicsBase g_graphics_base = {0};
 GraphicsBase* GrafBase = &g_graphics_base;
@@ -35,6 +78,456 @@ static int g_num_screens = 0;
 static Uint32 g_last_vbl_time = 0;
 static const int VBL_RATE = 60; // 60 Hz
 
+// Band-parallel cel rasterization.  Each worker walks the same draw list
+// but is clipped to its own horizontal band of the bitmap; the cel engine
+// produces the same pixels whatever the clip window, so the result is
+// bit-identical to drawing the chain on one thread.
+#define MAX_RASTER_BANDS 16
+#define MIN_BAND_HEIGHT 16
+
+typedef struct RasterWorker {
+    SDL_Thread* thread;
+    SDL_sem* go;
+    RasterTarget rt;
+    const RasterDrawList* list;
+} RasterWorker;
+
+static RasterWorker g_raster_workers[MAX_RASTER_BANDS];
+static SDL_sem* g_raster_done = NULL;
+static int g_raster_bands = 1;      // 1 = draw on the calling thread
+static int g_raster_nworkers = 0;   // Threads actually running
+static volatile int g_raster_quit = 0;
+static bool g_column_walls = false; // Wall cels take the column path
+static RasterDrawList g_cel_list;   // DrawCels()'s chain, packed
+
+// Asynchronous presentation.  DisplayScreen() hands the frame to the
+// present thread, which readies it (widened, faded, upscaled, only the
+// area that changed) into a staging buffer of its own and gives the
+// screen's buffer back, while the game goes on to the next frame.  The
+// renderer may only be used from the thread that made it, so uploading
+// the readied frame and presenting it are left to the game thread, the
+// next time it comes through DisplayScreen(), WaitVBL() or anything that
+// waits on the present thread.  The screens share three buffers between
+// them so the one being drawn next is never one being read.
+typedef struct DirtyRect {
+    int32 x0, y0, x1, y1;   // Right and bottom exclusive
+} DirtyRect;
+
+typedef struct PresentFrame {
+    Bitmap bitmap;          // The screen's bitmap as it was handed over
+    int32 fade[3];
+    DirtyRect drawn;        // What was drawn on it (see dirty_take())
+    int win_width, win_height;  // The renderer's output then
+    Uint64 queued;          // When DisplayScreen() was called
+} PresentFrame;
+
+// A frame the present thread has readied for the game thread to upload
+typedef struct PresentReady {
+    uint32* pixels;         // The area's pixels, rows packed
+    size_t size;            // pixels' room, in pixels
+    DirtyRect area;         // Where they go in the texture; empty if nothing changed
+    int width, height;      // The texture's size
+    int win_width, win_height;
+    bool upscale;
+    bool failed;            // Couldn't be readied; nothing to upload
+    Uint64 queued;
+} PresentReady;
+
+static bool g_present_async = true;
+static SDL_Thread* g_present_thread = NULL;
+static SDL_mutex* g_present_lock = NULL;
+static SDL_cond* g_present_wake = NULL;     // A frame is pending, or quit
+static SDL_cond* g_present_done = NULL;     // A buffer was read, or a frame shown
+static bool g_present_quit = false;
+static PresentFrame g_present_pending;
+static bool g_present_has_pending = false;
+static bool g_present_busy = false;         // The thread has a frame in hand
+static const void* g_present_reading = NULL;    // Buffer being readied from
+static PresentReady g_present_slots[2];     // Readied into in turn
+static int g_present_fill = 0;              // Slot the thread readies into next
+static bool g_present_has_ready = false;    // The other slot waits to be shown
+static bool g_present_lost = false;         // A readied frame never reached the texture
+static double g_present_latency = 0.0;      // ms from DisplayScreen() to shown, averaged (game thread)
+static double g_present_depth = 0.0;        // Frames already queued, averaged
+static uint32 g_present_dropped = 0;        // Pending frames replaced before shown
+static uint32 g_present_spares = 0;         // Times a screen was given the spare buffer
+static double g_present_ready = 0.0;        // ms readying each frame, averaged
+static double g_present_dirty = 100.0;      // Percent of each frame uploaded, averaged
+
+// Dirty-rectangle presentation.  Each screen buffer keeps the box drawn
+// on since it was last handed to DisplayScreen().  The presenter checks
+// that box, and whatever other buffers have changed in the texture since
+// this one was last shown, against a copy of what the texture holds, and
+// readies and uploads only the rows and columns that differ.  Menus draw
+// the whole screen every frame but change a line of text at most.
+#define DIRTY_BUFFERS 3
+#define DIRTY_ALL 0x7FFFFFFF
+#define DIRTY_MAX_MISSES 6          // Compare at least every 64th frame
+
+typedef struct DirtyBuffer {
+    const void* buffer;
+    DirtyRect drawn;        // Game thread: drawn on since last handed over
+    DirtyRect stale;        // Presenter: changed in the texture since last shown
+    bool shown;             // Presenter: the texture held this buffer, plus stale
+} DirtyBuffer;
+
+static bool g_dirty_present = true;
+static DirtyBuffer g_dirty[DIRTY_BUFFERS];  // The screens' buffers and the spare
+static ubyte* g_shadow = NULL;              // What the texture holds, in the screens' format
+static size_t g_shadow_size = 0;
+static bool g_shadow_valid = false;
+static int32 g_shadow_width, g_shadow_height, g_shadow_format;
+static int32 g_shadow_fade[3];
+static int g_dirty_misses = 0;              // Compares in a row that found most of a frame changed
+static int g_dirty_skip = 0;                // Frames to send whole before comparing again
+
+// CPU upscaling to the window.  Bands of output rows are made by
+// workers the same way DrawCels() splits a frame, for whichever thread
+// is presenting.
+#define MAX_UPSCALE_BANDS 16
+
+typedef struct UpscaleWorker {
+    SDL_Thread* thread;
+    SDL_sem* go;
+    int32 top, bottom;
+} UpscaleWorker;
+
+static UpscaleWorker g_upscale_workers[MAX_UPSCALE_BANDS];
+static SDL_sem* g_upscale_done = NULL;
+static int g_upscale_nworkers = 0;
+static volatile int g_upscale_quit = 0;
+static int g_upscale_mode = UPSCALE_NONE;
+static Upscaler g_upscaler;
+static uint32* g_upscale_dst;               // The frame being upscaled
+static int32 g_upscale_dst_pitch;
+static const uint32* g_upscale_src;
+static int32 g_upscale_src_pitch;
+static int g_texture_tile_shift = 0;    // Layout for newly loaded textures
+
+static int SDLCALL raster_worker_main(void* data)
+{
+    RasterWorker* worker = (RasterWorker*)data;
+
+    for (;;) {
+        SDL_SemWait(worker->go);
+        if (g_raster_quit) break;
+        raster_draw_list(&worker->rt, worker->list);
+        SDL_SemPost(g_raster_done);
+    }
+    return 0;
+}
+
+static void stop_raster_workers(void)
+{
+    g_raster_quit = 1;
+    for (int i = 0; i < g_raster_nworkers; i++) {
+        SDL_SemPost(g_raster_workers[i].go);
+    }
+    for (int i = 0; i < g_raster_nworkers; i++) {
+        SDL_WaitThread(g_raster_workers[i].thread, NULL);
+        SDL_DestroySemaphore(g_raster_workers[i].go);
+        g_raster_workers[i].thread = NULL;
+        g_raster_workers[i].go = NULL;
+    }
+    if (g_raster_done) {
+        SDL_DestroySemaphore(g_raster_done);
+        g_raster_done = NULL;
+    }
+    g_raster_nworkers = 0;
+    g_raster_quit = 0;
+}
+
+// Select how many horizontal bands DrawCels() splits a bitmap into.
+// 0 picks one band per CPU core; 1 turns band rendering off.
+int platform_set_raster_threads(int count)
+{
+    if (count <= 0) count = SDL_GetCPUCount();
+    if (count > MAX_RASTER_BANDS) count = MAX_RASTER_BANDS;
+    if (count < 1) count = 1;
+
+    stop_raster_workers();
+    g_raster_bands = 1;
+
+    // The calling thread draws the first band itself
+    if (count > 1) {
+        if (!(g_raster_done = SDL_CreateSemaphore(0))) {
+            printf("SDL_CreateSemaphore failed: %s\n", SDL_GetError());
+            return g_raster_bands;
+        }
+        for (int i = 0; i < count - 1; i++) {
+            RasterWorker* worker = &g_raster_workers[i];
+
+            if (!(worker->go = SDL_CreateSemaphore(0))) break;
+            if (!(worker->thread = SDL_CreateThread(raster_worker_main, "raster", worker))) {
+                SDL_DestroySemaphore(worker->go);
+                worker->go = NULL;
+                break;
+            }
+            g_raster_nworkers++;
+        }
+        g_raster_bands = g_raster_nworkers + 1;
+    }
+
+    printf("Cel rasterization: %d band(s)\n", g_raster_bands);
+    return g_raster_bands;
+}
+
+void platform_set_column_walls(bool enabled)
+{
+    g_column_walls = enabled;
+}
+
+int platform_set_texture_tiles(int size)
+{
+    if (size >= 8) g_texture_tile_shift = 3;
+    else if (size >= 4) g_texture_tile_shift = 2;
+    else g_texture_tile_shift = 0;
+    return g_texture_tile_shift ? 1 << g_texture_tile_shift : 0;
+}
+
+int platform_set_capture(const char* path, int frames)
+{
+    if (!path || !path[0] || frames <= 0) {
+        capture_stop();
+        return 0;
+    }
+    return capture_start(path, frames);
+}
+
+void platform_layout_texture(PlatformTexture* tex)
+{
+    if (tex && !raster_tile_texture(tex, g_texture_tile_shift)) {
+        printf("Texture %dx%d left linear\n", tex->width, tex->height);
+    }
+}
+
+int platform_build_cel_mips(CelArray* ca)
+{
+    int built = 0;
+
+    if (!ca || !ca->celptrs) return 0;
+    for (int i = 0; i < ca->ca_nCCBs; i++) {
+        CCB* ccb = ca->celptrs[i];
+
+        if (ccb && ccb->platform_texture && raster_build_mips(ccb->platform_texture) > 0) {
+            built++;
+        }
+    }
+    return built;
+}
+
+static int screen_bytes_per_pixel(void)
+{
+    return g_screen_format == BMF_RGB555 ? 2 : 4;
+}
+
+// The screen color for an RGBA32 value
+static uint32 screen_pixel(uint32 rgba)
+{
+    return g_screen_format == BMF_RGB555 ? raster_rgb555(rgba) : rgba;
+}
+
+static void fill_pixels(void* pixels, size_t n, uint32 rgba)
+{
+    if (g_screen_format == BMF_RGB555) {
+        uint16* p = (uint16*)pixels;
+        uint16 c = raster_rgb555(rgba);
+        for (size_t i = 0; i < n; i++) p[i] = c;
+    } else {
+        uint32* p = (uint32*)pixels;
+        for (size_t i = 0; i < n; i++) p[i] = rgba;
+    }
+}
+
+static bool rect_empty(const DirtyRect* r)
+{
+    return r->x0 >= r->x1 || r->y0 >= r->y1;
+}
+
+static void rect_union(DirtyRect* r, const DirtyRect* a)
+{
+    if (rect_empty(a)) return;
+    if (rect_empty(r)) {
+        *r = *a;
+        return;
+    }
+    if (a->x0 < r->x0) r->x0 = a->x0;
+    if (a->y0 < r->y0) r->y0 = a->y0;
+    if (a->x1 > r->x1) r->x1 = a->x1;
+    if (a->y1 > r->y1) r->y1 = a->y1;
+}
+
+static DirtyBuffer* dirty_buffer(const void* buffer)
+{
+    for (int i = 0; i < DIRTY_BUFFERS; i++) {
+        if (buffer && g_dirty[i].buffer == buffer) return &g_dirty[i];
+    }
+    return NULL;
+}
+
+// Note that a box of a screen buffer has been drawn on.  Anything else
+// (the HUD layer) is ignored.
+static void dirty_mark(const void* buffer, int32 x0, int32 y0, int32 x1, int32 y1)
+{
+    DirtyBuffer* dirty = dirty_buffer(buffer);
+    DirtyRect r = { x0, y0, x1, y1 };
+
+    if (dirty) rect_union(&dirty->drawn, &r);
+}
+
+// Take what has been drawn on a buffer, as it's handed over to be shown
+static DirtyRect dirty_take(const void* buffer)
+{
+    DirtyBuffer* dirty = dirty_buffer(buffer);
+    DirtyRect drawn = { 0, 0, DIRTY_ALL, DIRTY_ALL };
+
+    if (dirty) {
+        drawn = dirty->drawn;
+        memset(&dirty->drawn, 0, sizeof(dirty->drawn));
+    }
+    return drawn;
+}
+
+// New buffers start out drawn on all over and never shown
+static void dirty_reset(void* const* buffers, int count)
+{
+    memset(g_dirty, 0, sizeof(g_dirty));
+    for (int i = 0; i < count && i < DIRTY_BUFFERS; i++) {
+        g_dirty[i].buffer = buffers[i];
+        dirty_mark(buffers[i], 0, 0, DIRTY_ALL, DIRTY_ALL);
+    }
+    g_shadow_valid = false;
+}
+
+// (Re)allocate the screen bitmaps at the current render scale and format
+static int alloc_screen_bitmaps(void)
+{
+    int width = g_screen_width * g_render_scale;
+    int height = g_screen_height * g_render_scale;
+    int bpp = screen_bytes_per_pixel();
+
+    void* buffers[3];
+
+    buffers[0] = calloc((size_t)width * height, bpp);
+    buffers[1] = calloc((size_t)width * height, bpp);
+    buffers[2] = calloc((size_t)width * height, bpp);
+    if (!buffers[0] || !buffers[1] || !buffers[2]) {
+        printf("ERROR: Can't allocate %dx%d screen bitmaps\n", width, height);
+        free(buffers[0]);
+        free(buffers[1]);
+        free(buffers[2]);
+        return -1;
+    }
+
+    present_sync();
+    free(g_spare_buffer);
+    g_spare_buffer = buffers[2];
+    dirty_reset(buffers, 3);
+
+    for (int i = 0; i < 2; i++) {
+        free(g_bitmaps[i].bm_Buffer);
+
+        g_bitmaps[i].bm_Buffer = buffers[i];
+        g_bitmaps[i].bm_Width = width;
+        g_bitmaps[i].bm_Height = height;
+        g_bitmaps[i].bm_BytesPerRow = width * bpp;
+        g_bitmaps[i].bm_Format = g_screen_format;
+
+        g_screens[i].sc_Width = width;
+        g_screens[i].sc_Height = height;
+    }
+
+    // Supersampled screens are filtered down to the window, not point sampled
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, g_render_scale > 1 ? "linear" : "nearest");
+    return 0;
+}
+
+// Select the internal render resolution as a multiple of the 3DO screen.
+// Screens that already exist are reallocated at the new size.
+int platform_set_render_scale(int scale)
+{
+    int old_scale = g_render_scale;
+
+    if (scale < 1) scale = 1;
+    if (scale > MAX_RENDER_SCALE) scale = MAX_RENDER_SCALE;
+    if (scale == g_render_scale) return g_render_scale;
+
+    // On failure the old bitmaps are untouched
+    g_render_scale = scale;
+    if (g_num_screens && alloc_screen_bitmaps() < 0) {
+        g_render_scale = old_scale;
+    }
+    return g_render_scale;
+}
+
+int platform_get_render_scale(void)
+{
+    return g_render_scale;
+}
+
+void platform_set_rgb555_screens(bool enabled)
+{
+    int old_format = g_screen_format;
+
+    g_screen_format = enabled ? BMF_RGB555 : BMF_RGBA32;
+    if (g_screen_format != old_format && g_num_screens && alloc_screen_bitmaps() < 0) {
+        g_screen_format = old_format;
+    }
+}
+
+void platform_set_dynamic_resolution(bool enabled, int min_scale, int max_scale, double target_ms)
+{
+    if (min_scale < 1) min_scale = 1;
+    if (max_scale > MAX_RENDER_SCALE) max_scale = MAX_RENDER_SCALE;
+
+    g_dynres_enabled = enabled;
+    res_governor_init(&g_governor, min_scale, max_scale, g_render_scale, target_ms);
+    if (enabled) {
+        printf("Dynamic resolution: %dx-%dx, %.1f ms budget\n", g_governor.min_scale,
+               g_governor.max_scale, target_ms);
+    }
+}
+
+int platform_govern_resolution(double frame_ms)
+{
+    if (g_dynres_enabled) {
+        int scale = res_governor_update(&g_governor, frame_ms);
+        if (platform_set_render_scale(scale) != scale) {
+            // Couldn't get the memory; stay where we are
+            res_governor_init(&g_governor, g_governor.min_scale, g_governor.max_scale,
+                              g_render_scale, g_governor.target_ms);
+        }
+        platform_perf_set("frame_budget_ms", g_governor.target_ms);
+        platform_perf_set("frame_cost_ms", g_governor.avg_ms);
+    }
+    platform_perf_set("render_scale", g_render_scale);
+    return g_render_scale;
+}
+
+void platform_set_adaptive_draw_distance(bool enabled, double min_dist, double max_dist,
+                                         double target_ms)
+{
+    g_drawdist_enabled = enabled;
+    dist_governor_init(&g_dist_governor, min_dist, max_dist, target_ms);
+    if (enabled) {
+        printf("Adaptive draw distance: %.1f-%.1f cells, %.1f ms budget\n",
+               g_dist_governor.min_dist, g_dist_governor.max_dist, target_ms);
+    }
+}
+
+frac16 platform_govern_draw_distance(double cost_ms, frac16 dist)
+{
+    if (g_drawdist_enabled) {
+        double d = dist_governor_update(&g_dist_governor, cost_ms, dist / 65536.0);
+
+        dist = (frac16)(d * 65536.0);
+        platform_perf_set("draw_budget_ms", g_dist_governor.target_ms);
+        platform_perf_set("draw_cost_ms", g_dist_governor.avg_ms);
+    }
+    platform_perf_set("draw_distance", dist / 65536.0);
+    return dist;
+}
+
 // Graphics initialization
 int platform_init_graphics(int width, int height, bool fullscreen)
 {
@@ -113,6 +606,10 @@ int platform_init_graphics(int width, int height, bool fullscreen)
     // Initialize graphics base
     g_graphics_base.gf_VRAMPageSize = 2048; // Simulate 3DO VRAM page size
 
+    if (g_present_async) {
+        start_present_thread();
+    }
+
     printf("Graphics initialized: %dx%d (window: %dx%d)\n", 
            g_screen_width, g_screen_height, g_window_width, g_window_height);
 
@@ -121,6 +618,16 @@ int platform_init_graphics(int width, int height, bool fullscreen)
 
 void platform_shutdown_graphics(void)
 {
+    stop_raster_workers();
+    g_raster_bands = 1;
+    raster_list_free(&g_cel_list);
+    capture_stop();
+
+    stop_present_thread();
+    stop_upscale_workers();
+    upscaler_free(&g_upscaler);
+    release_present_textures();
+
     if (g_gl_context) {
         SDL_GL_DeleteContext(g_gl_context);
         g_gl_context = NULL;
@@ -153,20 +660,15 @@ void CloseGraphicsFolio(void)
 
 int CreateScreenGroup(Item* screen_items, void* tags)
 {
+    if (alloc_screen_bitmaps() < 0) {
+        return -1;
+    }
+
     // Create simulated screens
     for (int i = 0; i < 2; i++) {
-        // Initialize bitmap
-        g_bitmaps[i].bm_Buffer = malloc(g_screen_width * g_screen_height * 4); // RGBA
-        g_bitmaps[i].bm_Width = g_screen_width;
-        g_bitmaps[i].bm_Height = g_screen_height;
-        g_bitmaps[i].bm_BytesPerRow = g_screen_width * 4;
-        g_bitmaps[i].bm_Format = 0; // RGBA
-
         // Initialize screen
         g_screens[i].sc_ScreenItem = i + 1;
         g_screens[i].sc_Bitmap = &g_bitmaps[i];
-        g_screens[i].sc_Width = g_screen_width;
-        g_screens[i].sc_Height = g_screen_height;
 
         // Initialize rastport
         g_rastports[i].rp_ScreenItem = i + 1;
@@ -174,6 +676,7 @@ int CreateScreenGroup(Item* screen_items, void* tags)
         g_rastports[i].rp_Bitmap = &g_bitmaps[i];
         g_rastports[i].rp_ScreenPtr = &g_screens[i];
 
+        g_screen_fade[i][0] = g_screen_fade[i][1] = g_screen_fade[i][2] = 256;
         screen_items[i] = i + 1;
     }
 
@@ -189,259 +692,939 @@ RastPort* platform_get_rastport(int index) {
     return NULL;
 }
 
+// Ready an area of a screen's pixels for display into dst, which points
+// at the area's top left: RGB555 is widened and faded screens scaled on
+// the way, anything else is copied
+static void present_pixels(uint32* dst, int dst_pitch, const Bitmap* bitmap, const int32* fade,
+                           const DirtyRect* area)
+{
+    int width = area->x1 - area->x0, height = area->y1 - area->y0;
+    bool rgb555 = bitmap->bm_Format == BMF_RGB555;
+    bool faded = fade[0] != 256 || fade[1] != 256 || fade[2] != 256;
+    const ubyte* src = (const ubyte*)bitmap->bm_Buffer + (size_t)area->y0 * bitmap->bm_BytesPerRow +
+                       (size_t)area->x0 * (rgb555 ? 2 : 4);
+    size_t n = width;
+
+    // One call for the whole area when neither side pads its rows
+    if (dst_pitch == width * 4 && bitmap->bm_BytesPerRow == width * (rgb555 ? 2 : 4)) {
+        n *= height;
+        height = 1;
+    }
+
+    for (int y = 0; y < height; y++) {
+        uint32* d = (uint32*)((ubyte*)dst + (size_t)y * dst_pitch);
+        const void* s = src + (size_t)y * bitmap->bm_BytesPerRow;
+        if (rgb555 && faded) {
+            raster_fade_rgb555_to_rgba32(d, (const uint16*)s, n, fade[0], fade[1], fade[2]);
+        } else if (rgb555) {
+            raster_rgb555_to_rgba32(d, (const uint16*)s, n);
+        } else if (faded) {
+            raster_fade_rgba32(d, (const uint32*)s, n, fade[0], fade[1], fade[2]);
+        } else {
+            memcpy(d, s, n * sizeof(uint32));
+        }
+    }
+}
+
+static const char* present_counter(const Bitmap* bitmap, const int32* fade)
+{
+    if (bitmap->bm_Format == BMF_RGB555) return "present_widen";
+    if (fade[0] != 256 || fade[1] != 256 || fade[2] != 256) return "present_fade";
+    return "present_copy";
+}
+
+static void release_present_textures(void)
+{
+    if (g_present_texture) {
+        SDL_DestroyTexture(g_present_texture);
+        g_present_texture = NULL;
+    }
+    if (g_present_gl_texture) {
+        glDeleteTextures(1, &g_present_gl_texture);
+        g_present_gl_texture = 0;
+    }
+    g_present_width = g_present_height = 0;
+}
+
+// Buffer for frames that have to be readied before they're used
+static uint32* present_staging(int width, int height)
+{
+    size_t n = (size_t)width * height;
+
+    if (n > g_present_size) {
+        uint32* pixels = (uint32*)realloc(g_present_pixels, n * sizeof(uint32));
+        if (!pixels) {
+            printf("ERROR: Can't allocate %dx%d display buffer\n", width, height);
+            return NULL;
+        }
+        g_present_pixels = pixels;
+        g_present_size = n;
+    }
+    return g_present_pixels;
+}
+
+// Work out the area of a frame the texture needs: the box drawn on since
+// its buffer was last handed over, and whatever other buffers have
+// changed in the texture since it was last shown, narrowed down to the
+// pixels that differ from the copy of what the texture holds.  The copy
+// is brought up to date on the way.  The first frame after anything the
+// copy can't account for (a new fade, size or texture) is sent whole.
+static DirtyRect present_dirty_area(const Bitmap* bitmap, const int32* fade, const DirtyRect* drawn)
+{
+    int width = bitmap->bm_Width, height = bitmap->bm_Height;
+    int bpp = bitmap->bm_Format == BMF_RGB555 ? 2 : 4;
+    size_t bpr = (size_t)width * bpp;
+    const ubyte* src = (const ubyte*)bitmap->bm_Buffer;
+    DirtyBuffer* dirty = dirty_buffer(bitmap->bm_Buffer);
+    DirtyRect all = { 0, 0, width, height };
+    DirtyRect area = { 0, 0, 0, 0 };
+
+    if (!g_dirty_present || !dirty) {
+        g_shadow_valid = false;
+        return all;
+    }
+
+    // Gameplay changes every frame all over; it goes whole, without the
+    // copy, and is looked at again every so often
+    if (g_dirty_skip > 0) {
+        g_dirty_skip--;
+        g_shadow_valid = false;
+        return all;
+    }
+
+    if (!g_shadow_valid || !dirty->shown || g_shadow_width != width ||
+        g_shadow_height != height || g_shadow_format != (int32)bitmap->bm_Format ||
+        memcmp(g_shadow_fade, fade, sizeof(g_shadow_fade)) != 0) {
+        if (bpr * height > g_shadow_size) {
+            ubyte* shadow = (ubyte*)realloc(g_shadow, bpr * height);
+            if (!shadow) {
+                g_shadow_valid = false;
+                return all;
+            }
+            g_shadow = shadow;
+            g_shadow_size = bpr * height;
+        }
+        for (int y = 0; y < height; y++) {
+            memcpy(g_shadow + y * bpr, src + (size_t)y * bitmap->bm_BytesPerRow, bpr);
+        }
+        g_shadow_width = width;
+        g_shadow_height = height;
+        g_shadow_format = bitmap->bm_Format;
+        memcpy(g_shadow_fade, fade, sizeof(g_shadow_fade));
+        g_shadow_valid = true;
+        for (int i = 0; i < DIRTY_BUFFERS; i++) {
+            g_dirty[i].shown = &g_dirty[i] == dirty;
+            memset(&g_dirty[i].stale, 0, sizeof(g_dirty[i].stale));
+        }
+        return all;
+    }
+
+    DirtyRect check = dirty->stale;
+    rect_union(&check, drawn);
+    if (check.x0 < 0) check.x0 = 0;
+    if (check.y0 < 0) check.y0 = 0;
+    if (check.x1 > width) check.x1 = width;
+    if (check.y1 > height) check.y1 = height;
+
+    int32 box[4] = { check.x0, check.y0, check.x1, check.y1 };
+    if (raster_diff_box(src, bitmap->bm_BytesPerRow, g_shadow, bpr, bpp, box)) {
+        area.x0 = box[0];
+        area.y0 = box[1];
+        area.x1 = box[2];
+        area.y1 = box[3];
+    }
+
+    // Mostly changed, it wasn't worth comparing; back off for twice as
+    // many frames as last time
+    if ((double)(area.x1 - area.x0) * (area.y1 - area.y0) * 2.0 > (double)width * height) {
+        if (g_dirty_misses < DIRTY_MAX_MISSES) g_dirty_misses++;
+        g_dirty_skip = (1 << g_dirty_misses) - 1;
+    } else {
+        g_dirty_misses = 0;
+    }
+
+    memset(&dirty->stale, 0, sizeof(dirty->stale));
+    for (int i = 0; i < DIRTY_BUFFERS; i++) {
+        if (&g_dirty[i] != dirty) rect_union(&g_dirty[i].stale, &area);
+    }
+    return area;
+}
+
+void platform_set_dirty_present(bool enabled)
+{
+    present_sync();
+    g_dirty_present = enabled;
+    g_shadow_valid = false;
+    g_dirty_misses = g_dirty_skip = 0;
+}
+
+static int SDLCALL upscale_worker_main(void* data)
+{
+    UpscaleWorker* worker = (UpscaleWorker*)data;
+
+    for (;;) {
+        SDL_SemWait(worker->go);
+        if (g_upscale_quit) break;
+        upscale_rows(&g_upscaler, g_upscale_dst, g_upscale_dst_pitch, g_upscale_src,
+                     g_upscale_src_pitch, worker->top, worker->bottom);
+        SDL_SemPost(g_upscale_done);
+    }
+    return 0;
+}
+
+static void stop_upscale_workers(void)
+{
+    g_upscale_quit = 1;
+    for (int i = 0; i < g_upscale_nworkers; i++) {
+        SDL_SemPost(g_upscale_workers[i].go);
+    }
+    for (int i = 0; i < g_upscale_nworkers; i++) {
+        SDL_WaitThread(g_upscale_workers[i].thread, NULL);
+        SDL_DestroySemaphore(g_upscale_workers[i].go);
+        g_upscale_workers[i].thread = NULL;
+        g_upscale_workers[i].go = NULL;
+    }
+    if (g_upscale_done) {
+        SDL_DestroySemaphore(g_upscale_done);
+        g_upscale_done = NULL;
+    }
+    g_upscale_nworkers = 0;
+    g_upscale_quit = 0;
+}
+
+// Upscale a frame into dst, the calling thread taking the first band
+static void upscale_frame(uint32* dst, int32 dst_pitch, const uint32* src, int32 src_pitch)
+{
+    int bands = g_upscale_nworkers + 1;
+    int32 band = (g_upscaler.height + bands - 1) / bands;
+
+    g_upscale_dst = dst;
+    g_upscale_dst_pitch = dst_pitch;
+    g_upscale_src = src;
+    g_upscale_src_pitch = src_pitch;
+    for (int i = 0; i < g_upscale_nworkers; i++) {
+        g_upscale_workers[i].top = (i + 1) * band;
+        g_upscale_workers[i].bottom = (i + 2) * band;
+        SDL_SemPost(g_upscale_workers[i].go);
+    }
+    upscale_rows(&g_upscaler, dst, dst_pitch, src, src_pitch, 0, band);
+    for (int i = 0; i < g_upscale_nworkers; i++) {
+        SDL_SemWait(g_upscale_done);
+    }
+}
+
+int platform_set_upscale(int mode, int threads)
+{
+    static const char* names[] = { "off", "integer", "sharp bilinear", "scanline" };
+
+    if (mode < UPSCALE_NONE || mode > UPSCALE_SCANLINE) mode = UPSCALE_NONE;
+    if (threads <= 0) threads = SDL_GetCPUCount();
+    if (threads > MAX_UPSCALE_BANDS) threads = MAX_UPSCALE_BANDS;
+
+    present_sync();
+    stop_upscale_workers();
+    upscaler_free(&g_upscaler);
+    g_upscale_mode = mode;
+
+    if (mode != UPSCALE_NONE && threads > 1 && (g_upscale_done = SDL_CreateSemaphore(0))) {
+        for (int i = 0; i < threads - 1; i++) {
+            UpscaleWorker* worker = &g_upscale_workers[i];
+
+            if (!(worker->go = SDL_CreateSemaphore(0))) break;
+            if (!(worker->thread = SDL_CreateThread(upscale_worker_main, "upscale", worker))) {
+                SDL_DestroySemaphore(worker->go);
+                worker->go = NULL;
+                break;
+            }
+            g_upscale_nworkers++;
+        }
+    }
+
+    if (mode != UPSCALE_NONE) {
+        printf("Window upscaling: %s, %d band(s), %s\n", names[mode], g_upscale_nworkers + 1,
+               upscale_cpu());
+    }
+    return g_upscale_mode;
+}
+
+// One texture, made again only when the screens change size.  Returns 1
+// if it was, when it holds nothing the copy of it can vouch for.
+static int size_present_texture(int width, int height)
+{
+    if (width == g_present_width && height == g_present_height) {
+        return 0;
+    }
+
+    release_present_textures();
+    if (g_use_opengl) {
+        glGenTextures(1, &g_present_gl_texture);
+        glBindTexture(GL_TEXTURE_2D, g_present_gl_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    } else {
+        g_present_texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32,
+                                              SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (!g_present_texture) {
+            printf("ERROR: Failed to create %dx%d display texture: %s\n", width, height,
+                   SDL_GetError());
+            return -1;
+        }
+    }
+    g_present_width = width;
+    g_present_height = height;
+    return 1;
+}
+
+static int present_gl(const Bitmap* bitmap, const int32* fade, const DirtyRect* drawn)
+{
+    int width = bitmap->bm_Width, height = bitmap->bm_Height;
+    int made = size_present_texture(width, height);
+
+    if (made < 0) {
+        return -1;
+    }
+    if (made) {
+        g_shadow_valid = false;
+    }
+
+    DirtyRect area = present_dirty_area(bitmap, fade, drawn);
+    int area_width = area.x1 - area.x0, area_height = area.y1 - area.y0;
+    platform_perf_set("present_dirty_pct", rect_empty(&area) ? 0.0 :
+                      100.0 * area_width * area_height / ((double)width * height));
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindTexture(GL_TEXTURE_2D, g_present_gl_texture);
+
+    // GL uploads from client memory, so only screens that need readying
+    // go through the staging buffer
+    if (!rect_empty(&area)) {
+        bool faded = fade[0] != 256 || fade[1] != 256 || fade[2] != 256;
+        if (bitmap->bm_Format == BMF_RGB555 || faded) {
+            uint32* staging = present_staging(area_width, area_height);
+            if (!staging) {
+                g_shadow_valid = false;
+                return -1;
+            }
+            platform_perf_start(present_counter(bitmap, fade));
+            present_pixels(staging, area_width * 4, bitmap, fade, &area);
+            platform_perf_end(present_counter(bitmap, fade));
+            glTexSubImage2D(GL_TEXTURE_2D, 0, area.x0, area.y0, area_width, area_height, GL_RGBA,
+                            GL_UNSIGNED_BYTE, staging);
+        } else {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap->bm_BytesPerRow / 4);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, area.x0, area.y0, area_width, area_height, GL_RGBA,
+                            GL_UNSIGNED_BYTE, (const ubyte*)bitmap->bm_Buffer +
+                            (size_t)area.y0 * bitmap->bm_BytesPerRow + (size_t)area.x0 * 4);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+    }
+
+    // Render fullscreen quad (simplified)
+    glEnable(GL_TEXTURE_2D);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 1); glVertex2f(-1, -1);
+    glTexCoord2f(1, 1); glVertex2f(1, -1);
+    glTexCoord2f(1, 0); glVertex2f(1, 1);
+    glTexCoord2f(0, 0); glVertex2f(-1, 1);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+
+    SDL_GL_SwapWindow(g_window);
+    return 0;
+}
+
+// Ready the part of the frame that changed straight into the texture's
+// memory and show it.  With an upscale mode the texture is the size it
+// will be on the window and gets the whole frame, and frames that need
+// readying are readied into the staging buffer first.
+static int present_renderer(const Bitmap* bitmap, const int32* fade, const DirtyRect* drawn)
+{
+    int width = bitmap->bm_Width, height = bitmap->bm_Height;
+    int win_width = 0, win_height = 0;
+    bool upscale = false;
+    void* pixels;
+    int pitch;
+    int made;
+    int result = 0;
+
+    if (g_upscale_mode != UPSCALE_NONE &&
+        SDL_GetRendererOutputSize(g_renderer, &win_width, &win_height) == 0 &&
+        upscaler_setup(&g_upscaler, g_upscale_mode, width, height, win_width, win_height) == 0) {
+        upscale = true;
+        width = g_upscaler.width;
+        height = g_upscaler.height;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    DirtyRect all = { 0, 0, bitmap->bm_Width, bitmap->bm_Height };
+    DirtyRect area = all;
+    SDL_Rect locked;
+    if ((made = size_present_texture(width, height)) < 0) {
+        result = -1;
+    } else if (!upscale) {
+        if (made) {
+            g_shadow_valid = false;
+        }
+        area = present_dirty_area(bitmap, fade, drawn);
+    } else {
+        // The texture no longer matches the copy
+        g_shadow_valid = false;
+    }
+    locked.x = area.x0;
+    locked.y = area.y0;
+    locked.w = area.x1 - area.x0;
+    locked.h = area.y1 - area.y0;
+
+    if (result < 0 || rect_empty(&area)) {
+        // Nothing to upload
+    } else if (SDL_LockTexture(g_present_texture, upscale ? NULL : &locked, &pixels, &pitch) < 0) {
+        printf("ERROR: Can't lock display texture: %s\n", SDL_GetError());
+        g_shadow_valid = false;
+        result = -1;
+    } else if (upscale) {
+        const uint32* src = (const uint32*)bitmap->bm_Buffer;
+        int32 src_pitch = bitmap->bm_BytesPerRow / 4;
+        if (bitmap->bm_Format == BMF_RGB555 || fade[0] != 256 || fade[1] != 256 || fade[2] != 256) {
+            uint32* staging = present_staging(bitmap->bm_Width, bitmap->bm_Height);
+            if (staging) {
+                present_pixels(staging, bitmap->bm_Width * 4, bitmap, fade, &all);
+            }
+            src = staging;
+            src_pitch = bitmap->bm_Width;
+        }
+        if (src) {
+            upscale_frame((uint32*)pixels, pitch / 4, src, src_pitch);
+        } else {
+            result = -1;
+        }
+        SDL_UnlockTexture(g_present_texture);
+    } else {
+        present_pixels((uint32*)pixels, pitch, bitmap, fade, &area);
+        SDL_UnlockTexture(g_present_texture);
+    }
+
+    platform_perf_set("present_ready_ms", (double)(SDL_GetPerformanceCounter() - start) *
+                      1000.0 / (double)SDL_GetPerformanceFrequency());
+    platform_perf_set("present_dirty_pct", rect_empty(&area) ? 0.0 :
+                      100.0 * locked.w * locked.h / ((double)all.x1 * all.y1));
+    if (result < 0) {
+        return result;
+    }
+
+    // Whole multiples are shown unfiltered, centered on the window
+    SDL_Rect rect = { (win_width - width) / 2, (win_height - height) / 2, width, height };
+    bool centered = upscale && width <= win_width && height <= win_height;
+
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+    SDL_RenderClear(g_renderer);
+    SDL_RenderCopy(g_renderer, g_present_texture, NULL, centered ? &rect : NULL);
+    SDL_RenderPresent(g_renderer);
+    return 0;
+}
+
+// Present thread: what present_renderer() does up to the upload, into a
+// slot of staging memory instead of the texture.  The output size comes
+// with the frame, as nothing of the renderer may be touched here.
+static void present_convert(const PresentFrame* frame, PresentReady* ready)
+{
+    const Bitmap* bitmap = &frame->bitmap;
+    const int32* fade = frame->fade;
+    int width = bitmap->bm_Width, height = bitmap->bm_Height;
+    DirtyRect all = { 0, 0, width, height };
+    DirtyRect area;
+    size_t n;
+
+    ready->upscale = false;
+    ready->failed = false;
+    ready->win_width = frame->win_width;
+    ready->win_height = frame->win_height;
+    ready->queued = frame->queued;
+    if (g_upscale_mode != UPSCALE_NONE && frame->win_width > 0 && frame->win_height > 0 &&
+        upscaler_setup(&g_upscaler, g_upscale_mode, width, height, frame->win_width,
+                       frame->win_height) == 0) {
+        ready->upscale = true;
+        width = g_upscaler.width;
+        height = g_upscaler.height;
+        area.x0 = area.y0 = 0;
+        area.x1 = width;
+        area.y1 = height;
+        // The texture no longer matches the copy
+        g_shadow_valid = false;
+    } else {
+        area = present_dirty_area(bitmap, fade, &frame->drawn);
+    }
+    ready->width = width;
+    ready->height = height;
+    ready->area = area;
+    if (rect_empty(&area)) {
+        return;
+    }
+
+    n = (size_t)(area.x1 - area.x0) * (area.y1 - area.y0);
+    if (n > ready->size) {
+        uint32* pixels = (uint32*)realloc(ready->pixels, n * sizeof(uint32));
+        if (!pixels) {
+            printf("ERROR: Can't allocate %dx%d display buffer\n", area.x1 - area.x0,
+                   area.y1 - area.y0);
+            ready->failed = true;
+            return;
+        }
+        ready->pixels = pixels;
+        ready->size = n;
+    }
+
+    if (ready->upscale) {
+        const uint32* src = (const uint32*)bitmap->bm_Buffer;
+        int32 src_pitch = bitmap->bm_BytesPerRow / 4;
+        if (bitmap->bm_Format == BMF_RGB555 || fade[0] != 256 || fade[1] != 256 || fade[2] != 256) {
+            src = present_staging(bitmap->bm_Width, bitmap->bm_Height);
+            if (src) {
+                present_pixels((uint32*)src, bitmap->bm_Width * 4, bitmap, fade, &all);
+            }
+            src_pitch = bitmap->bm_Width;
+        }
+        if (src) {
+            upscale_frame(ready->pixels, width, src, src_pitch);
+        } else {
+            ready->failed = true;
+        }
+    } else {
+        present_pixels(ready->pixels, (area.x1 - area.x0) * 4, bitmap, fade, &area);
+    }
+}
+
+// Game thread: upload a readied frame and show it
+static void present_show(const PresentReady* ready)
+{
+    int width = ready->width, height = ready->height;
+    int win_width = ready->win_width, win_height = ready->win_height;
+    const DirtyRect* area = &ready->area;
+    bool whole = area->x0 == 0 && area->y0 == 0 && area->x1 == width && area->y1 == height;
+    bool lost = ready->failed;
+    int made = 0;
+
+    if (!lost && (made = size_present_texture(width, height)) < 0) {
+        lost = true;
+    }
+    if (!lost && !rect_empty(area)) {
+        SDL_Rect rect = { area->x0, area->y0, area->x1 - area->x0, area->y1 - area->y0 };
+
+        if (SDL_UpdateTexture(g_present_texture, &rect, ready->pixels, rect.w * 4) < 0) {
+            printf("ERROR: Can't update display texture: %s\n", SDL_GetError());
+            lost = true;
+        }
+    }
+    // A new texture holds only what was just uploaded
+    if (lost || (made && !whole)) {
+        SDL_LockMutex(g_present_lock);
+        g_present_lost = true;
+        SDL_UnlockMutex(g_present_lock);
+        if (lost) return;
+    }
+
+    SDL_Rect rect = { (win_width - width) / 2, (win_height - height) / 2, width, height };
+    bool centered = ready->upscale && width <= win_width && height <= win_height;
+
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+    SDL_RenderClear(g_renderer);
+    SDL_RenderCopy(g_renderer, g_present_texture, NULL, centered ? &rect : NULL);
+    SDL_RenderPresent(g_renderer);
+
+    double latency = (double)(SDL_GetPerformanceCounter() - ready->queued) * 1000.0 /
+                     (double)SDL_GetPerformanceFrequency();
+    g_present_latency += (latency - g_present_latency) * 0.125;
+}
+
+// Show the frame the present thread last readied, if it has one waiting.
+// Call only from the game thread.
+static void present_flush(void)
+{
+    const PresentReady* ready = NULL;
+
+    if (!g_present_thread) return;
+
+    SDL_LockMutex(g_present_lock);
+    if (g_present_has_ready) {
+        // The thread readies into the other slot meanwhile
+        ready = &g_present_slots[g_present_fill ^ 1];
+        g_present_has_ready = false;
+        SDL_CondSignal(g_present_wake);
+    }
+    SDL_UnlockMutex(g_present_lock);
+    if (ready) {
+        present_show(ready);
+    }
+}
+
+static int SDLCALL present_main(void* data)
+{
+    SDL_LockMutex(g_present_lock);
+    for (;;) {
+        // A readied frame is left alone until the game thread has it
+        while ((!g_present_has_pending || g_present_has_ready) && !g_present_quit) {
+            SDL_CondWait(g_present_wake, g_present_lock);
+        }
+        if (g_present_quit) break;
+
+        PresentFrame frame = g_present_pending;
+        PresentReady* ready = &g_present_slots[g_present_fill];
+        bool lost = g_present_lost;
+        g_present_has_pending = false;
+        g_present_lost = false;
+        g_present_busy = true;
+        g_present_reading = frame.bitmap.bm_Buffer;
+        SDL_UnlockMutex(g_present_lock);
+
+        if (lost) {
+            g_shadow_valid = false;
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        present_convert(&frame, ready);
+        double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+                    (double)SDL_GetPerformanceFrequency();
+        double dirty = rect_empty(&ready->area) ? 0.0 :
+                       100.0 * (ready->area.x1 - ready->area.x0) * (ready->area.y1 - ready->area.y0) /
+                       ((double)ready->width * ready->height);
+
+        // The perf counters belong to the game thread, so the timing is
+        // left for DisplayScreen() to report
+        SDL_LockMutex(g_present_lock);
+        g_present_ready += (ms - g_present_ready) * 0.125;
+        g_present_dirty += (dirty - g_present_dirty) * 0.125;
+        g_present_reading = NULL;
+        g_present_fill ^= 1;
+        g_present_has_ready = true;
+        g_present_busy = false;
+        SDL_CondBroadcast(g_present_done);
+    }
+    SDL_UnlockMutex(g_present_lock);
+    return 0;
+}
+
+// Is the present thread holding on to this buffer?
+static bool present_in_flight(const void* buffer)
+{
+    return (g_present_has_pending && g_present_pending.bitmap.bm_Buffer == buffer) ||
+           g_present_reading == buffer;
+}
+
+// Block until the present thread is done reading a buffer, before it's
+// drawn on.  Frames it readies meanwhile are shown, as it won't take the
+// next one until they are.
+static void present_wait(const void* buffer)
+{
+    if (!g_present_thread || !buffer) return;
+
+    SDL_LockMutex(g_present_lock);
+    while (present_in_flight(buffer)) {
+        if (g_present_has_ready) {
+            SDL_UnlockMutex(g_present_lock);
+            present_flush();
+            SDL_LockMutex(g_present_lock);
+        } else {
+            SDL_CondWait(g_present_done, g_present_lock);
+        }
+    }
+    SDL_UnlockMutex(g_present_lock);
+}
+
+// Block until every frame handed over has been shown, before the screens
+// or the present thread's state are touched from this thread
+static void present_sync(void)
+{
+    if (!g_present_thread) return;
+
+    SDL_LockMutex(g_present_lock);
+    while (g_present_has_pending || g_present_busy || g_present_has_ready) {
+        if (g_present_has_ready) {
+            SDL_UnlockMutex(g_present_lock);
+            present_flush();
+            SDL_LockMutex(g_present_lock);
+        } else {
+            SDL_CondWait(g_present_done, g_present_lock);
+        }
+    }
+    SDL_UnlockMutex(g_present_lock);
+}
+
+static void stop_present_thread(void)
+{
+    if (g_present_thread) {
+        present_sync();
+        SDL_LockMutex(g_present_lock);
+        g_present_quit = true;
+        SDL_CondSignal(g_present_wake);
+        SDL_UnlockMutex(g_present_lock);
+        SDL_WaitThread(g_present_thread, NULL);
+        g_present_thread = NULL;
+    }
+    if (g_present_wake) SDL_DestroyCond(g_present_wake);
+    if (g_present_done) SDL_DestroyCond(g_present_done);
+    if (g_present_lock) SDL_DestroyMutex(g_present_lock);
+    for (int i = 0; i < 2; i++) {
+        free(g_present_slots[i].pixels);
+    }
+    memset(g_present_slots, 0, sizeof(g_present_slots));
+    g_present_wake = g_present_done = NULL;
+    g_present_lock = NULL;
+    g_present_quit = false;
+    g_present_fill = 0;
+    g_present_has_ready = false;
+    g_present_lost = false;
+    g_shadow_valid = false;
+}
+
+// GL uploads from the frame's own memory already, so only the renderer
+// path readies frames on another thread
+static void start_present_thread(void)
+{
+    if (g_present_thread || g_use_opengl || !g_renderer) return;
+
+    g_present_lock = SDL_CreateMutex();
+    g_present_wake = SDL_CreateCond();
+    g_present_done = SDL_CreateCond();
+    if (g_present_lock && g_present_wake && g_present_done) {
+        g_present_thread = SDL_CreateThread(present_main, "present", NULL);
+    }
+    if (!g_present_thread) {
+        printf("Can't start present thread: %s\n", SDL_GetError());
+        stop_present_thread();
+    }
+}
+
+void platform_set_async_present(bool enabled)
+{
+    g_present_async = enabled;
+    if (enabled) {
+        start_present_thread();
+    } else {
+        stop_present_thread();
+    }
+}
+
 int DisplayScreen(Item screen_item, uint32 value)
 {
-    printf("=== DisplayScreen() called: item=%d, value=%u ===\n", screen_item, value);
-    
-    // Find the screen
     if (screen_item < 1 || screen_item > g_num_screens) {
         printf("ERROR: Invalid screen_item %d (valid range: 1-%d)\n", screen_item, g_num_screens);
         return -1;
     }
 
     Screen* screen = &g_screens[screen_item - 1];
-    printf("Screen: %p, bitmap: %p, dimensions: %dx%d\n", 
-           screen, screen->sc_Bitmap, screen->sc_Width, screen->sc_Height);
-    
-    if (!screen->sc_Bitmap || !screen->sc_Bitmap->bm_Buffer) {
+    Bitmap* bitmap = screen->sc_Bitmap;
+    if (!bitmap || !bitmap->bm_Buffer) {
         printf("ERROR: Screen bitmap or buffer is NULL\n");
         return -1;
     }
-    
-    printf("Buffer: %p, BytesPerRow: %d\n", 
-           screen->sc_Bitmap->bm_Buffer, screen->sc_Bitmap->bm_BytesPerRow);
-    
-    if (g_use_opengl) {
-        printf("Using OpenGL rendering...\n");
-        // OpenGL rendering
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        // Upload screen buffer as texture and render
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, screen->sc_Width, screen->sc_Height, 
-                     0, GL_RGBA, GL_UNSIGNED_BYTE, screen->sc_Bitmap->bm_Buffer);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    const int32* fade = g_screen_fade[screen_item - 1];
+    g_shown_screen = screen_item;
+    capture_frame();
+
+    if (!g_present_thread) {
+        DirtyRect drawn = dirty_take(bitmap->bm_Buffer);
+        if (g_use_opengl) {
+            return present_gl(bitmap, fade, &drawn);
+        }
+        return present_renderer(bitmap, fade, &drawn);
+    }
 
-        // Render fullscreen quad (simplified)
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glBegin(GL_QUADS);
-        glTexCoord2f(0, 1); glVertex2f(-1, -1);
-        glTexCoord2f(1, 1); glVertex2f(1, -1);
-        glTexCoord2f(1, 0); glVertex2f(1, 1);
-        glTexCoord2f(0, 0); glVertex2f(-1, 1);
-        glEnd();
-        glDisable(GL_TEXTURE_2D);
-
-        glDeleteTextures(1, &texture);
-        SDL_GL_SwapWindow(g_window);
-        printf("OpenGL frame rendered and swapped\n");
+    // The last frame readied goes up first, on this thread
+    present_flush();
+    int win_width = 0, win_height = 0;
+    if (g_upscale_mode != UPSCALE_NONE) {
+        SDL_GetRendererOutputSize(g_renderer, &win_width, &win_height);
+    }
 
-    } else {
-        printf("Using SDL2 renderer fallback...\n");
-        // SDL2 renderer fallback
-        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
-        SDL_RenderClear(g_renderer);
-        
-        // Create texture from screen buffer
-        SDL_Texture* texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32,
-                                                SDL_TEXTUREACCESS_STREAMING,
-                                                screen->sc_Width, screen->sc_Height);
-        if (texture) {
-            printf("Created SDL texture, updating with buffer data...\n");
-            
-            // Debug: Check first few pixels to see if we have actual data
-            uint32_t* pixels = (uint32_t*)screen->sc_Bitmap->bm_Buffer;
-            printf("First 8 pixels: 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X 0x%08X\n",
-                   pixels[0], pixels[1], pixels[2], pixels[3], pixels[4], pixels[5], pixels[6], pixels[7]);
-            
-            SDL_UpdateTexture(texture, NULL, screen->sc_Bitmap->bm_Buffer, 
-                            screen->sc_Bitmap->bm_BytesPerRow);
-            SDL_RenderCopy(g_renderer, texture, NULL, NULL);
-            SDL_DestroyTexture(texture);
-            printf("Texture rendered to screen\n");
-        } else {
-            printf("ERROR: Failed to create SDL texture\n");
+    // Hand the frame over; one still waiting is replaced, not queued.  Its
+    // buffer was never shown, so what was drawn on it still counts.
+    SDL_LockMutex(g_present_lock);
+    g_present_depth += ((g_present_has_pending + g_present_busy + g_present_has_ready) -
+                        g_present_depth) * 0.125;
+    if (g_present_has_pending) {
+        const DirtyRect* r = &g_present_pending.drawn;
+        dirty_mark(g_present_pending.bitmap.bm_Buffer, r->x0, r->y0, r->x1, r->y1);
+        g_present_dropped++;
+    }
+    g_present_pending.bitmap = *bitmap;
+    memcpy(g_present_pending.fade, fade, sizeof(g_present_pending.fade));
+    g_present_pending.drawn = dirty_take(bitmap->bm_Buffer);
+    g_present_pending.win_width = win_width;
+    g_present_pending.win_height = win_height;
+    g_present_pending.queued = SDL_GetPerformanceCounter();
+    g_present_has_pending = true;
+    SDL_CondSignal(g_present_wake);
+
+    // A screen whose last frame is still being read swaps its buffer for
+    // the spare rather than making the game wait to draw on it.  When the
+    // present thread keeps up this never happens and the screens keep
+    // their own pixels.
+    int swapped = -1;
+    for (int i = 0; i < g_num_screens; i++) {
+        if (i != screen_item - 1 && present_in_flight(g_bitmaps[i].bm_Buffer) &&
+            !present_in_flight(g_spare_buffer)) {
+            void* buffer = g_bitmaps[i].bm_Buffer;
+            g_bitmaps[i].bm_Buffer = g_spare_buffer;
+            g_spare_buffer = buffer;
+            g_present_spares++;
+            swapped = i;
         }
-        
-        SDL_RenderPresent(g_renderer);
-        printf("SDL frame presented\n");
     }
 
-    printf("=== DisplayScreen() completed ===\n");
+    double depth = g_present_depth, ready = g_present_ready;
+    double dirty = g_present_dirty;
+    uint32 dropped = g_present_dropped, spares = g_present_spares;
+    SDL_UnlockMutex(g_present_lock);
+
+    // Not everything is redrawn every frame, so the spare takes on the
+    // screen's pixels.  The old buffer is only read from now on, so it's
+    // copied outside the lock.
+    if (swapped >= 0) {
+        Bitmap* swap = &g_bitmaps[swapped];
+        memcpy(swap->bm_Buffer, g_spare_buffer, (size_t)swap->bm_BytesPerRow * swap->bm_Height);
+        dirty_mark(swap->bm_Buffer, 0, 0, DIRTY_ALL, DIRTY_ALL);
+    }
+
+    platform_perf_set("present_ready_ms", ready);
+    platform_perf_set("present_dirty_pct", dirty);
+    platform_perf_set("present_latency_ms", g_present_latency);
+    platform_perf_set("present_queue_depth", depth);
+    platform_perf_set("present_dropped", dropped);
+    platform_perf_set("present_spare_swaps", spares);
     return 0;
 }
 
 int DeleteScreenGroup(Item* screen_items)
 {
+    present_sync();
     for (int i = 0; i < g_num_screens; i++) {
         if (g_bitmaps[i].bm_Buffer) {
             free(g_bitmaps[i].bm_Buffer);
             g_bitmaps[i].bm_Buffer = NULL;
         }
     }
+    free(g_spare_buffer);
+    g_spare_buffer = NULL;
+    release_present_textures();
+    g_shadow_valid = false;
+    free(g_present_pixels);
+    g_present_pixels = NULL;
+    g_present_size = 0;
+    free(g_shadow);
+    g_shadow = NULL;
+    g_shadow_size = 0;
+    memset(g_dirty, 0, sizeof(g_dirty));
+    g_shown_screen = 0;
+    free(g_clear_rows);
+    g_clear_rows = NULL;
+    g_clear_height = 0;
+    free(g_hud_bitmap.bm_Buffer);
+    memset(&g_hud_bitmap, 0, sizeof(g_hud_bitmap));
+    g_hud_valid = false;
     g_num_screens = 0;
     return 0;
 }
 
+void platform_fade_screen(Item screen_item, frac16 r, frac16 g, frac16 b)
+{
+    frac16 level[3] = { r, g, b };
+    bool changed = false;
+
+    if (screen_item < 1 || screen_item > g_num_screens) return;
+
+    for (int i = 0; i < 3; i++) {
+        int32 l = level[i] <= 0 ? 0 : level[i] >= 0x10000 ? 256 : level[i] >> 8;
+        if (g_screen_fade[screen_item - 1][i] != l) {
+            g_screen_fade[screen_item - 1][i] = l;
+            changed = true;
+        }
+    }
+
+    // The 3DO's CLUT took effect on the next field; here the frame has to
+    // be shown again
+    if (changed && screen_item == g_shown_screen) {
+        DisplayScreen(screen_item, 0);
+    }
+}
+
 // Drawing functions
 int DrawCels(Item bitmap_item, CCB* ccb)
 {
-    printf("=== DrawCels() Entry ===\n");
-    printf("bitmap_item=%d, ccb=%p\n", bitmap_item, ccb);
-    
     if (!ccb) {
         printf("ERROR: ccb is NULL\n");
         return -1;
     }
-    
-    if (bitmap_item < 1 || bitmap_item > g_num_screens) {
+
+    // The chain is only read here; the rasterizer works from the list
+    raster_list_clear(&g_cel_list);
+    if (raster_list_add_cels(&g_cel_list, ccb) < 0) {
+        printf("ERROR: Out of memory for draw list\n");
+        return -1;
+    }
+    return platform_draw_list(bitmap_item, &g_cel_list);
+}
+
+int platform_draw_list(Item bitmap_item, const RasterDrawList* list)
+{
+    Bitmap* bitmap = lookup_bitmap(bitmap_item);
+    if (!bitmap) {
         printf("ERROR: Invalid bitmap_item %d (valid range: 1-%d)\n", bitmap_item, g_num_screens);
         return -1;
     }
 
-    printf("Getting bitmap for item %d\n", bitmap_item);
-    Bitmap* bitmap = &g_bitmaps[bitmap_item - 1];
-    printf("bitmap=%p, bm_Buffer=%p, dimensions=%dx%d\n", 
-           bitmap, bitmap->bm_Buffer, bitmap->bm_Width, bitmap->bm_Height);
-    
     if (!bitmap->bm_Buffer) {
         printf("ERROR: bitmap buffer is NULL\n");
         return -1;
     }
-    
-    uint32_t* pixels = (uint32_t*)bitmap->bm_Buffer;
-    printf("pixels=%p\n", pixels);
 
-    // Iterate through cel chain
-    CCB* current = ccb;
-    int cel_count = 0;
-    
-    while (current) {
-        cel_count++;
-        printf("\n--- Processing cel #%d ---\n", cel_count);
-        printf("current=%p, Flags=0x%08X\n", current, current->ccb_Flags);
-        
-        if (!(current->ccb_Flags & CCB_SKIP)) {
-            printf("Cel not skipped, checking texture data...\n");
-            
-            // Simple cel rendering - convert cel to bitmap pixels
-            if (!current->platform_texture) {
-                printf("WARNING: platform_texture is NULL\n");
-                goto next_cel;
-            }
-            
-            printf("platform_texture=%p\n", current->platform_texture);
-            
-            if (!current->platform_texture->data) {
-                printf("WARNING: platform_texture->data is NULL\n");
-                goto next_cel;
-            }
-            
-            printf("texture data=%p\n", current->platform_texture->data);
-            
-            // Render cel at specified position
-            int cel_x = ConvertF16_32(current->ccb_XPos);
-            int cel_y = ConvertF16_32(current->ccb_YPos);
-            
-            printf("Cel position: (%d,%d)\n", cel_x, cel_y);
-            
-            // Simple blit operation (needs proper transformation)
-            uint32_t* cel_data = (uint32_t*)current->platform_texture->data;
-            int cel_width = current->ccb_Width;
-            int cel_height = current->ccb_Height;
-            
-            printf("Cel dimensions: %dx%d\n", cel_width, cel_height);
-            printf("cel_data=%p\n", cel_data);
-            
-            // Safety checks
-            if (cel_width <= 0 || cel_height <= 0) {
-                printf("ERROR: Invalid cel dimensions: %dx%d\n", cel_width, cel_height);
-                goto next_cel;
-            }
-            
-            if (cel_width > 1000 || cel_height > 1000) {
-                printf("ERROR: Suspicious cel dimensions: %dx%d (too large)\n", cel_width, cel_height);
-                goto next_cel;
-            }
-            
-            printf("Starting pixel copy loop...\n");
-            printf("Target bitmap: %dx%d\n", bitmap->bm_Width, bitmap->bm_Height);
-            
-            int pixels_copied = 0;
-            
-            for (int y = 0; y < cel_height && (cel_y + y) < bitmap->bm_Height; y++) {
-                if (y % 20 == 0) { // Log every 20th row
-                    printf("Processing row %d/%d\n", y, cel_height);
-                }
-                
-                for (int x = 0; x < cel_width && (cel_x + x) < bitmap->bm_Width; x++) {
-                    if (cel_x + x >= 0 && cel_y + y >= 0) {
-                        int dst_idx = (cel_y + y) * bitmap->bm_Width + (cel_x + x);
-                        int src_idx = y * cel_width + x;
-                        
-                        // Enhanced safety checks
-                        int max_dst = bitmap->bm_Width * bitmap->bm_Height;
-                        int max_src = cel_width * cel_height;
-                        
-                        if (dst_idx >= max_dst) {
-                            printf("ERROR: dst_idx %d >= max_dst %d (x=%d,y=%d)\n", 
-                                   dst_idx, max_dst, x, y);
-                            goto next_cel;
-                        }
-                        
-                        if (src_idx >= max_src) {
-                            printf("ERROR: src_idx %d >= max_src %d (x=%d,y=%d)\n", 
-                                   src_idx, max_src, x, y);
-                            goto next_cel;
-                        }
-                        
-                        // Test memory access before actual copy
-                        volatile uint32_t test_read;
-                        volatile uint32_t* test_src = &cel_data[src_idx];
-                        volatile uint32_t* test_dst = &pixels[dst_idx];
-                        
-                        // Try to read source
-                        test_read = *test_src;
-                        
-                        // Try to write destination
-                        *test_dst = test_read;
-                        
-                        pixels_copied++;
-                        
-                        if (pixels_copied % 1000 == 0) { // Log every 1000 pixels
-                            printf("Copied %d pixels so far...\n", pixels_copied);
-                        }
-                    }
-                }
+    RasterTarget rt;
+    raster_target_from_bitmap(&rt, bitmap);
+    rt.scale = bitmap->bm_Width / g_screen_width;
+    rt.column_walls = g_column_walls;
+    if (capture_active()) {
+        capture_list(&rt, bitmap_item, list);
+    }
+
+    // Note where the list lands, unless the screen is drawn on all over
+    // already (as it is once a frame's backwall is down)
+    DirtyBuffer* dirty = dirty_buffer(bitmap->bm_Buffer);
+    if (dirty && (dirty->drawn.x0 > 0 || dirty->drawn.y0 > 0 ||
+                  dirty->drawn.x1 < rt.width || dirty->drawn.y1 < rt.height)) {
+        for (int32 i = 0; i < list->count; i++) {
+            int32 box[4];
+            if (raster_list_bounds(&rt, list, i, box)) {
+                dirty_mark(bitmap->bm_Buffer, box[0], box[1], box[2], box[3]);
             }
-            printf("Pixel copy completed! Copied %d pixels total\n", pixels_copied);
-            
-        } else {
-            printf("Cel skipped due to CCB_SKIP flag\n");
         }
+    }
 
-        next_cel:
-        printf("Moving to next cel...\n");
-        
-        if (current->ccb_Flags & CCB_LAST) {
-            printf("Found CCB_LAST flag, ending cel chain\n");
-            break;
-        }
-        
-        printf("ccb_NextPtr=%p\n", current->ccb_NextPtr);
-        current = current->ccb_NextPtr;
-        
-        if (cel_count > 10) {
-            printf("WARNING: Processed more than 10 cels, breaking to prevent infinite loop\n");
-            break;
-        }
+    // Lone cels (text, single sprites) aren't worth waking the workers for
+    int bands = g_raster_bands;
+    if (bands > 1 && list->count <= 1) bands = 1;
+    if (bands > rt.height / MIN_BAND_HEIGHT) bands = rt.height / MIN_BAND_HEIGHT;
+
+    if (bands <= 1) {
+        raster_draw_list(&rt, list);
+        return 0;
+    }
+
+    for (int i = 1; i < bands; i++) {
+        RasterWorker* worker = &g_raster_workers[i - 1];
+
+        worker->rt = rt;
+        worker->rt.clip_top = rt.height * i / bands;
+        worker->rt.clip_bottom = rt.height * (i + 1) / bands;
+        worker->list = list;
+        SDL_SemPost(worker->go);
+    }
+
+    rt.clip_bottom = rt.height / bands;
+    raster_draw_list(&rt, list);
+
+    for (int i = 1; i < bands; i++) {
+        SDL_SemWait(g_raster_done);
     }
 
-    printf("=== DrawCels() Exit (success) ===\n");
     return 0;
 }
 
@@ -451,15 +1634,14 @@ int SetRast(RastPort* rp, uint32 color)
         return -1;
     }
 
-    uint32_t* pixels = (uint32_t*)rp->rp_Bitmap->bm_Buffer;
     int total_pixels = rp->rp_Bitmap->bm_Width * rp->rp_Bitmap->bm_Height;
+    present_wait(rp->rp_Bitmap->bm_Buffer);
 
     // Convert color to RGBA
     uint32_t rgba_color = 0xFF000000 | color; // Add alpha
 
-    for (int i = 0; i < total_pixels; i++) {
-        pixels[i] = rgba_color;
-    }
+    fill_pixels(rp->rp_Bitmap->bm_Buffer, total_pixels, rgba_color);
+    dirty_mark(rp->rp_Bitmap->bm_Buffer, 0, 0, DIRTY_ALL, DIRTY_ALL);
 
     return 0;
 }
@@ -467,17 +1649,21 @@ int SetRast(RastPort* rp, uint32 color)
 int SetVRAMPages(Item vram_io, void* dest, uint32 value, int32 pages, uint32 mask)
 {
     if (!dest) return -1;
+    present_wait(dest);
 
     // Simulate VRAM page setting
-    uint32_t* pixels = (uint32_t*)dest;
-    int pixels_per_page = g_graphics_base.gf_VRAMPageSize / 4; // 4 bytes per pixel
+    int pixels_per_page = g_graphics_base.gf_VRAMPageSize / screen_bytes_per_pixel();
     int total_pixels = pages * pixels_per_page;
 
-    uint32_t rgba_color = 0xFF000000 | value; // Add alpha
+    uint32_t color = screen_pixel(0xFF000000 | value); // Add alpha
+    dirty_mark(dest, 0, 0, DIRTY_ALL, DIRTY_ALL);
 
     for (int i = 0; i < total_pixels; i++) {
         if (mask == ~0L || (i & mask)) {
-            pixels[i] = rgba_color;
+            if (g_screen_format == BMF_RGB555)
+                ((uint16*)dest)[i] = (uint16)color;
+            else
+                ((uint32_t*)dest)[i] = color;
         }
     }
 
@@ -487,20 +1673,21 @@ int SetVRAMPages(Item vram_io, void* dest, uint32 value, int32 pages, uint32 mas
 int CopyVRAMPages(Item vram_io, void* dest, void* src, int32 pages, uint32 mask)
 {
     if (!dest || !src) return -1;
+    present_wait(dest);
 
     int bytes_to_copy = pages * g_graphics_base.gf_VRAMPageSize;
-    
+    dirty_mark(dest, 0, 0, DIRTY_ALL, DIRTY_ALL);
+
     if (mask == ~0L) {
         memcpy(dest, src, bytes_to_copy);
     } else {
         // Handle masked copy (simplified)
-        uint32_t* dst = (uint32_t*)dest;
-        uint32_t* src_pixels = (uint32_t*)src;
-        int pixel_count = bytes_to_copy / 4;
+        int bpp = screen_bytes_per_pixel();
+        int pixel_count = bytes_to_copy / bpp;
         
         for (int i = 0; i < pixel_count; i++) {
             if (i & mask) {
-                dst[i] = src_pixels[i];
+                memcpy((ubyte*)dest + i * bpp, (ubyte*)src + i * bpp, bpp);
             }
         }
     }
@@ -516,6 +1703,9 @@ int GetVBLIOReq(void)
 
 int WaitVBL(Item vbl_io, int32 frames)
 {
+    // Show anything readied since DisplayScreen() before sleeping
+    present_flush();
+
     Uint32 current_time = SDL_GetTicks();
     Uint32 frame_duration = 1000 / VBL_RATE; // milliseconds per frame
     Uint32 target_time = g_last_vbl_time + (frames * frame_duration);
@@ -561,20 +1751,59 @@ void FreeMem(void* ptr, int32 size)
 }
 
 // Utility functions
+
+/*
+ * Take a cel and create position and delta values to map its corners onto
+ * the specified quadrilateral (straight port of the original in rend.c).
+ * HDX/HDY/HDDX/HDDY come out in 12.20, VDX/VDY in 16.16.
+ *
+ * If Width/Height are positive, the dimension is the value.
+ * If negative or zero, the dimension is 1 << -value, i.e. it's a shift count.
+ */
 void FasterMapCel(CCB* ccb, Point* corners)
 {
     if (!ccb || !corners) return;
 
-    // Calculate transformation matrix from corners
-    // This is a simplified version - the original 3DO version was more complex
-    ccb->ccb_XPos = Convert32_F16(corners[0].pt_X);
-    ccb->ccb_YPos = Convert32_F16(corners[0].pt_Y);
-    
-    // Calculate deltas (simplified)
-    ccb->ccb_HDX = Convert32_F16(corners[1].pt_X - corners[0].pt_X);
-    ccb->ccb_HDY = Convert32_F16(corners[1].pt_Y - corners[0].pt_Y);
-    ccb->ccb_VDX = Convert32_F16(corners[3].pt_X - corners[0].pt_X);
-    ccb->ccb_VDY = Convert32_F16(corners[3].pt_Y - corners[0].pt_Y);
+    Point* p = corners;
+    int32 wide, high;
+    int i = 2;
+
+    ccb->ccb_XPos = (p[0].pt_X << 16) + 0x8000;
+    ccb->ccb_YPos = (p[0].pt_Y << 16) + 0x8000;
+
+    if ((wide = ccb->ccb_Width) <= 0) {
+        ccb->ccb_HDX = (p[1].pt_X - p[0].pt_X) << (20 + wide);
+        ccb->ccb_HDY = (p[1].pt_Y - p[0].pt_Y) << (20 + wide);
+        --i;
+    } else {
+        ccb->ccb_HDX = ((p[1].pt_X - p[0].pt_X) << 20) / wide;
+        ccb->ccb_HDY = ((p[1].pt_Y - p[0].pt_Y) << 20) / wide;
+    }
+
+    if ((high = ccb->ccb_Height) <= 0) {
+        ccb->ccb_VDX = (p[3].pt_X - p[0].pt_X) << (16 + high);
+        ccb->ccb_VDY = (p[3].pt_Y - p[0].pt_Y) << (16 + high);
+        --i;
+    } else {
+        ccb->ccb_VDX = ((p[3].pt_X - p[0].pt_X) << 16) / high;
+        ccb->ccb_VDY = ((p[3].pt_Y - p[0].pt_Y) << 16) / high;
+    }
+
+    if (!i) {
+        wide += high;
+        ccb->ccb_HDDX = (p[2].pt_X - p[3].pt_X - p[1].pt_X + p[0].pt_X) << (20 + wide);
+        ccb->ccb_HDDY = (p[2].pt_Y - p[3].pt_Y - p[1].pt_Y + p[0].pt_Y) << (20 + wide);
+    } else {
+        // Regenerate actual dimensions if necessary.
+        if (wide <= 0)
+            wide = 1 << -wide;
+        else if (high <= 0)
+            high = 1 << -high;
+
+        wide *= high;
+        ccb->ccb_HDDX = ((p[2].pt_X - p[3].pt_X - p[1].pt_X + p[0].pt_X) << 20) / wide;
+        ccb->ccb_HDDY = ((p[2].pt_Y - p[3].pt_Y - p[1].pt_Y + p[0].pt_Y) << 20) / wide;
+    }
 }
 
 void SetFGPen(GrafCon* gc, Color color)
@@ -586,26 +1815,120 @@ void SetFGPen(GrafCon* gc, Color color)
 
 void WritePixel(Item bitmap_item, GrafCon* gc, int32 x, int32 y)
 {
-    if (bitmap_item < 1 || bitmap_item > g_num_screens || !gc) {
+    Bitmap* bitmap = lookup_bitmap(bitmap_item);
+    if (!bitmap || !gc) {
         return;
     }
 
-    Bitmap* bitmap = &g_bitmaps[bitmap_item - 1];
+    // Coordinates are 3DO pixels; cover the whole block at higher render scales
+    int scale = bitmap->bm_Width / g_screen_width;
+    x *= scale;
+    y *= scale;
     if (x >= 0 && x < bitmap->bm_Width && y >= 0 && y < bitmap->bm_Height) {
-        uint32_t* pixels = (uint32_t*)bitmap->bm_Buffer;
-        int index = y * bitmap->bm_Width + x;
-        pixels[index] = 0xFF000000 | gc->fg_color; // Add alpha
+        int bpp = screen_bytes_per_pixel();
+        for (int sy = 0; sy < scale; sy++) {
+            fill_pixels((ubyte*)bitmap->bm_Buffer + (size_t)((y + sy) * bitmap->bm_Width + x) * bpp,
+                        scale, 0xFF000000 | gc->fg_color); // Add alpha
+        }
+        dirty_mark(bitmap->bm_Buffer, x, y, x + scale, y + scale);
     }
 }
 
-// Accessor function for bitmaps (needed by game_stubs.c)
-Bitmap* get_bitmap(Item bitmap_item) {
+// The bitmap for an item, once the present thread is done reading it
+static Bitmap* lookup_bitmap(Item bitmap_item)
+{
+    if (bitmap_item == HUD_BITMAP_ITEM && g_hud_bitmap.bm_Buffer) {
+        return &g_hud_bitmap;
+    }
     if (bitmap_item < 1 || bitmap_item > g_num_screens) {
         return NULL;
     }
+    present_wait(g_bitmaps[bitmap_item - 1].bm_Buffer);
     return &g_bitmaps[bitmap_item - 1];
 }
 
+// Accessor function for bitmaps (needed by game_stubs.c).  Callers write
+// the pixels themselves, so the whole screen counts as drawn on.
+Bitmap* get_bitmap(Item bitmap_item) {
+    Bitmap* bitmap = lookup_bitmap(bitmap_item);
+    if (bitmap) {
+        dirty_mark(bitmap->bm_Buffer, 0, 0, DIRTY_ALL, DIRTY_ALL);
+    }
+    return bitmap;
+}
+
+Item platform_hud_begin(Item bitmap_item, uint32 key)
+{
+    Bitmap* screen = lookup_bitmap(bitmap_item);
+    if (!screen || !screen->bm_Buffer) {
+        return 0;
+    }
+
+    // The layer follows the screens' size and format
+    if (g_hud_bitmap.bm_Width != screen->bm_Width || g_hud_bitmap.bm_Height != screen->bm_Height ||
+        g_hud_bitmap.bm_Format != screen->bm_Format || !g_hud_bitmap.bm_Buffer) {
+        free(g_hud_bitmap.bm_Buffer);
+        g_hud_bitmap = *screen;
+        g_hud_bitmap.bm_Buffer = malloc((size_t)screen->bm_BytesPerRow * screen->bm_Height);
+        g_hud_valid = false;
+        if (!g_hud_bitmap.bm_Buffer) {
+            // No layer; draw straight onto the screen every frame instead
+            return bitmap_item;
+        }
+    }
+
+    if (g_hud_valid && key == g_hud_key) {
+        platform_perf_set("hud_skipped", ++g_hud_skipped);
+        return 0;
+    }
+
+    memset(g_hud_bitmap.bm_Buffer, 0, (size_t)g_hud_bitmap.bm_BytesPerRow * g_hud_bitmap.bm_Height);
+    g_hud_valid = true;
+    g_hud_key = key;
+    g_hud_top = -1;
+    platform_perf_set("hud_redrawn", ++g_hud_redrawn);
+    return HUD_BITMAP_ITEM;
+}
+
+void platform_hud_composite(Item bitmap_item)
+{
+    Bitmap* screen = lookup_bitmap(bitmap_item);
+    Bitmap* hud = &g_hud_bitmap;
+    if (!screen || !screen->bm_Buffer || !g_hud_valid || hud->bm_Width != screen->bm_Width ||
+        hud->bm_Height != screen->bm_Height || hud->bm_Format != screen->bm_Format) {
+        return;
+    }
+
+    // After a redraw, find the band of rows the HUD actually covers so
+    // the blit can leave the rest of the frame alone
+    int bpr = hud->bm_BytesPerRow;
+    if (g_hud_top < 0) {
+        const ubyte* pixels = (const ubyte*)hud->bm_Buffer;
+        g_hud_top = hud->bm_Height;
+        g_hud_bottom = 0;
+        for (int y = 0; y < hud->bm_Height; y++) {
+            const ubyte* row = pixels + (size_t)y * bpr;
+            int x = 0;
+            while (x < bpr && !row[x]) x++;
+            if (x < bpr) {
+                if (y < g_hud_top) g_hud_top = y;
+                g_hud_bottom = y + 1;
+            }
+        }
+    }
+    if (g_hud_top >= g_hud_bottom) {
+        return;
+    }
+
+    platform_perf_start("hud_composite");
+    size_t offset = (size_t)g_hud_top * bpr;
+    raster_overlay((ubyte*)screen->bm_Buffer + offset, (const ubyte*)hud->bm_Buffer + offset,
+                   (size_t)(g_hud_bottom - g_hud_top) * hud->bm_Width,
+                   hud->bm_Format == BMF_RGB555);
+    dirty_mark(screen->bm_Buffer, 0, g_hud_top, hud->bm_Width, g_hud_bottom);
+    platform_perf_end("hud_composite");
+}
+
 // Platform-specific functions needed by the main program
 int clearscreen(RastPort* rp)
 {
@@ -618,29 +1941,42 @@ int clearscreen(RastPort* rp)
         return -1;
     }
 
-    uint32_t* pixels = (uint32_t*)rp->rp_Bitmap->bm_Buffer;
-    int width = rp->rp_Bitmap->bm_Width;
     int height = rp->rp_Bitmap->bm_Height;
     
     // Split screen: ceiling on top, floor on bottom
     extern int32 cy; // Horizon line
     
-    uint32_t ceiling_rgba = 0xFF000000 | ceilingcolor;
-    uint32_t floor_rgba = 0xFF000000 | floorcolor;
-    
-    for (int y = 0; y < height; y++) {
-        uint32_t color = (y < cy) ? ceiling_rgba : floor_rgba;
-        for (int x = 0; x < width; x++) {
-            pixels[y * width + x] = color;
+    // The row colors only change with the level (or the horizon or the
+    // screen size), so they're kept rather than worked out every frame
+    if (height != g_clear_height || ceilingcolor != g_clear_ceiling ||
+        floorcolor != g_clear_floor || cy != g_clear_cy) {
+        uint32* rows = (uint32*)realloc(g_clear_rows, (size_t)height * sizeof(uint32));
+        if (!rows) {
+            return -1;
+        }
+        for (int y = 0; y < height; y++) {
+            rows[y] = 0xFF000000 | (uint32)((y < cy) ? ceilingcolor : floorcolor);
         }
+        g_clear_rows = rows;
+        g_clear_height = height;
+        g_clear_ceiling = ceilingcolor;
+        g_clear_floor = floorcolor;
+        g_clear_cy = cy;
     }
     
+    RasterTarget rt;
+    present_wait(rp->rp_Bitmap->bm_Buffer);
+    raster_target_from_bitmap(&rt, rp->rp_Bitmap);
+    raster_fill_rows(&rt, 0, g_clear_rows, height);
+    dirty_mark(rt.pixels, 0, 0, DIRTY_ALL, DIRTY_ALL);
+    
     return 0;
 }
 
 void platform_clear_framebuffer(uint32 color)
 {
     if (!g_renderer) return;
+    present_sync();
     
     // Extract RGB components from the color
     ubyte r = (color >> 16) & 0xFF;
@@ -655,6 +1991,7 @@ void platform_clear_framebuffer(uint32 color)
 void platform_present_framebuffer(void)
 {
     if (!g_window) return;
+    present_sync();
     
     // Present the rendered frame to the screen
     if (g_use_opengl) {
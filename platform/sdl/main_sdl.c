@@ -23,6 +23,12 @@ extern int dogame(void);
 extern int8 skiptitle;
 extern RastPort *rpvis, *rprend;
 
+// Settings read at startup (key=value lines)
+#define CONFIG_FILE "efmm.cfg"
+
+void platform_load_config(const char* filename);
+void platform_save_config(const char* filename);
+
 // Platform timing functions
 // Note: platform_get_ticks() is implemented in game_stubs.c
 // Uint32 platform_get_ticks(void)
@@ -150,9 +156,11 @@ int main(int argc, char* argv[])
     if (init_platform_systems() < 0) {
         return 1;
     }
+    platform_load_config(CONFIG_FILE);
 
     // Run the game
     int result = run_game_loop();
+    platform_perf_report();
 
     // Shutdown platform systems
     shutdown_platform_systems();
@@ -269,50 +277,80 @@ void platform_error(const char* format, ...)
 }
 */
 
-// Performance monitoring
+// Performance monitoring.  Timers accumulate elapsed time between
+// platform_perf_start() and platform_perf_end(); values are gauges set
+// with platform_perf_set() and report their latest setting.
+#define MAX_PERF_COUNTERS 32
+
 typedef struct PerformanceCounter {
-    Uint32 start_time;
-    Uint32 total_time;
+    Uint64 start_time;
+    double total_time;    // ms
+    double last_time;     // ms, most recent start/end pair
+    double value;         // Gauge value
     int call_count;
+    int is_value;
     const char* name;
 } PerformanceCounter;
 
-static PerformanceCounter g_perf_counters[16];
+static PerformanceCounter g_perf_counters[MAX_PERF_COUNTERS];
 static int g_num_perf_counters = 0;
 
-void platform_perf_start(const char* name)
+static PerformanceCounter* find_perf_counter(const char* name, int create)
 {
     // Find or create performance counter
-    int index = -1;
     for (int i = 0; i < g_num_perf_counters; i++) {
         if (strcmp(g_perf_counters[i].name, name) == 0) {
-            index = i;
-            break;
+            return &g_perf_counters[i];
         }
     }
-    
-    if (index == -1 && g_num_perf_counters < 16) {
-        index = g_num_perf_counters++;
-        g_perf_counters[index].name = name;
-        g_perf_counters[index].total_time = 0;
-        g_perf_counters[index].call_count = 0;
+
+    if (!create || g_num_perf_counters >= MAX_PERF_COUNTERS) {
+        return NULL;
     }
-    
-    if (index >= 0) {
-        g_perf_counters[index].start_time = SDL_GetTicks();
+
+    PerformanceCounter* counter = &g_perf_counters[g_num_perf_counters++];
+    memset(counter, 0, sizeof(*counter));
+    counter->name = name;
+    return counter;
+}
+
+void platform_perf_start(const char* name)
+{
+    PerformanceCounter* counter = find_perf_counter(name, 1);
+
+    if (counter) {
+        counter->start_time = SDL_GetPerformanceCounter();
     }
 }
 
 void platform_perf_end(const char* name)
 {
-    Uint32 end_time = SDL_GetTicks();
-    
-    for (int i = 0; i < g_num_perf_counters; i++) {
-        if (strcmp(g_perf_counters[i].name, name) == 0) {
-            g_perf_counters[i].total_time += end_time - g_perf_counters[i].start_time;
-            g_perf_counters[i].call_count++;
-            break;
-        }
+    Uint64 end_time = SDL_GetPerformanceCounter();
+    PerformanceCounter* counter = find_perf_counter(name, 0);
+
+    if (counter) {
+        counter->last_time = (double)(end_time - counter->start_time) * 1000.0 /
+                             (double)SDL_GetPerformanceFrequency();
+        counter->total_time += counter->last_time;
+        counter->call_count++;
+    }
+}
+
+// Duration of the most recent start/end pair, in milliseconds
+double platform_perf_last(const char* name)
+{
+    PerformanceCounter* counter = find_perf_counter(name, 0);
+
+    return counter ? counter->last_time : 0.0;
+}
+
+void platform_perf_set(const char* name, double value)
+{
+    PerformanceCounter* counter = find_perf_counter(name, 1);
+
+    if (counter) {
+        counter->is_value = 1;
+        counter->value = value;
     }
 }
 
@@ -321,10 +359,12 @@ void platform_perf_report(void)
     printf("\n=== Performance Report ===\n");
     for (int i = 0; i < g_num_perf_counters; i++) {
         PerformanceCounter* counter = &g_perf_counters[i];
-        if (counter->call_count > 0) {
-            float avg_time = (float)counter->total_time / counter->call_count;
+        if (counter->is_value) {
+            printf("%s: %.2f\n", counter->name, counter->value);
+        } else if (counter->call_count > 0) {
+            double avg_time = counter->total_time / counter->call_count;
             printf("%s: %d calls, %.2f ms average, %.2f ms total\n",
-                   counter->name, counter->call_count, avg_time, (float)counter->total_time);
+                   counter->name, counter->call_count, avg_time, counter->total_time);
         }
     }
     printf("===========================\n\n");
@@ -340,6 +380,25 @@ typedef struct GameConfig {
     float music_volume;
     float sfx_volume;
     int difficulty;
+    int raster_threads;
+    bool column_walls;
+    int texture_tiles;
+    bool rgb555_screens;
+    bool async_present;
+    bool dirty_present;
+    int upscale_mode;
+    int upscale_threads;
+    int render_scale;
+    bool dynamic_resolution;
+    int min_render_scale;
+    int max_render_scale;
+    float target_frame_ms;
+    bool adaptive_draw_distance;
+    float min_draw_distance;
+    float max_draw_distance;
+    float draw_budget_ms;
+    char capture_file[64];
+    int capture_frames;
 } GameConfig;
 
 static GameConfig g_game_config = {
@@ -350,7 +409,26 @@ static GameConfig g_game_config = {
     .master_volume = 1.0f,
     .music_volume = 0.8f,
     .sfx_volume = 1.0f,
-    .difficulty = 1
+    .difficulty = 1,
+    .raster_threads = 1,
+    .column_walls = false,
+    .texture_tiles = 0,
+    .rgb555_screens = false,
+    .async_present = true,
+    .dirty_present = true,
+    .upscale_mode = 0,
+    .upscale_threads = 0,
+    .render_scale = 1,
+    .dynamic_resolution = false,
+    .min_render_scale = 1,
+    .max_render_scale = 4,
+    .target_frame_ms = 12.0f,
+    .adaptive_draw_distance = false,
+    .min_draw_distance = 10.0f,
+    .max_draw_distance = 24.0f,
+    .draw_budget_ms = 6.0f,
+    .capture_file = "",
+    .capture_frames = 0
 };
 
 void platform_load_config(const char* filename)
@@ -374,12 +452,68 @@ void platform_load_config(const char* filename)
                 g_game_config.fullscreen = (strcmp(value, "true") == 0);
             } else if (strcmp(key, "master_volume") == 0) {
                 g_game_config.master_volume = atof(value);
+            } else if (strcmp(key, "raster_threads") == 0) {
+                g_game_config.raster_threads = atoi(value);
+                platform_set_raster_threads(g_game_config.raster_threads);
+            } else if (strcmp(key, "column_walls") == 0) {
+                g_game_config.column_walls = (strcmp(value, "true") == 0);
+                platform_set_column_walls(g_game_config.column_walls);
+            } else if (strcmp(key, "texture_tiles") == 0) {
+                g_game_config.texture_tiles = platform_set_texture_tiles(atoi(value));
+            } else if (strcmp(key, "rgb555_screens") == 0) {
+                g_game_config.rgb555_screens = (strcmp(value, "true") == 0);
+                platform_set_rgb555_screens(g_game_config.rgb555_screens);
+            } else if (strcmp(key, "async_present") == 0) {
+                g_game_config.async_present = (strcmp(value, "true") == 0);
+                platform_set_async_present(g_game_config.async_present);
+            } else if (strcmp(key, "dirty_present") == 0) {
+                g_game_config.dirty_present = (strcmp(value, "true") == 0);
+                platform_set_dirty_present(g_game_config.dirty_present);
+            } else if (strcmp(key, "upscale_mode") == 0) {
+                g_game_config.upscale_mode = atoi(value);
+            } else if (strcmp(key, "upscale_threads") == 0) {
+                g_game_config.upscale_threads = atoi(value);
+            } else if (strcmp(key, "render_scale") == 0) {
+                g_game_config.render_scale = platform_set_render_scale(atoi(value));
+            } else if (strcmp(key, "dynamic_resolution") == 0) {
+                g_game_config.dynamic_resolution = (strcmp(value, "true") == 0);
+            } else if (strcmp(key, "min_render_scale") == 0) {
+                g_game_config.min_render_scale = atoi(value);
+            } else if (strcmp(key, "max_render_scale") == 0) {
+                g_game_config.max_render_scale = atoi(value);
+            } else if (strcmp(key, "target_frame_ms") == 0) {
+                g_game_config.target_frame_ms = atof(value);
+            } else if (strcmp(key, "adaptive_draw_distance") == 0) {
+                g_game_config.adaptive_draw_distance = (strcmp(value, "true") == 0);
+            } else if (strcmp(key, "min_draw_distance") == 0) {
+                g_game_config.min_draw_distance = atof(value);
+            } else if (strcmp(key, "max_draw_distance") == 0) {
+                g_game_config.max_draw_distance = atof(value);
+            } else if (strcmp(key, "draw_budget_ms") == 0) {
+                g_game_config.draw_budget_ms = atof(value);
+            } else if (strcmp(key, "capture_file") == 0) {
+                snprintf(g_game_config.capture_file, sizeof(g_game_config.capture_file),
+                         "%s", value);
+            } else if (strcmp(key, "capture_frames") == 0) {
+                g_game_config.capture_frames = atoi(value);
             }
             // Add more config options as needed
         }
     }
 
     fclose(file);
+
+    platform_set_dynamic_resolution(g_game_config.dynamic_resolution,
+                                    g_game_config.min_render_scale,
+                                    g_game_config.max_render_scale,
+                                    g_game_config.target_frame_ms);
+    platform_set_adaptive_draw_distance(g_game_config.adaptive_draw_distance,
+                                        g_game_config.min_draw_distance,
+                                        g_game_config.max_draw_distance,
+                                        g_game_config.draw_budget_ms);
+    g_game_config.upscale_mode = platform_set_upscale(g_game_config.upscale_mode,
+                                                      g_game_config.upscale_threads);
+    platform_set_capture(g_game_config.capture_file, g_game_config.capture_frames);
     printf("Loaded configuration from %s\n", filename);
 }
 
@@ -398,6 +532,25 @@ void platform_save_config(const char* filename)
     fprintf(file, "music_volume=%.2f\n", g_game_config.music_volume);
     fprintf(file, "sfx_volume=%.2f\n", g_game_config.sfx_volume);
     fprintf(file, "difficulty=%d\n", g_game_config.difficulty);
+    fprintf(file, "raster_threads=%d\n", g_game_config.raster_threads);
+    fprintf(file, "column_walls=%s\n", g_game_config.column_walls ? "true" : "false");
+    fprintf(file, "texture_tiles=%d\n", g_game_config.texture_tiles);
+    fprintf(file, "rgb555_screens=%s\n", g_game_config.rgb555_screens ? "true" : "false");
+    fprintf(file, "async_present=%s\n", g_game_config.async_present ? "true" : "false");
+    fprintf(file, "dirty_present=%s\n", g_game_config.dirty_present ? "true" : "false");
+    fprintf(file, "upscale_mode=%d\n", g_game_config.upscale_mode);
+    fprintf(file, "upscale_threads=%d\n", g_game_config.upscale_threads);
+    fprintf(file, "render_scale=%d\n", g_game_config.render_scale);
+    fprintf(file, "dynamic_resolution=%s\n", g_game_config.dynamic_resolution ? "true" : "false");
+    fprintf(file, "min_render_scale=%d\n", g_game_config.min_render_scale);
+    fprintf(file, "max_render_scale=%d\n", g_game_config.max_render_scale);
+    fprintf(file, "target_frame_ms=%.2f\n", g_game_config.target_frame_ms);
+    fprintf(file, "adaptive_draw_distance=%s\n", g_game_config.adaptive_draw_distance ? "true" : "false");
+    fprintf(file, "min_draw_distance=%.2f\n", g_game_config.min_draw_distance);
+    fprintf(file, "max_draw_distance=%.2f\n", g_game_config.max_draw_distance);
+    fprintf(file, "draw_budget_ms=%.2f\n", g_game_config.draw_budget_ms);
+    fprintf(file, "capture_file=%s\n", g_game_config.capture_file);
+    fprintf(file, "capture_frames=%d\n", g_game_config.capture_frames);
 
     fclose(file);
     printf("Saved configuration to %s\n", filename);
@@ -51,6 +51,11 @@ int32 DrawCels(Item bitmapItem, CCB* ccb) {
     return 0;
 }
 
+int platform_draw_list(Item bitmap_item, const RasterDrawList* list) {
+    printf("STUB: Drawing draw list\n");
+    return 0;
+}
+
 int32 DisplayScreen(Item screenItem, Item bitmapItem) {
     printf("STUB: Displaying screen\n");
     return 0;
@@ -39,7 +39,7 @@ extern Vector	plusx, plusz, minusx, minusz;
 
 extern ImageEntry	*wallimgs;
 extern CCB	*wallcel, *statpanel, *guncel;
-extern int32	wide, high, cy;
+extern int32	wide, high, cx, cy, magic, rendscale;
 extern uint32	ccbextra;
 
 extern int32	floorcolor, ceilingcolor;
@@ -51,12 +51,25 @@ AnimLoaf	*wallanims;
 int32		nwallanims;
 int16		*scaledpluts, *curscaledplut;
 
+/*
+ * Distance fade ramps for the wall PLUTs.  The walls' whole PLUT buffer
+ * is copied out FADELEVELS times, each copy scaled to one brightness, so
+ * fading a coded wall is just a matter of pointing it at another copy.
+ */
+#define	FADESHIFT	5
+#define	FADELEVELS	(1 << FADESHIFT)
+
+static int16	*fadepluts;	/*  FADELEVELS copies of wallpluts.	*/
+static int16	*wallpluts;
+static int32	nwallplutents;
+
 CCB		ccbpool[MAXVISOBS];
 CCB		*curccb;
 
 CCB		*backwallcel;
+static frac16	backwalldist;	/*  Draw distance backwall is shaded for.  */
 
-uint32		linebuf[10];
+LineBuf		linebuf;
 
 
 /***************************************************************************
@@ -65,10 +78,15 @@ uint32		linebuf[10];
 void
 rendercels ()
 {
-	resetlinebuf (linebuf);
+	register CCB	*lastcel;
+
+	resetlinebuf (&linebuf);
 	curccb = ccbpool;
 	curscaledplut = scaledpluts;
 
+	if (backwalldist != drawdist)
+		shadebackwall ();
+
 	buildcellist (visobs, nviso, projverts, xfverts, TRUE);
 
 	if (curccb > ccbpool) {
@@ -76,8 +94,17 @@ rendercels ()
 		ccbpool->ccb_NextPtr = guncel;
 	} else
 		backwallcel->ccb_NextPtr = guncel;
+
+	/*
+	 * The gun stays on the end of the chain for the screens that redraw
+	 * it (options, stats), but here it comes from the HUD layer.
+	 */
+	lastcel = curccb > ccbpool ? ccbpool : backwallcel;
+	lastcel->ccb_Flags |= CCB_LAST;
 	DrawCels (rprend->rp_BitmapItem, backwallcel);
+	lastcel->ccb_Flags &= ~CCB_LAST;
 
+	drawhud ();
 	sequencegun (0);
 }
 
@@ -92,7 +119,7 @@ struct Vertex		*xfverts;
 int			indirect;
 {
 #define	ZFADENEAR_F16	(8 * ONE_F16)
-#define	ZFADEFAR_F16	(GRIDCUTOFF * ONE_F16)
+#define	ZFADEFAR_F16	drawdist
 
 	register CCB		*ccb;
 	register int32		lidx, ridx;
@@ -101,7 +128,7 @@ int			indirect;
 	int			zflags;
 
 	for ( ;  --nvo >= 0;  vo++) {
-		if (islinefull (linebuf))
+		if (islinefull (&linebuf))
 			break;
 
 		lidx = vo->vo_LIdx;
@@ -127,12 +154,12 @@ int			indirect;
 
 		if (!zflags)
 			if (vo->vo_MEFlags & MEF_OPAQUE) {
-				if (!testmarklinebuf (linebuf,
+				if (!testmarklinebuf (&linebuf,
 						      verts[lidx].X,
 						      verts[ridx].X))
 					continue;
 			} else {
-				if (!testlinebuf (linebuf,
+				if (!testlinebuf (&linebuf,
 						  verts[lidx].X,
 						  verts[ridx].X))
 					continue;
@@ -176,7 +203,7 @@ int			indirect;
 			factor = zclip (vptrs, zflags, corner);
 
 			if (vo->vo_MEFlags & MEF_OPAQUE) {
-				if (!testmarklinebuf (linebuf,
+				if (!testmarklinebuf (&linebuf,
 						      corner[0].pt_X,
 						      corner[3].pt_X))
 				{
@@ -186,7 +213,7 @@ int			indirect;
 					continue;
 				}
 			} else {
-				if (!testlinebuf (linebuf,
+				if (!testlinebuf (&linebuf,
 						  corner[0].pt_X,
 						  corner[3].pt_X))
 					continue;
@@ -196,10 +223,17 @@ int			indirect;
 		}
 
 
-		FasterMapCel (ccb, corner);
+		rendmapcel (ccb, corner);
 
-		if (vo->vo_ME)
+		/*
+		 * Faces seen for the first time go on the automap.
+		 */
+		if (vo->vo_ME  &&
+		    (vo->vo_VisFlags << 4) & ~vo->vo_ME->me_VisFlags)
+		{
 			vo->vo_ME->me_VisFlags |= vo->vo_VisFlags << 4;
+			markmapcell (vo->vo_ME);
+		}
 
 		ccb->ccb_Flags &= ~CCB_LAST;
 		curccb++;
@@ -238,18 +272,67 @@ int32	nvbls;
 }
 
 
+/*
+ * Each level's copy is scaled to the middle of the range of fade values
+ * that select it, so no entry comes out more than one step off what
+ * scaling by the exact value would give.  Copies run back to back and
+ * fadecel() may read 32 entries from the last PLUT of the last one, so
+ * there's a zeroed PLUT's worth of slack on the end.
+ */
+static void
+buildfadepluts (iev)
+struct ImageEnv	*iev;
+{
+	register int16	*src, *dest;
+	register int	i, r, g, b;
+	register frac16	scale;
+	int		level;
+
+	nwallplutents = iev->iev_PLUTBufSiz / sizeof (int16);
+	if (!(fadepluts = malloctype ((FADELEVELS * nwallplutents + 32) *
+				       sizeof (int16),
+				      MEMTYPE_CEL | MEMTYPE_FILL)))
+		/*
+		 * Not fatal; fadecel() will scale them as it goes.
+		 */
+		return;
+	wallpluts = (int16 *) iev->iev_PLUTBuf;
+
+	dest = fadepluts;
+	for (level = 0;  level < FADELEVELS;  level++) {
+		scale = (level << (16 - FADESHIFT)) + (1 << (15 - FADESHIFT));
+		src = wallpluts;
+		for (i = nwallplutents;  --i >= 0; ) {
+			b = *src++;
+			r = (b >> 10) & 0x1F;
+			g = (b >> 5) & 0x1F;
+			b &= 0x1F;
+
+			r = r * scale >> 16;
+			g = g * scale >> 16;
+			b = b * scale >> 16;
+
+			*dest++ = b | (g << 5) | (r << 10);
+		}
+	}
+}
+
 void
 initwallanim (iev)
 struct ImageEnv	*iev;
 {
 	if ((nwallanims = createanimloafs (iev, &wallanims)) < 0)
 		die ("Can't allocate AnimLoaf table.\n");
+	buildfadepluts (iev);
 }
 
 void
 closewallanim ()
 {
 	if (wallanims)	deleteanimloafs (wallanims), wallanims = NULL;
+	if (fadepluts)	freetype (fadepluts), fadepluts = NULL;
+	wallpluts = NULL;
+	nwallplutents = 0;
 }
 
 
@@ -380,7 +463,7 @@ processgrid ()
 if (nvisv >= MAXWALLVERTS/2)
  kprintf ("EEEK!  xfverts[] overflow at %d\n", nvisv);
 
-	project (xfverts, projverts, MAGIC, 0, CX, cy, nvisv + nvisv);
+	project (xfverts, projverts, magic, 0, cx, cy, nvisv + nvisv);
 }
 
 
@@ -413,7 +496,7 @@ if (nobverts > NOBVERTS)
 				      (MATCAST) &camera,
 				      nobverts);
 
-		project (xfobverts, obverts, MAGIC, 0, CX, cy, nobverts);
+		project (xfobverts, obverts, magic, 0, cx, cy, nobverts);
 	}
 }
 
@@ -432,6 +515,9 @@ initrend ()
 	if (!(scaledpluts = malloctype (1024, MEMTYPE_CEL)))
 		die ("Can't allocate memory for scaled PLUTs.\n");
 
+	if (!initlinebuf (&linebuf, wide * rendscale))
+		die ("Can't allocate line buffer.\n");
+
 	createbackwall ();
 }
 
@@ -440,6 +526,7 @@ closerend ()
 {
 	if (scaledpluts)	freetype (scaledpluts), scaledpluts = NULL;
 	if (backwallcel)	freetype (backwallcel), backwallcel = NULL;
+	freelinebuf (&linebuf);
 }
 
 
@@ -624,177 +711,6 @@ playdeath ()
 #endif
 
 
-/***************************************************************************
- * The following code has been converted to assembly code, which probably
- * doesn't run much faster than the compiled stuff, since I don't seem to
- * be quite a good enough ARM programmer to reliably outstrip the compiler.
- *
- * If you need to revert to something more malleable, take out the #if
- * and #endif statements.
- */
-
-
-static uint32	leftmasks[] = {
-	0xFFFFFFFF, 0x7FFFFFFF, 0x3FFFFFFF, 0x1FFFFFFF,
-	0x0FFFFFFF, 0x07FFFFFF, 0x03FFFFFF, 0x01FFFFFF,
-	0x00FFFFFF, 0x007FFFFF, 0x003FFFFF, 0x001FFFFF,
-	0x000FFFFF, 0x0007FFFF, 0x0003FFFF, 0x0001FFFF,
-	0x0000FFFF, 0x00007FFF, 0x00003FFF, 0x00001FFF,
-	0x00000FFF, 0x000007FF, 0x000003FF, 0x000001FF,
-	0x000000FF, 0x0000007F, 0x0000003F, 0x0000001F,
-	0x0000000F, 0x00000007, 0x00000003, 0x00000001
-};
-
-static uint32	rightmasks[] = {
-	0x80000000, 0xC0000000, 0xE0000000, 0xF0000000,
-	0xF8000000, 0xFC000000, 0xFE000000, 0xFF000000,
-	0xFF800000, 0xFFC00000, 0xFFE00000, 0xFFF00000,
-	0xFFF80000, 0xFFFC0000, 0xFFFE0000, 0xFFFF0000,
-	0xFFFF8000, 0xFFFFC000, 0xFFFFE000, 0xFFFFF000,
-	0xFFFFF800, 0xFFFFFC00, 0xFFFFFE00, 0xFFFFFF00,
-	0xFFFFFF80, 0xFFFFFFC0, 0xFFFFFFE0, 0xFFFFFFF0,
-	0xFFFFFFF8, 0xFFFFFFFC, 0xFFFFFFFE, 0xFFFFFFFF
-};
-
-
-int
-testlinebuf (linebuf, lx, rx)
-register uint32	*linebuf;
-register int32	lx, rx;
-{
-	register uint32	lm, rm;
-
-	if (lx == rx)
-		return (FALSE);
-
-	rx--;
-	if (lx > rx) {
-		lx ^= rx;  rx ^= lx;  lx ^= rx;
-	}
-	if (lx >= 320  ||  rx < 0)
-		return (FALSE);
-
-	if (lx < 0)	lx = 0;
-	if (rx >= 320)	rx = 320;
-
-	lm = leftmasks[lx & 31];
-	rm = rightmasks[rx & 31];
-
-	lx >>= 5;
-	rx >>= 5;
-
-	if (lx == rx) {
-		lm &= rm;
-		return ((linebuf[lx] & lm) != 0);
-	} else {
-		if (linebuf[lx] & lm)
-			return (TRUE);
-
-		lm = ~0;
-		do {
-			if (++lx == rx)
-				lm = rm;
-			if (linebuf[lx] & lm)
-				return (TRUE);
-		} while (lx < rx);
-
-		return (FALSE);
-	}
-}
-
-
-#if 0
-/*
- * Returns TRUE if you need to draw a polygon; FALSE if you don't.
- * The specified region is marked as used both cases.
- * Note: Marking a region actually means clearing the bits.
- */
-int
-testmarklinebuf (dummy, lx, rx)
-uint32		*dummy;
-register int32	lx, rx;
-{
-	register uint32	lm, rm;
-
-	if (lx == rx)
-		return (FALSE);
-
-	rx--;
-	if (lx > rx) {
-		lx ^= rx;  rx ^= lx;  lx ^= rx;
-	}
-	if (lx >= 320  ||  rx < 0)
-		return (FALSE);
-
-	if (lx < 0)	lx = 0;
-	if (rx >= 320)	rx = 320;
-
-	lm = leftmasks[lx & 31];
-	rm = rightmasks[rx & 31];
-
-	lx >>= 5;
-	rx >>= 5;
-
-	if (lx == rx) {
-		lm &= rm;
-		if (linebuf[lx] & lm) {
-			linebuf[lx] &= ~lm;
-			return (TRUE);
-		} else
-			return (FALSE);
-	} else {
-		register int	result = FALSE;
-
-		if (linebuf[lx] & lm)
-			result = TRUE;
-
-		linebuf[lx] &= ~lm;
-		lm = ~0;
-		do {
-			if (++lx == rx)
-				lm = rm;
-			if (linebuf[lx] & lm)
-				result = TRUE;
-			linebuf[lx] &= ~lm;
-		} while (lx < rx);
-
-		return (result);
-	}
-}
-
-
-void
-resetlinebuf (dummy)
-uint32	*dummy;
-{
-	register int32	*lb;
-	register int	i;
-
-	lb = (int32 *) linebuf;
-	for (i = 10;  --i >= 0; )
-		*lb++ = ~0;
-}
-
-
-int
-islinefull (dummy)
-uint32	*dummy;
-{
-	register int32	*lb;
-	register int	i;
-
-	lb = (int32 *) linebuf;
-	for (i = 10;  --i >= 0; )
-		if (*lb++)
-			return (FALSE);
-
-	return (TRUE);
-}
-
-#endif
-
-
-
 
 
 /***************************************************************************
@@ -804,6 +720,7 @@ uint32	*dummy;
  *
  * This is an expensive operation.  I'm relying on the probability that this
  * will be done seldom enough to not impact the frame rate significantly.
+ * (Coded walls are cheap now; their PLUTs come pre-faded.)
  */
 void
 fadecel (ccb, value)
@@ -828,6 +745,20 @@ frac16			value;
 		register int	i, r, g, b;
 
 		src = (int16 *) ccb->ccb_PLUTPtr;
+		if (fadepluts  &&
+		    src >= wallpluts  &&  src < wallpluts + nwallplutents)
+		{
+			/*
+			 * One of the walls'; pick the copy faded nearest
+			 * to this level.
+			 */
+			if ((i = value >> (16 - FADESHIFT)) < FADELEVELS)
+				ccb->ccb_PLUTPtr = fadepluts +
+						   i * nwallplutents +
+						   (src - wallpluts);
+			return;
+		}
+
 		dest = curscaledplut;
 		ccb->ccb_PLUTPtr = dest;
 		for (i = 32;  --i >= 0; ) {
@@ -875,34 +806,32 @@ frac16			value;
 void
 createbackwall ()
 {
-	static Vertex	stuff[4] = {
+	static Vertex	stuff[2] = {
 		{ 0,	-HALF_F16,	ZFADENEAR_F16	},
-		{ 0,	-HALF_F16,	ZFADEFAR_F16	},
-		{ 0,	HALF_F16,	ZFADEFAR_F16	},
 		{ 0,	HALF_F16,	ZFADENEAR_F16	},
 	};
-	register int32	i;
-	int32		*pdat;
-	int32		ydim, size, diff, color, r, g, b;
+	Vertex		proj[2];
+	int32		ydim, size;
 
-	if (!stuff[0].X) {
-		project (stuff, stuff, MAGIC, 0, CX, cy, 4);
-		stuff[0].X = 1;
-	}
+	/*
+	 * Projected afresh each time, as the render scale may have changed.
+	 * One gradient row per render scanline.  The cel spans the near end
+	 * of the fade, which doesn't move with the draw distance.  Every row
+	 * is a single color, which the port's cel engine draws as a fill.
+	 */
+	project (stuff, proj, magic, 0, cx, cy, 2);
 
-	ydim = stuff[3].Y - stuff[0].Y;
+	ydim = proj[1].Y - proj[0].Y;
 
 	size = sizeof (CCB) + ydim * sizeof (int32) * 2;
 	if (!(backwallcel = malloctype (size, MEMTYPE_CEL)))
 		die ("Can't create backwall.\n");
 
-	pdat = (int32 *) (backwallcel + 1);
-
 	backwallcel->ccb_Flags	= CCB_NPABS | CCB_SPABS | CCB_LDSIZE |
 				  CCB_LDPRS | CCB_LDPPMP | CCB_CCBPRE |
 				  CCB_YOXY | CCB_ACW | CCB_ACCW | CCB_ACE |
 				  CCB_BGND | CCB_NOBLK;
-	backwallcel->ccb_SourcePtr = (CelData *) pdat;
+	backwallcel->ccb_SourcePtr = (CelData *) (backwallcel + 1);
 	backwallcel->ccb_PLUTPtr= NULL;
 	backwallcel->ccb_PIXC	= 0x1F001F00;
 
@@ -917,14 +846,41 @@ createbackwall ()
 	backwallcel->ccb_Width	= 2;
 	backwallcel->ccb_Height	= ydim;
 	backwallcel->ccb_XPos	= 0;
-	backwallcel->ccb_YPos	= (cy - ydim / 2) << 16;
-	backwallcel->ccb_HDX	= 160 << 20;
+	backwallcel->ccb_YPos	= ((cy - ydim / 2) << 16) / rendscale;
+	backwallcel->ccb_HDX	= (wide >> 1) << 20;
 	backwallcel->ccb_VDX	= 0;
 	backwallcel->ccb_HDY	= 0;
-	backwallcel->ccb_VDY	= 1 << 16;
+	backwallcel->ccb_VDY	= ONE_VD / rendscale;
 	backwallcel->ccb_HDDX	=
 	backwallcel->ccb_HDDY	= 0;
 
+	shadebackwall ();
+}
+
+/*
+ * Fill in the backwall's gradient for the current draw distance.  Called
+ * again whenever the distance moves, so the ceiling and floor reach black
+ * exactly where the walls do.
+ */
+void
+shadebackwall ()
+{
+	static Vertex	stuff[4] = {
+		{ 0,	-HALF_F16,	ZFADENEAR_F16	},
+		{ 0,	-HALF_F16,	0		},
+		{ 0,	HALF_F16,	0		},
+		{ 0,	HALF_F16,	ZFADENEAR_F16	},
+	};
+	Vertex		proj[4];
+	register int32	i;
+	int32		*pdat;
+	int32		diff, color, r, g, b;
+
+	stuff[1].Z = stuff[2].Z = ZFADEFAR_F16;
+	project (stuff, proj, magic, 0, cx, cy, 4);
+
+	backwalldist = drawdist;
+	pdat = (int32 *) (backwallcel + 1);
 
 	/*
 	 * Gradation from ceiling color to black.
@@ -933,7 +889,7 @@ createbackwall ()
 	g = (ceilingcolor >> 5) & 0x1f;
 	b = ceilingcolor & 0x1f;
 
-	diff = stuff[1].Y - stuff[0].Y;
+	diff = proj[1].Y - proj[0].Y;
 	for (i = diff;  --i >= 0; ) {
 		color = ((r * i / diff) << 10) +
 			((g * i / diff) << 5) +
@@ -947,7 +903,7 @@ createbackwall ()
 	/*
 	 * Middle black band.
 	 */
-	diff = stuff[2].Y - stuff[1].Y;
+	diff = proj[2].Y - proj[1].Y;
 	for (i = diff;  --i >= 0; ) {
 		*pdat++ = 0;
 		*pdat++ = 0;
@@ -960,7 +916,7 @@ createbackwall ()
 	g = (floorcolor >> 5) & 0x1f;
 	b = floorcolor & 0x1f;
 
-	diff = stuff[3].Y - stuff[2].Y;
+	diff = proj[3].Y - proj[2].Y;
 
 	for (i = 0;  i < diff;  i++) {
 		color = ((r * i / diff) << 10) +
@@ -1043,3 +999,28 @@ register struct Point	*p;
 		 wide;
 	}
 }
+
+
+/***************************************************************************
+ * FasterMapCel() for corners that came out of the projection, which are in
+ * render pixels.  DrawCels() wants 3DO screen coordinates, so the result
+ * is scaled back down by the internal resolution multiplier.
+ */
+void
+rendmapcel (ccb, p)
+register struct CCB	*ccb;
+struct Point		*p;
+{
+	FasterMapCel (ccb, p);
+
+	if (rendscale > 1) {
+		ccb->ccb_XPos /= rendscale;
+		ccb->ccb_YPos /= rendscale;
+		ccb->ccb_HDX /= rendscale;
+		ccb->ccb_HDY /= rendscale;
+		ccb->ccb_VDX /= rendscale;
+		ccb->ccb_VDY /= rendscale;
+		ccb->ccb_HDDX /= rendscale;
+		ccb->ccb_HDDY /= rendscale;
+	}
+}
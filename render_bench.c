@@ -0,0 +1,1342 @@
+/*
+ * Render benchmark
+ * Draws a synthetic frame (backwall gradient, a perspective corridor of
+ * wall cels and a handful of keyed sprites) through the software cel
+ * engine and reports the time per frame.
+ *
+ *   RenderBench [test] [frames]
+ *
+ * With no test name every test is run.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "platform/platform_raster.h"
+#include "platform/platform_upscale.h"
+
+#define BASE_WIDTH 320
+#define BASE_HEIGHT 240
+#define TEX_SIZE 64
+#define NCORRIDOR 12
+#define NSPRITES 8
+#define SAMPLE_TEX_SIZE 1024
+#define SAMPLE_CEL_SIZE 200
+#define CROWD_TEX_SIZE 128
+#define NCROWD 256
+#define FADE_SHIFT 5
+#define FADE_LEVELS (1 << FADE_SHIFT)
+#define FADE_PLUTS 64
+#define FADE_MAXWALLS 512
+#define PRESENT_WIDTH 640
+#define PRESENT_HEIGHT 480
+#define UPSCALE_WIDTH 1920
+#define UPSCALE_HEIGHT 1080
+#define MAX_UPSCALE_THREADS 16
+#define LIST_BANDS 8
+
+// The synthetic scene
+typedef struct BenchScene {
+    PlatformTexture wall_tex;
+    PlatformTexture sprite_tex;
+    PlatformTexture back_tex;
+    CCB cels[1 + 2 * NCORRIDOR + NSPRITES];
+    int ncels;
+} BenchScene;
+
+typedef struct BenchPoint {
+    double x, y;
+} BenchPoint;
+
+static BenchScene g_scene;
+
+static double now_ms(void)
+{
+    return SDL_GetPerformanceCounter() * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static uint32 pack_rgba(int r, int g, int b, int a)
+{
+    return ((uint32)a << 24) | ((uint32)b << 16) | ((uint32)g << 8) | (uint32)r;
+}
+
+static void make_texture(PlatformTexture* tex, int w, int h)
+{
+    tex->gl_id = NULL;
+    tex->width = w;
+    tex->height = h;
+    tex->format = 4;
+    tex->tile_shift = 0;
+    tex->mip = NULL;
+    tex->data = calloc((size_t)w * h, sizeof(uint32));
+}
+
+// Map a cel onto a quadrilateral the way FasterMapCel() does, but from
+// sub-pixel corners (p[0] origin, p[1] end of the first row, p[3] end of
+// the first column).
+static void map_quad(CCB* ccb, const BenchPoint* p)
+{
+    int w = ccb->platform_texture->width;
+    int h = ccb->platform_texture->height;
+
+    ccb->ccb_XPos = (frac16)(p[0].x * 65536.0);
+    ccb->ccb_YPos = (frac16)(p[0].y * 65536.0);
+    ccb->ccb_HDX = (frac16)((p[1].x - p[0].x) / w * 1048576.0);
+    ccb->ccb_HDY = (frac16)((p[1].y - p[0].y) / w * 1048576.0);
+    ccb->ccb_VDX = (frac16)((p[3].x - p[0].x) / h * 65536.0);
+    ccb->ccb_VDY = (frac16)((p[3].y - p[0].y) / h * 65536.0);
+    ccb->ccb_HDDX = (frac16)((p[2].x - p[3].x - p[1].x + p[0].x) / ((double)w * h) * 1048576.0);
+    ccb->ccb_HDDY = (frac16)((p[2].y - p[3].y - p[1].y + p[0].y) / ((double)w * h) * 1048576.0);
+}
+
+static CCB* next_cel(BenchScene* scene, PlatformTexture* tex, uint32 flags)
+{
+    CCB* ccb = &scene->cels[scene->ncels++];
+
+    memset(ccb, 0, sizeof(*ccb));
+    ccb->platform_texture = tex;
+    ccb->ccb_Width = tex->width;
+    ccb->ccb_Height = tex->height;
+    ccb->ccb_Flags = flags;
+    if (scene->ncels > 1) {
+        scene->cels[scene->ncels - 2].ccb_NextPtr = ccb;
+    }
+    return ccb;
+}
+
+static void build_scene(BenchScene* scene)
+{
+    uint32* t;
+    int x, y, i;
+
+    // Brick wall texture
+    make_texture(&scene->wall_tex, TEX_SIZE, TEX_SIZE);
+    t = (uint32*)scene->wall_tex.data;
+    for (y = 0; y < TEX_SIZE; y++) {
+        for (x = 0; x < TEX_SIZE; x++) {
+            int mortar = (y % 16) == 0 || ((x + ((y / 16) & 1) * 16) % 32) == 0;
+            t[y * TEX_SIZE + x] = mortar ? pack_rgba(90, 90, 80, 255)
+                                         : pack_rgba(140 + (x ^ y) % 40, 50, 30, 255);
+        }
+    }
+
+    // Round sprite with transparent corners
+    make_texture(&scene->sprite_tex, TEX_SIZE, TEX_SIZE);
+    t = (uint32*)scene->sprite_tex.data;
+    for (y = 0; y < TEX_SIZE; y++) {
+        for (x = 0; x < TEX_SIZE; x++) {
+            int dx = x - TEX_SIZE / 2, dy = y - TEX_SIZE / 2;
+            if (dx * dx + dy * dy < (TEX_SIZE / 2) * (TEX_SIZE / 2)) {
+                t[y * TEX_SIZE + x] = pack_rgba(40 + x * 3, 200 - y * 2, 60, 255);
+            }
+        }
+    }
+
+    // Two-texel-wide ceiling/floor gradient, one row per scanline
+    make_texture(&scene->back_tex, 2, BASE_HEIGHT);
+    t = (uint32*)scene->back_tex.data;
+    for (y = 0; y < BASE_HEIGHT; y++) {
+        int d = y < BASE_HEIGHT / 2 ? BASE_HEIGHT / 2 - y : y - BASE_HEIGHT / 2;
+        uint32 c = y < BASE_HEIGHT / 2 ? pack_rgba(0, 0, d, 255) : pack_rgba(0, d / 2, 0, 255);
+        t[y * 2] = t[y * 2 + 1] = c;
+    }
+
+    scene->ncels = 0;
+
+    {
+        CCB* back = next_cel(scene, &scene->back_tex, CCB_BGND);
+        BenchPoint q[4] = {
+            { 0, 0 }, { BASE_WIDTH, 0 }, { BASE_WIDTH, BASE_HEIGHT }, { 0, BASE_HEIGHT }
+        };
+        map_quad(back, q);
+    }
+
+    // Corridor, far to near so nearer walls overdraw farther ones.  Wall
+    // cels are transposed like the game's: H runs down the screen and the
+    // perspective comes from HDDY.
+    for (i = NCORRIDOR - 1; i >= 0; i--) {
+        double z0 = 1.0 + i, z1 = 2.0 + i;
+        double cx = BASE_WIDTH / 2.0, cy = BASE_HEIGHT / 2.0, magic = BASE_WIDTH;
+        int side;
+
+        for (side = -1; side <= 1; side += 2) {
+            CCB* wall = next_cel(scene, &scene->wall_tex, CCB_BGND);
+            BenchPoint q[4];
+
+            q[0].x = cx + side * magic * 0.5 / z0;  q[0].y = cy - magic * 0.5 / z0;
+            q[1].x = q[0].x;                        q[1].y = cy + magic * 0.5 / z0;
+            q[3].x = cx + side * magic * 0.5 / z1;  q[3].y = cy - magic * 0.5 / z1;
+            q[2].x = q[3].x;                        q[2].y = cy + magic * 0.5 / z1;
+            map_quad(wall, q);
+        }
+    }
+
+    for (i = 0; i < NSPRITES; i++) {
+        CCB* sprite = next_cel(scene, &scene->sprite_tex, 0);
+        double size = 24.0 + i * 12.0;
+        double x = 20.0 + i * 36.0, y = BASE_HEIGHT / 2.0 - size / 4.0;
+        BenchPoint q[4] = {
+            { x, y }, { x + size, y }, { x + size, y + size }, { x, y + size }
+        };
+        map_quad(sprite, q);
+    }
+
+    scene->cels[scene->ncels - 1].ccb_Flags |= CCB_LAST;
+}
+
+static uint32 checksum(const uint32* p, size_t n)
+{
+    uint32 sum = 0;
+
+    while (n--) sum = sum * 31 + *p++;
+    return sum;
+}
+
+// Allocate a full-screen target at the given render scale
+static int init_target(RasterTarget* rt, int scale)
+{
+    rt->width = BASE_WIDTH * scale;
+    rt->height = BASE_HEIGHT * scale;
+    rt->stride = rt->width;
+    rt->clip_top = 0;
+    rt->clip_bottom = rt->height;
+    rt->scale = scale;
+    rt->column_walls = 1;
+    rt->rgb555 = 0;
+    rt->pixels = calloc((size_t)rt->width * rt->height, sizeof(uint32));
+    if (!rt->pixels) {
+        printf("Out of memory at scale %d\n", scale);
+        return 0;
+    }
+    return 1;
+}
+
+static double time_frames(const RasterTarget* rt, const CCB* cels, int frames)
+{
+    double t0;
+    int i;
+
+    raster_draw_cels(rt, cels);     // Warm up
+    t0 = now_ms();
+    for (i = 0; i < frames; i++) {
+        raster_draw_cels(rt, cels);
+    }
+    return (now_ms() - t0) / frames;
+}
+
+
+/***************************************************************************
+ * Frame time at each internal render scale.
+ */
+static void bench_scale(int frames)
+{
+    int scale;
+
+    printf("scale  resolution   ms/frame   Mpix/s   checksum\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt;
+        double ms;
+
+        if (!init_target(&rt, scale)) return;
+        ms = time_frames(&rt, g_scene.cels, frames);
+
+        printf("%4dx  %4dx%-5d  %9.3f  %7.1f   %08X\n", scale, rt.width, rt.height, ms,
+               (double)rt.width * rt.height / (ms * 1000.0),
+               checksum(rt.pixels, (size_t)rt.width * rt.height));
+        free(rt.pixels);
+    }
+}
+
+
+/***************************************************************************
+ * Wall cels through the general quad path against the column path, on
+ * the whole scene and on the corridor walls alone.
+ */
+static void bench_walls(int frames)
+{
+    // The corridor follows the backwall in the chain
+    CCB* walls = &g_scene.cels[1];
+    CCB* last = &g_scene.cels[2 * NCORRIDOR];
+    int scale, pass;
+
+    printf("scale  cels      quads ms  columns ms  speedup  differing\n");
+    for (scale = 1; scale <= 4; scale++) {
+        for (pass = 0; pass < 2; pass++) {
+            const CCB* cels = pass ? walls : g_scene.cels;
+            RasterTarget rt, rc;
+            double quads, columns;
+            size_t i, n, diff = 0;
+
+            if (pass) last->ccb_Flags |= CCB_LAST;
+            if (!init_target(&rt, scale) || !init_target(&rc, scale)) {
+                free(rt.pixels);
+                last->ccb_Flags &= ~CCB_LAST;
+                return;
+            }
+            rt.column_walls = 0;
+
+            quads = time_frames(&rt, cels, frames);
+            columns = time_frames(&rc, cels, frames);
+
+            n = (size_t)rt.width * rt.height;
+            for (i = 0; i < n; i++) {
+                diff += ((uint32*)rt.pixels)[i] != ((uint32*)rc.pixels)[i];
+            }
+            printf("%4dx  %-6s  %9.3f  %10.3f  %6.2fx  %8.3f%%\n", scale,
+                   pass ? "walls" : "scene", quads, columns, quads / columns,
+                   100.0 * diff / n);
+
+            if (pass) last->ccb_Flags &= ~CCB_LAST;
+            free(rt.pixels);
+            free(rc.pixels);
+        }
+    }
+}
+
+
+/***************************************************************************
+ * Texel fetch cost with linear and tiled textures.  A large texture is
+ * drawn as one cel, scaled down and rotated through a quarter turn; the
+ * further it turns, the more a linear texture is read across its rows.
+ */
+static void bench_sample(int frames)
+{
+    static const int shifts[] = { 0, 2, 3 };
+    PlatformTexture tex[3];
+    RasterTarget rt;
+    CCB cel;
+    int angle, i, x, y;
+
+    for (i = 0; i < 3; i++) {
+        uint32* t;
+
+        make_texture(&tex[i], SAMPLE_TEX_SIZE, SAMPLE_TEX_SIZE);
+        t = (uint32*)tex[i].data;
+        for (y = 0; y < SAMPLE_TEX_SIZE; y++) {
+            for (x = 0; x < SAMPLE_TEX_SIZE; x++) {
+                t[y * SAMPLE_TEX_SIZE + x] = pack_rgba(x ^ y, x + y, x * 3, 255);
+            }
+        }
+        if (!raster_tile_texture(&tex[i], shifts[i])) {
+            printf("Can't tile texture\n");
+            return;
+        }
+    }
+    if (!init_target(&rt, 2)) return;
+
+    memset(&cel, 0, sizeof(cel));
+    cel.ccb_Width = cel.ccb_Height = SAMPLE_TEX_SIZE;
+    cel.ccb_Flags = CCB_BGND | CCB_LAST;
+
+    printf("angle   linear ms   4x4 ms   8x8 ms   match\n");
+    for (angle = 0; angle <= 90; angle += 15) {
+        double a = angle * 3.14159265358979 / 180.0;
+        double c = cos(a) * SAMPLE_CEL_SIZE / 2, s = sin(a) * SAMPLE_CEL_SIZE / 2;
+        double ox = BASE_WIDTH / 2.0, oy = BASE_HEIGHT / 2.0;
+        BenchPoint q[4];
+        double ms[3];
+        uint32 sum[3];
+
+        q[0].x = ox - c + s;  q[0].y = oy - s - c;
+        q[1].x = ox + c + s;  q[1].y = oy + s - c;
+        q[2].x = ox + c - s;  q[2].y = oy + s + c;
+        q[3].x = ox - c - s;  q[3].y = oy - s + c;
+
+        for (i = 0; i < 3; i++) {
+            cel.platform_texture = &tex[i];
+            map_quad(&cel, q);
+            memset(rt.pixels, 0, (size_t)rt.width * rt.height * sizeof(uint32));
+            ms[i] = time_frames(&rt, &cel, frames);
+            sum[i] = checksum(rt.pixels, (size_t)rt.width * rt.height);
+        }
+        printf("%5d  %10.3f  %7.3f  %7.3f   %s\n", angle, ms[0], ms[1], ms[2],
+               sum[0] == sum[1] && sum[0] == sum[2] ? "yes" : "NO");
+    }
+
+    free(rt.pixels);
+    for (i = 0; i < 3; i++) free(tex[i].data);
+}
+
+
+// A monster for the crowd: an oval with transparent surroundings
+static void make_crowd_texture(PlatformTexture* tex)
+{
+    uint32* t;
+    int x, y;
+
+    make_texture(tex, CROWD_TEX_SIZE, CROWD_TEX_SIZE);
+    t = (uint32*)tex->data;
+    for (y = 0; y < CROWD_TEX_SIZE; y++) {
+        for (x = 0; x < CROWD_TEX_SIZE; x++) {
+            int dx = x - CROWD_TEX_SIZE / 2, dy = y - CROWD_TEX_SIZE / 2;
+            if (dx * dx * 4 + dy * dy < (CROWD_TEX_SIZE / 2) * (CROWD_TEX_SIZE / 2)) {
+                t[y * CROWD_TEX_SIZE + x] = pack_rgba(x * 2, 255 - y, (x ^ y) & 255, 255);
+            }
+        }
+    }
+}
+
+// Chain NCROWD cels of tex into rows of monsters, smaller towards the horizon
+static void build_crowd(CCB* cels, PlatformTexture* tex)
+{
+    int i;
+
+    for (i = 0; i < NCROWD; i++) {
+        double size = 4.0 + (i % 16) * 2.0;
+        double cx = 10.0 + (i * 37) % (BASE_WIDTH - 20);
+        double cy = BASE_HEIGHT / 2.0 + size;
+        BenchPoint q[4] = {
+            { cx - size / 2, cy - size }, { cx + size / 2, cy - size },
+            { cx + size / 2, cy }, { cx - size / 2, cy }
+        };
+
+        cels[i].ccb_Width = cels[i].ccb_Height = CROWD_TEX_SIZE;
+        cels[i].platform_texture = tex;
+        map_quad(&cels[i], q);
+        cels[i].ccb_NextPtr = i + 1 < NCROWD ? &cels[i + 1] : NULL;
+    }
+    cels[NCROWD - 1].ccb_Flags |= CCB_LAST;
+}
+
+
+/***************************************************************************
+ * A crowd of distant monsters: many full-size sprite frames mapped onto
+ * small quads, drawn from the full texture and from its mip chain.
+ */
+static void bench_mips(int frames)
+{
+    PlatformTexture tex[2];
+    CCB* cels;
+    int scale, i, x;
+
+    if (!(cels = (CCB*)calloc(NCROWD, sizeof(CCB)))) return;
+    for (i = 0; i < 2; i++) {
+        make_crowd_texture(&tex[i]);
+    }
+    printf("Mip levels: %d\n", raster_build_mips(&tex[1]));
+
+    build_crowd(cels, &tex[0]);
+
+    printf("scale   full ms   mips ms   speedup\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt;
+        double ms[2];
+
+        if (!init_target(&rt, scale)) break;
+        for (i = 0; i < 2; i++) {
+            for (x = 0; x < NCROWD; x++) cels[x].platform_texture = &tex[i];
+            ms[i] = time_frames(&rt, cels, frames);
+        }
+        printf("%4dx  %8.3f  %8.3f  %7.2fx\n", scale, ms[0], ms[1], ms[0] / ms[1]);
+        free(rt.pixels);
+    }
+
+    free(cels);
+}
+
+
+/***************************************************************************
+ * The scene into an RGBA32 frame against an RGB555 frame widened for
+ * display, as DisplayScreen() does in 16-bit mode.  The two must agree
+ * to five bits a channel.
+ */
+static void bench_rgb555(int frames)
+{
+    int scale, i;
+
+    printf("scale   rgba32 ms   rgb555 ms  widen ms  555 total  speedup  match\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt, rs;
+        uint32* shown;
+        double full, half, widen, t0;
+        size_t n, j, diff = 0;
+
+        if (!init_target(&rt, scale) || !init_target(&rs, scale)) {
+            free(rt.pixels);
+            return;
+        }
+        rs.rgb555 = 1;
+        n = (size_t)rt.width * rt.height;
+        if (!(shown = (uint32*)malloc(n * sizeof(uint32)))) {
+            free(rt.pixels);
+            free(rs.pixels);
+            return;
+        }
+
+        full = time_frames(&rt, g_scene.cels, frames);
+        half = time_frames(&rs, g_scene.cels, frames);
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            raster_rgb555_to_rgba32(shown, (const uint16*)rs.pixels, n);
+        }
+        widen = (now_ms() - t0) / frames;
+
+        for (j = 0; j < n; j++) {
+            diff += (((uint32*)rt.pixels)[j] ^ shown[j]) & 0xF8F8F8;
+        }
+        printf("%4dx  %10.3f  %10.3f  %8.3f  %9.3f  %6.2fx   %s\n", scale, full, half, widen,
+               half + widen, full / (half + widen), diff ? "NO" : "yes");
+
+        free(shown);
+        free(rt.pixels);
+        free(rs.pixels);
+    }
+}
+
+
+/***************************************************************************
+ * The scene with its sprites run through the pixel processor.  "normal"
+ * loads a PIXC that leaves pixels as they are and must match "opaque".
+ */
+static void bench_blend(int frames)
+{
+    static const struct {
+        const char* name;
+        uint32 ppmp;
+    } modes[] = {
+        { "opaque", 0 },
+        { "normal", PPMP_MODE_NORMAL },
+        { "average", PPMP_MODE_AVERAGE },
+        { "shade", PPMPC_1S_PDC | PPMPC_MF_4 | PPMPC_SF_8 },
+        { "additive", PPMPC_1S_PDC | PPMPC_MF_8 | PPMPC_SF_16 | PPMPC_2S_CFBD },
+    };
+    CCB* sprites = &g_scene.cels[1 + 2 * NCORRIDOR];
+    int scale, mode, i;
+
+    printf("scale  mode        ms/frame   checksum\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt;
+
+        if (!init_target(&rt, scale)) return;
+        for (mode = 0; mode < (int)(sizeof(modes) / sizeof(modes[0])); mode++) {
+            double ms;
+
+            for (i = 0; i < NSPRITES; i++) {
+                sprites[i].ccb_PIXC = modes[mode].ppmp | (modes[mode].ppmp << PPMP_1_SHIFT);
+                if (modes[mode].ppmp) sprites[i].ccb_Flags |= CCB_LDPPMP;
+                else sprites[i].ccb_Flags &= ~CCB_LDPPMP;
+            }
+            // Blended pixels depend on what was there, so start clean
+            memset(rt.pixels, 0, (size_t)rt.width * rt.height * sizeof(uint32));
+            raster_draw_cels(&rt, g_scene.cels);
+            {
+                uint32 sum = checksum(rt.pixels, (size_t)rt.width * rt.height);
+
+                ms = time_frames(&rt, g_scene.cels, frames);
+                printf("%4dx  %-9s  %9.3f   %08X\n", scale, modes[mode].name, ms, sum);
+            }
+        }
+        free(rt.pixels);
+    }
+
+    for (i = 0; i < NSPRITES; i++) {
+        sprites[i].ccb_PIXC = 0;
+        sprites[i].ccb_Flags &= ~CCB_LDPPMP;
+    }
+}
+
+
+/***************************************************************************
+ * Per-frame cost of fading coded walls into the distance: scaling each
+ * wall's 32-entry PLUT as fadecel() used to, against picking one of the
+ * fade ramps built when the walls load.  rend.c doesn't build outside
+ * the 3DO tree, so both are written out here the way it does them.
+ */
+static uint16 fade_entry(uint16 c, int32 value)
+{
+    int r = (c >> 10) & 0x1F, g = (c >> 5) & 0x1F, b = c & 0x1F;
+
+    return (uint16)((b * value >> 16) | ((g * value >> 16) << 5) | ((r * value >> 16) << 10));
+}
+
+static void bench_fade(int frames)
+{
+    static const int counts[] = { 32, 128, 512 };
+    int nents = FADE_PLUTS * 32;
+    uint16* pluts = malloc((size_t)nents * sizeof(uint16));
+    uint16* ramps = calloc((size_t)FADE_LEVELS * nents + 32, sizeof(uint16));
+    uint16* scaled = malloc((size_t)FADE_MAXWALLS * 32 * sizeof(uint16));
+    const uint16* volatile plut[FADE_MAXWALLS];     // Stands in for ccb_PLUTPtr
+    int32 value[FADE_MAXWALLS];
+    volatile uint16 sink = 0;
+    double t0, build_ms, frame_ms;
+    int i, j, k, f, level, maxerr = 0;
+
+    if (!pluts || !ramps || !scaled) {
+        printf("Out of memory\n");
+        free(pluts);
+        free(ramps);
+        free(scaled);
+        return;
+    }
+    for (i = 0; i < nents; i++) pluts[i] = (uint16)((i * 2654435761u) >> 17);
+
+    t0 = now_ms();
+    for (level = 0; level < FADE_LEVELS; level++) {
+        int32 scale = (level << (16 - FADE_SHIFT)) + (1 << (15 - FADE_SHIFT));
+
+        for (i = 0; i < nents; i++) ramps[level * nents + i] = fade_entry(pluts[i], scale);
+    }
+    build_ms = now_ms() - t0;
+
+    // Fade values spread from just past the near plane out to the far one
+    for (i = 0; i < FADE_MAXWALLS; i++) value[i] = 65535 - (int32)((i * 40503u) & 0xFFFF);
+    for (i = 0; i < FADE_MAXWALLS; i++) {
+        const uint16* ramp = ramps + (value[i] >> (16 - FADE_SHIFT)) * nents;
+        int p = (i % FADE_PLUTS) * 32;
+
+        for (k = 0; k < 32; k++) {
+            uint16 a = fade_entry(pluts[p + k], value[i]), b = ramp[p + k];
+
+            for (j = 0; j < 15; j += 5) {
+                int d = abs(((a >> j) & 0x1F) - ((b >> j) & 0x1F));
+                if (d > maxerr) maxerr = d;
+            }
+        }
+    }
+
+    frame_ms = 0;
+    {
+        RasterTarget rt;
+
+        if (init_target(&rt, 1)) {
+            frame_ms = time_frames(&rt, g_scene.cels, frames);
+            free(rt.pixels);
+        }
+    }
+
+    printf("ramps: %d PLUTs x %d levels, %.1f KB, built in %.3f ms, max error %d\n",
+           FADE_PLUTS, FADE_LEVELS, (FADE_LEVELS * nents + 32) * sizeof(uint16) / 1024.0,
+           build_ms, maxerr);
+    printf("walls   scaled us   ramps us   speedup   scaled %% of 1x frame\n");
+    for (i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); i++) {
+        int n = counts[i];
+        double us[2];
+
+        // Scale a PLUT per wall into the frame's scratch buffer
+        t0 = now_ms();
+        for (f = 0; f < frames; f++) {
+            uint16* dest = scaled;
+
+            for (j = 0; j < n; j++) {
+                const uint16* src = pluts + (j % FADE_PLUTS) * 32;
+
+                plut[j] = dest;
+                for (k = 0; k < 32; k++) *dest++ = fade_entry(src[k], value[j]);
+            }
+            sink += scaled[(f * 7) % (n * 32)];
+        }
+        us[0] = (now_ms() - t0) * 1000.0 / frames;
+
+        // Point each wall at its ramp
+        t0 = now_ms();
+        for (f = 0; f < frames; f++) {
+            for (j = 0; j < n; j++) {
+                int32 l = value[j] >> (16 - FADE_SHIFT);
+
+                plut[j] = ramps + l * nents + (j % FADE_PLUTS) * 32;
+            }
+        }
+        us[1] = (now_ms() - t0) * 1000.0 / frames;
+        sink += *plut[n - 1];
+
+        printf("%5d  %10.2f  %9.2f  %7.1fx  %8.1f%%\n", n, us[0], us[1],
+               us[1] > 0 ? us[0] / us[1] : 0.0,
+               frame_ms > 0 ? us[0] / (frame_ms * 10.0) : 0.0);
+    }
+
+    free(pluts);
+    free(ramps);
+    free(scaled);
+}
+
+
+/***************************************************************************
+ * A screen fade as DisplayScreen() applies it: one pass over the frame
+ * on its way to display, against the frame's draw time.  The damage
+ * flash's tint is used so every channel is scaled differently.
+ */
+static void bench_screenfade(int frames)
+{
+    int32 r = 256, g = 160, b = 96;
+    int scale, i;
+
+    printf("scale   frame ms   fade ms  555 widen+fade ms   %% of frame  match\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt;
+        uint32* shown;
+        uint16* half;
+        double frame, fade, widen, t0;
+        size_t n, j, diff = 0;
+
+        if (!init_target(&rt, scale)) return;
+        n = (size_t)rt.width * rt.height;
+        shown = (uint32*)malloc(n * sizeof(uint32));
+        half = (uint16*)malloc(n * sizeof(uint16));
+        if (!shown || !half) {
+            free(shown);
+            free(half);
+            free(rt.pixels);
+            return;
+        }
+
+        frame = time_frames(&rt, g_scene.cels, frames);
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            raster_fade_rgba32(shown, (const uint32*)rt.pixels, n, r, g, b);
+        }
+        fade = (now_ms() - t0) / frames;
+
+        for (j = 0; j < n; j++) {
+            uint32 c = ((uint32*)rt.pixels)[j];
+            uint32 want = (c & 0xFF000000) | ((((c >> 16) & 0xFF) * b >> 8) << 16) |
+                          ((((c >> 8) & 0xFF) * g >> 8) << 8) | ((c & 0xFF) * r >> 8);
+
+            diff += shown[j] != want;
+            half[j] = raster_rgb555(c);
+        }
+
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            raster_fade_rgb555_to_rgba32(shown, half, n, r, g, b);
+        }
+        widen = (now_ms() - t0) / frames;
+
+        printf("%4dx  %9.3f  %8.3f  %17.3f  %10.1f%%  %s\n", scale, frame, fade, widen,
+               fade * 100.0 / frame, diff ? "NO" : "yes");
+
+        free(shown);
+        free(half);
+        free(rt.pixels);
+    }
+}
+
+
+/***************************************************************************
+ * The backwall alone: its gradient sampled as a texture, the same cel
+ * taken as row fills, and the gradient filled straight from a row table.
+ * All three must leave the same frame.
+ */
+static void bench_backwall(int frames)
+{
+    CCB cel = g_scene.cels[0];
+    PlatformTexture wide;
+    const uint32* grad = (const uint32*)g_scene.back_tex.data;
+    uint32* rows;
+    int scale, i, y;
+
+    // Four texels a row is too wide to be taken for fills
+    make_texture(&wide, 4, BASE_HEIGHT);
+    for (y = 0; y < BASE_HEIGHT; y++) {
+        for (i = 0; i < 4; i++) ((uint32*)wide.data)[y * 4 + i] = grad[y * 2];
+    }
+    cel.ccb_Flags |= CCB_LAST;
+    cel.ccb_NextPtr = NULL;
+
+    printf("scale   texture ms   cel ms   rows ms   speedup  match\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt;
+        CCB textured = cel;
+        double ms[3], t0;
+        uint32 sum[3];
+        size_t n;
+
+        if (!init_target(&rt, scale)) break;
+        n = (size_t)rt.width * rt.height;
+        if (!(rows = (uint32*)malloc((size_t)rt.height * sizeof(uint32)))) {
+            free(rt.pixels);
+            break;
+        }
+        for (y = 0; y < rt.height; y++) rows[y] = grad[y / scale * 2];
+
+        textured.platform_texture = &wide;
+        textured.ccb_HDX = cel.ccb_HDX / 2;
+        ms[0] = time_frames(&rt, &textured, frames);
+        sum[0] = checksum(rt.pixels, n);
+        memset(rt.pixels, 0, n * sizeof(uint32));
+        ms[1] = time_frames(&rt, &cel, frames);
+        sum[1] = checksum(rt.pixels, n);
+        memset(rt.pixels, 0, n * sizeof(uint32));
+        raster_fill_rows(&rt, 0, rows, rt.height);
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            raster_fill_rows(&rt, 0, rows, rt.height);
+        }
+        ms[2] = (now_ms() - t0) / frames;
+        sum[2] = checksum(rt.pixels, n);
+
+        printf("%4dx  %11.3f  %7.3f  %8.3f  %7.2fx   %s\n", scale, ms[0], ms[1], ms[2],
+               ms[0] / ms[1], sum[0] == sum[1] && sum[1] == sum[2] ? "yes" : "NO");
+        free(rows);
+        free(rt.pixels);
+    }
+    free(wide.data);
+}
+
+
+/***************************************************************************
+ * Retained HUD layer: the gun drawn on every frame, against the gun drawn
+ * once into a layer and laid over each frame with one masked blit of the
+ * rows it covers.
+ */
+static void bench_hud(int frames)
+{
+    CCB gun = g_scene.cels[0];
+    BenchPoint q[4] = {
+        { BASE_WIDTH / 2.0 - 64, BASE_HEIGHT - 96 }, { BASE_WIDTH / 2.0 + 64, BASE_HEIGHT - 96 },
+        { BASE_WIDTH / 2.0 + 64, BASE_HEIGHT + 8 }, { BASE_WIDTH / 2.0 - 64, BASE_HEIGHT + 8 }
+    };
+    int scale, i;
+
+    gun.platform_texture = &g_scene.sprite_tex;
+    gun.ccb_Flags = (gun.ccb_Flags & ~CCB_BGND) | CCB_LAST;
+    gun.ccb_NextPtr = NULL;
+    map_quad(&gun, q);
+
+    printf("scale   draw ms   composite ms   speedup  match\n");
+    for (scale = 1; scale <= 4; scale++) {
+        RasterTarget rt, layer;
+        double ms[2], t0;
+        uint32 sum[2];
+        size_t n, offset;
+        int top, bottom, y;
+
+        if (!init_target(&rt, scale)) break;
+        if (!init_target(&layer, scale)) {
+            free(rt.pixels);
+            break;
+        }
+        n = (size_t)rt.width * rt.height;
+
+        raster_draw_cels(&layer, &gun);
+        for (top = 0; top < layer.height; top++) {
+            for (i = 0; i < layer.width && !((uint32*)layer.pixels)[top * layer.width + i]; i++);
+            if (i < layer.width) break;
+        }
+        for (bottom = top, y = top; y < layer.height; y++) {
+            for (i = 0; i < layer.width && !((uint32*)layer.pixels)[y * layer.width + i]; i++);
+            if (i < layer.width) bottom = y + 1;
+        }
+        offset = (size_t)top * rt.width;
+
+        raster_draw_cels(&rt, g_scene.cels);
+        ms[0] = time_frames(&rt, &gun, frames);
+        sum[0] = checksum(rt.pixels, n);
+
+        raster_draw_cels(&rt, g_scene.cels);
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            raster_overlay((uint32*)rt.pixels + offset, (uint32*)layer.pixels + offset,
+                           (size_t)(bottom - top) * rt.width, 0);
+        }
+        ms[1] = (now_ms() - t0) / frames;
+        sum[1] = checksum(rt.pixels, n);
+
+        printf("%4dx  %8.3f  %13.3f  %7.2fx   %s\n", scale, ms[0], ms[1], ms[0] / ms[1],
+               sum[0] == sum[1] ? "yes" : "NO");
+        free(layer.pixels);
+        free(rt.pixels);
+    }
+}
+
+
+/***************************************************************************
+ * Presenting a frame through SDL's software renderer: a texture made,
+ * filled and destroyed every frame (RGB555 widened into a staging buffer
+ * first), against one streaming texture locked and filled in place.
+ */
+static void present_frame(SDL_Renderer* renderer, SDL_Texture* texture)
+{
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+}
+
+static void bench_present(int frames)
+{
+    SDL_Surface* window;
+    SDL_Renderer* renderer;
+    SDL_version version;
+    int scale, rgb555;
+
+    window = SDL_CreateRGBSurfaceWithFormat(0, PRESENT_WIDTH, PRESENT_HEIGHT, 32,
+                                            SDL_PIXELFORMAT_RGBA32);
+    if (!window || !(renderer = SDL_CreateSoftwareRenderer(window))) {
+        printf("Can't create software renderer: %s\n", SDL_GetError());
+        if (window) SDL_FreeSurface(window);
+        return;
+    }
+
+    /* Software renderer times depend on the SDL build; say which one ran */
+    SDL_GetVersion(&version);
+    printf("SDL %d.%d.%d software renderer\n", version.major, version.minor, version.patch);
+    printf("format  scale   per-frame ms   streaming ms   speedup\n");
+    for (rgb555 = 0; rgb555 <= 1; rgb555++) {
+        for (scale = 1; scale <= 4; scale++) {
+            RasterTarget rt;
+            SDL_Texture* texture;
+            uint32* staging;
+            double ms[2], t0;
+            size_t n;
+            int i;
+
+            if (!init_target(&rt, scale)) break;
+            n = (size_t)rt.width * rt.height;
+            if (!(staging = (uint32*)malloc(n * sizeof(uint32)))) {
+                free(rt.pixels);
+                break;
+            }
+            rt.rgb555 = rgb555;
+            raster_draw_cels(&rt, g_scene.cels);
+
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                const void* frame = rt.pixels;
+                texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                            SDL_TEXTUREACCESS_STREAMING, rt.width, rt.height);
+                if (rgb555) {
+                    raster_rgb555_to_rgba32(staging, (const uint16*)rt.pixels, n);
+                    frame = staging;
+                }
+                SDL_UpdateTexture(texture, NULL, frame, rt.width * 4);
+                present_frame(renderer, texture);
+                SDL_DestroyTexture(texture);
+            }
+            ms[0] = (now_ms() - t0) / frames;
+
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                        SDL_TEXTUREACCESS_STREAMING, rt.width, rt.height);
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                void* pixels;
+                int pitch, y;
+
+                SDL_LockTexture(texture, NULL, &pixels, &pitch);
+                for (y = 0; y < rt.height; y++) {
+                    uint32* dst = (uint32*)((ubyte*)pixels + (size_t)y * pitch);
+                    if (rgb555) {
+                        raster_rgb555_to_rgba32(dst, (const uint16*)rt.pixels + (size_t)y * rt.width,
+                                                rt.width);
+                    } else {
+                        memcpy(dst, (const uint32*)rt.pixels + (size_t)y * rt.width,
+                               rt.width * sizeof(uint32));
+                    }
+                }
+                SDL_UnlockTexture(texture);
+                present_frame(renderer, texture);
+            }
+            ms[1] = (now_ms() - t0) / frames;
+            SDL_DestroyTexture(texture);
+
+            printf("%-6s  %4dx  %13.3f  %13.3f  %7.2fx\n", rgb555 ? "rgb555" : "rgba32", scale,
+                   ms[0], ms[1], ms[0] / ms[1]);
+            free(staging);
+            free(rt.pixels);
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(window);
+}
+
+
+/***************************************************************************
+ * Dirty-rectangle presentation: readying and uploading a whole frame
+ * into a streaming texture, against comparing it with a copy of what the
+ * texture holds and uploading only the box that differs.  A menu (one
+ * line of text changing) and gameplay (every pixel changing, compared
+ * every frame; the presenter backs off from those) are timed, with the
+ * share of the frame uploaded for the menu.  The texture has to end up
+ * the same either way.
+ */
+static void ready_area(SDL_Texture* texture, const ubyte* frame, int32 width, int rgb555,
+                       const int32 area[4])
+{
+    SDL_Rect rect;
+    void* pixels;
+    int pitch, y;
+    int bpp = rgb555 ? 2 : 4;
+
+    rect.x = area[0];
+    rect.y = area[1];
+    rect.w = area[2] - area[0];
+    rect.h = area[3] - area[1];
+    SDL_LockTexture(texture, &rect, &pixels, &pitch);
+    for (y = 0; y < rect.h; y++) {
+        uint32* dst = (uint32*)((ubyte*)pixels + (size_t)y * pitch);
+        const ubyte* src = frame + ((size_t)(rect.y + y) * width + rect.x) * bpp;
+
+        if (rgb555) raster_rgb555_to_rgba32(dst, (const uint16*)src, rect.w);
+        else memcpy(dst, src, (size_t)rect.w * sizeof(uint32));
+    }
+    SDL_UnlockTexture(texture);
+}
+
+static void bench_dirty(int frames)
+{
+    SDL_Surface* window;
+    SDL_Renderer* renderer;
+    int scale, rgb555;
+
+    window = SDL_CreateRGBSurfaceWithFormat(0, PRESENT_WIDTH, PRESENT_HEIGHT, 32,
+                                            SDL_PIXELFORMAT_RGBA32);
+    if (!window || !(renderer = SDL_CreateSoftwareRenderer(window))) {
+        printf("Can't create software renderer: %s\n", SDL_GetError());
+        if (window) SDL_FreeSurface(window);
+        return;
+    }
+
+    printf("format  scale  whole ms   menu ms  speedup  uploaded   game ms  overhead  same\n");
+    for (rgb555 = 0; rgb555 <= 1; rgb555++) {
+        for (scale = 1; scale <= 4; scale++) {
+            RasterTarget rt;
+            SDL_Texture* texture;
+            ubyte *frames_buf[4], *shadow;
+            size_t n, bytes;
+            int32 all[4], area[4];
+            double ms[3], t0, uploaded = 0.0;
+            int i, j, bpp = rgb555 ? 2 : 4, same = 1, test;
+
+            if (!init_target(&rt, scale)) break;
+            rt.rgb555 = rgb555;
+            raster_draw_cels(&rt, g_scene.cels);
+            n = (size_t)rt.width * rt.height;
+            bytes = n * bpp;
+            shadow = (ubyte*)malloc(bytes);
+            for (i = 0; i < 4; i++) frames_buf[i] = (ubyte*)malloc(bytes);
+            if (!shadow || !frames_buf[0] || !frames_buf[1] || !frames_buf[2] || !frames_buf[3]) {
+                printf("Out of memory\n");
+                free(shadow);
+                for (i = 0; i < 4; i++) free(frames_buf[i]);
+                free(rt.pixels);
+                break;
+            }
+
+            // Menu: a highlight moving between two lines of text.
+            // Gameplay: every pixel different from one frame to the next.
+            for (i = 0; i < 4; i++) memcpy(frames_buf[i], rt.pixels, bytes);
+            for (i = 0; i < 2; i++) {
+                int32 y, x, top = (108 + 14 * i) * scale;
+
+                for (y = top; y < top + 12 * scale; y++) {
+                    for (x = 100 * scale; x < 220 * scale; x++) {
+                        ubyte* p = frames_buf[i] + ((size_t)y * rt.width + x) * bpp;
+                        p[0] ^= 0x1F;
+                    }
+                }
+            }
+            for (j = 0; j < (int)bytes; j += bpp) frames_buf[3][j] ^= 0x01;
+
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                        SDL_TEXTUREACCESS_STREAMING, rt.width, rt.height);
+            all[0] = all[1] = 0;
+            all[2] = rt.width;
+            all[3] = rt.height;
+
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                ready_area(texture, frames_buf[i & 1], rt.width, rgb555, all);
+            }
+            ms[0] = (now_ms() - t0) / frames;
+
+            for (test = 1; test <= 2; test++) {
+                const ubyte* a = frames_buf[test == 1 ? 0 : 2];
+                const ubyte* b = frames_buf[test == 1 ? 1 : 3];
+                uint32* check;
+                void* pixels;
+                int pitch, y;
+
+                memcpy(shadow, a, bytes);
+                ready_area(texture, a, rt.width, rgb555, all);
+                t0 = now_ms();
+                for (i = 0; i < frames; i++) {
+                    const ubyte* frame = (i & 1) ? a : b;
+                    area[0] = area[1] = 0;
+                    area[2] = rt.width;
+                    area[3] = rt.height;
+                    if (raster_diff_box(frame, (size_t)rt.width * bpp, shadow,
+                                        (size_t)rt.width * bpp, bpp, area)) {
+                        ready_area(texture, frame, rt.width, rgb555, area);
+                    }
+                }
+                ms[test] = (now_ms() - t0) / frames;
+                if (test == 1) {
+                    uploaded = 100.0 * (area[2] - area[0]) * (area[3] - area[1]) / n;
+                }
+
+                // The last frame shown was a; the texture must hold all of it
+                if ((check = (uint32*)malloc(n * sizeof(uint32)))) {
+                    if (rgb555) raster_rgb555_to_rgba32(check, (const uint16*)a, n);
+                    else memcpy(check, a, bytes);
+                    SDL_LockTexture(texture, NULL, &pixels, &pitch);
+                    for (y = 0; y < rt.height; y++) {
+                        if (memcmp((ubyte*)pixels + (size_t)y * pitch, check + (size_t)y * rt.width,
+                                   rt.width * sizeof(uint32))) same = 0;
+                    }
+                    SDL_UnlockTexture(texture);
+                    free(check);
+                }
+            }
+            SDL_DestroyTexture(texture);
+
+            printf("%-6s  %4dx  %8.3f  %8.3f  %6.1fx  %7.1f%%  %8.3f  %7.0f%%  %s\n",
+                   rgb555 ? "rgb555" : "rgba32", scale, ms[0], ms[1], ms[0] / ms[1], uploaded, ms[2],
+                   (ms[2] / ms[0] - 1.0) * 100.0, same ? "yes" : "NO");
+            free(shadow);
+            for (i = 0; i < 4; i++) free(frames_buf[i]);
+            free(rt.pixels);
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(window);
+}
+
+
+/***************************************************************************
+ * Upscaling a 320x240 frame to a 1080p window in each mode, on one
+ * thread and split into bands across every core (thread start included).
+ */
+typedef struct UpscaleBand {
+    const Upscaler* up;
+    uint32* dst;
+    const uint32* src;
+    int32 top, bottom;
+} UpscaleBand;
+
+static int SDLCALL upscale_band(void* data)
+{
+    UpscaleBand* band = (UpscaleBand*)data;
+
+    upscale_rows(band->up, band->dst, band->up->width, band->src, band->up->src_width,
+                 band->top, band->bottom);
+    return 0;
+}
+
+static void upscale_threaded(UpscaleBand* bands, int nthreads)
+{
+    SDL_Thread* threads[MAX_UPSCALE_THREADS];
+    int i;
+
+    for (i = 1; i < nthreads; i++) {
+        threads[i] = SDL_CreateThread(upscale_band, "upscale", &bands[i]);
+    }
+    upscale_band(&bands[0]);
+    for (i = 1; i < nthreads; i++) {
+        if (threads[i]) SDL_WaitThread(threads[i], NULL);
+        else upscale_band(&bands[i]);
+    }
+}
+
+static void bench_upscale(int frames)
+{
+    static const char* names[] = { "", "integer", "sharp", "scanline" };
+    int nthreads = SDL_GetCPUCount();
+    RasterTarget rt;
+    int mode;
+
+    if (nthreads > MAX_UPSCALE_THREADS) nthreads = MAX_UPSCALE_THREADS;
+    if (nthreads < 1) nthreads = 1;
+    if (!init_target(&rt, 1)) return;
+    raster_draw_cels(&rt, g_scene.cels);
+
+    printf("%s, %d threads\n", upscale_cpu(), nthreads);
+    printf("mode      output      1 thread ms   %2d threads ms  checksum\n", nthreads);
+    for (mode = UPSCALE_INTEGER; mode <= UPSCALE_SCANLINE; mode++) {
+        Upscaler up;
+        UpscaleBand bands[MAX_UPSCALE_THREADS];
+        uint32* out;
+        uint32 sum;
+        double ms[2], t0;
+        int32 band;
+        int i;
+
+        memset(&up, 0, sizeof(up));
+        if (upscaler_setup(&up, mode, rt.width, rt.height, UPSCALE_WIDTH, UPSCALE_HEIGHT) < 0 ||
+            !(out = (uint32*)malloc((size_t)up.width * up.height * sizeof(uint32)))) {
+            printf("Out of memory\n");
+            upscaler_free(&up);
+            break;
+        }
+
+        upscale_rows(&up, out, up.width, rt.pixels, rt.width, 0, up.height);
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            upscale_rows(&up, out, up.width, rt.pixels, rt.width, 0, up.height);
+        }
+        ms[0] = (now_ms() - t0) / frames;
+        sum = checksum(out, (size_t)up.width * up.height);
+
+        band = (up.height + nthreads - 1) / nthreads;
+        for (i = 0; i < nthreads; i++) {
+            bands[i].up = &up;
+            bands[i].dst = out;
+            bands[i].src = rt.pixels;
+            bands[i].top = i * band;
+            bands[i].bottom = (i + 1) * band;
+        }
+        memset(out, 0, (size_t)up.width * up.height * sizeof(uint32));
+        t0 = now_ms();
+        for (i = 0; i < frames; i++) {
+            upscale_threaded(bands, nthreads);
+        }
+        ms[1] = (now_ms() - t0) / frames;
+
+        printf("%-8s  %4dx%-5d  %11.3f  %13.3f   %08X%s\n", names[mode], up.width, up.height,
+               ms[0], ms[1], sum,
+               checksum(out, (size_t)up.width * up.height) == sum ? "" : "  bands differ!");
+        free(out);
+        upscaler_free(&up);
+    }
+    free(rt.pixels);
+}
+
+
+/***************************************************************************
+ * Cel chains against packed draw lists, on the scene and on the crowd,
+ * drawn whole and drawn as LIST_BANDS bands one after another (what the
+ * band workers do between them).  The list's time includes packing the
+ * chain each frame, as DrawCels() does.
+ */
+static void draw_bands(RasterTarget* rt, const CCB* cels, const RasterDrawList* list, int bands)
+{
+    int height = rt->height, i;
+
+    for (i = 0; i < bands; i++) {
+        rt->clip_top = height * i / bands;
+        rt->clip_bottom = height * (i + 1) / bands;
+        if (list) raster_draw_list(rt, list);
+        else raster_draw_cels(rt, cels);
+    }
+    rt->clip_top = 0;
+    rt->clip_bottom = height;
+}
+
+static void bench_list(int frames)
+{
+    static const char* names[] = { "scene", "crowd" };
+    PlatformTexture tex;
+    RasterDrawList list;
+    RasterTarget rt;
+    CCB* crowd;
+    int set, bands, i;
+
+    if (!(crowd = (CCB*)calloc(NCROWD, sizeof(CCB)))) return;
+    make_crowd_texture(&tex);
+    build_crowd(crowd, &tex);
+    memset(&list, 0, sizeof(list));
+    if (!init_target(&rt, 2)) {
+        free(crowd);
+        free(tex.data);
+        return;
+    }
+
+    printf("cels   bands  chain ms   list ms   pack ms   checksum\n");
+    for (set = 0; set < 2; set++) {
+        const CCB* cels = set ? crowd : g_scene.cels;
+
+        for (bands = 1; bands <= LIST_BANDS; bands *= LIST_BANDS) {
+            size_t n = (size_t)rt.width * rt.height;
+            uint32 sum[2];
+            double ms[3], t0;
+
+            memset(rt.pixels, 0, n * sizeof(uint32));
+            draw_bands(&rt, cels, NULL, bands);
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                draw_bands(&rt, cels, NULL, bands);
+            }
+            ms[0] = (now_ms() - t0) / frames;
+            sum[0] = checksum(rt.pixels, n);
+
+            memset(rt.pixels, 0, n * sizeof(uint32));
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                raster_list_clear(&list);
+                if (raster_list_add_cels(&list, cels) < 0) {
+                    printf("Out of memory\n");
+                    goto done;
+                }
+                draw_bands(&rt, NULL, &list, bands);
+            }
+            ms[1] = (now_ms() - t0) / frames;
+            sum[1] = checksum(rt.pixels, n);
+
+            t0 = now_ms();
+            for (i = 0; i < frames; i++) {
+                raster_list_clear(&list);
+                raster_list_add_cels(&list, cels);
+            }
+            ms[2] = (now_ms() - t0) / frames;
+
+            printf("%-5s  %5d  %8.3f  %8.3f  %8.4f   %08X%s\n", names[set], bands, ms[0], ms[1],
+                   ms[2], sum[0], sum[1] == sum[0] ? "" : "  list differs!");
+        }
+    }
+
+done:
+    raster_list_free(&list);
+    free(rt.pixels);
+    free(crowd);
+    free(tex.data);
+}
+
+
+typedef struct BenchTest {
+    const char* name;
+    void (*run)(int frames);
+} BenchTest;
+
+static const BenchTest g_tests[] = {
+    { "scale", bench_scale },
+    { "walls", bench_walls },
+    { "sample", bench_sample },
+    { "mips", bench_mips },
+    { "rgb555", bench_rgb555 },
+    { "blend", bench_blend },
+    { "fade", bench_fade },
+    { "screenfade", bench_screenfade },
+    { "backwall", bench_backwall },
+    { "hud", bench_hud },
+    { "present", bench_present },
+    { "dirty", bench_dirty },
+    { "upscale", bench_upscale },
+    { "list", bench_list },
+};
+
+#define NTESTS ((int)(sizeof(g_tests) / sizeof(g_tests[0])))
+
+int main(int argc, char* argv[])
+{
+    const char* only = argc > 1 ? argv[1] : NULL;
+    int frames = argc > 2 ? atoi(argv[2]) : 200;
+    int i, ran = 0;
+
+    if (frames < 1) frames = 1;
+
+    if (SDL_Init(SDL_INIT_TIMER) < 0) {
+        printf("SDL initialization failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    build_scene(&g_scene);
+
+    for (i = 0; i < NTESTS; i++) {
+        if (only && strcmp(only, g_tests[i].name) != 0) continue;
+        printf("== %s (%d frames) ==\n", g_tests[i].name, frames);
+        g_tests[i].run(frames);
+        ran++;
+    }
+
+    if (!ran) {
+        printf("Unknown test '%s'.  Tests:", only);
+        for (i = 0; i < NTESTS; i++) printf(" %s", g_tests[i].name);
+        printf("\n");
+    }
+
+    SDL_Quit();
+    return ran ? 0 : 1;
+}
@@ -457,31 +457,31 @@ struct ShotInfo	*si;
 extern CelArray	*ca_gun, *ca_ray;
 extern CCB	*statpanel, *guncel;
 extern uint32	ccbextra;
-extern int32	cy;
+extern int32	cy, rendscale;
 extern int32	playerhealth;
 
 static int32	gunbasey;
 
+#define	NGUNYS		(sizeof (gunyoffs) / sizeof (int32))
+
+static int32	gunyoffs[] = {
+	0, 1, 3, 5, 6, 5
+};
+static int	gunidx;
+static int	gunframe;	/*  Which gun cel (by health).		*/
+
 
 
 void
 sequencegun (dist)
 frac16 dist;
 {
-#define	NGUNYS		(sizeof (gunyoffs) / sizeof (int32))
-
-	static int32	gunyoffs[] = {
-		0, 1, 3, 5, 6, 5
-	};
 	static Point	corner[4];
-	static int	gunidx;
 	register int32	gcx;
-	GrafCon		gc;
-	Rect		rect;
 
 
 	gcx = (playerhealth * (ca_gun->ncels - 1) + 50) / 100;
-	gcx = ca_gun->ncels - 1 - gcx;
+	gunframe = gcx = ca_gun->ncels - 1 - gcx;
 	guncel = ca_gun->celptrs[gcx];
 
 	gcx = (guncel->ccb_XPos >> 16) + (REALCELDIM (guncel->ccb_Width) >> 1);
@@ -495,26 +495,10 @@ frac16 dist;
 		disp = ConvertF16_32 (DivSF16 (QUARTER_F16 * MAGIC, dist));
 
 		corner[0].pt_X = gcx - disp;
-		corner[0].pt_Y = cy + (disp >> 1);
+		corner[0].pt_Y = cy / rendscale + (disp >> 1);
 
 		corner[1].pt_X = gcx + disp;
-		corner[1].pt_Y = cy + (disp >> 1);
-	}
-	else if (gunpower) {
-		register int32	x, y;
-
-		x = guncel->ccb_XPos >> 16;
-		y = gunbasey - gunyoffs[gunidx];
-
-		rect.rect_XLeft	= x + BARGRAPH_X;
-		rect.rect_YTop	= y + BARGRAPH_Y;
-		rect.rect_XRight	= rect.rect_XLeft +
-					  (gunpower * (BARGRAPH_WIDE - 1) +
-					   50) / 100;
-		rect.rect_YBottom	= rect.rect_YTop + 1;
-
-		SetFGPen (&gc, MakeRGB15 (20, 5, 5));
-		FillRect (rprend->rp_BitmapItem, &gc, &rect);
+		corner[1].pt_Y = cy / rendscale + (disp >> 1);
 	}
 
 	if (gunidx) {
@@ -537,6 +521,51 @@ frac16 dist;
 	guncel->ccb_YPos = (gunbasey - gunyoffs[gunidx]) << 16;
 }
 
+/*
+ * The gun and the power bar on it are drawn into a layer that's kept from
+ * frame to frame, and only when one of them has changed; most frames just
+ * lay the kept layer over the world.  The key below has to cover
+ * everything drawn into it.  The ray moves with every shot and blends
+ * with what's behind it, so it's drawn straight onto the screen after.
+ */
+void
+drawhud ()
+{
+	register int32	x, y;
+	register uint32	last;
+	Item		hud;
+	GrafCon		gc;
+	Rect		rect;
+
+	last = guncel->ccb_Flags & CCB_LAST;
+	hud = platform_hud_begin (rprend->rp_BitmapItem,
+				  gunframe | (gunidx << 8) | (gunpower << 12));
+	if (hud) {
+		guncel->ccb_Flags |= CCB_LAST;
+		DrawCels (hud, guncel);
+		guncel->ccb_Flags = (guncel->ccb_Flags & ~CCB_LAST) | last;
+
+		if (gunpower) {
+			x = guncel->ccb_XPos >> 16;
+			y = gunbasey - gunyoffs[gunidx];
+
+			rect.rect_XLeft	= x + BARGRAPH_X;
+			rect.rect_YTop	= y + BARGRAPH_Y;
+			rect.rect_XRight	= rect.rect_XLeft +
+						  (gunpower * (BARGRAPH_WIDE - 1) +
+						   50) / 100;
+			rect.rect_YBottom	= rect.rect_YTop + 1;
+
+			SetFGPen (&gc, MakeRGB15 (20, 5, 5));
+			FillRect (hud, &gc, &rect);
+		}
+	}
+	platform_hud_composite (rprend->rp_BitmapItem);
+
+	if (!last)
+		DrawCels (rprend->rp_BitmapItem, guncel->ccb_NextPtr);
+}
+
 void
 loadgun ()
 {
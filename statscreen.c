@@ -173,11 +173,13 @@ openmmfont(void)
 	FontInit (40);	// init font to allow max of 40 chars/line
 	if (!(TestText.FontPtr = allocloadfile ("$progdir/mm.font", MEMTYPE_CEL, &fontbufsize)))
 		die ("Couldn't load font.\n");
+	buildfontatlas (&TestText);
 }
 
 void
 closemmfont(void)
 {
+	freefontatlas (TestText.FontPtr);
 	FontFree();
 	FreeMem(TestText.FontPtr,fontbufsize);
 }
@@ -452,7 +454,7 @@ int	dosound;
 			TestText.CoordX = stattext[i].x;
 			TestText.CoordY = stattext[i].y;
 			TestText.PLUTPtr = stattext[i].plut;
-			FontPrint(&TestText);
+			printtext(&TestText);
 		}
 
 		for (i=0; (statvals[i].x); i++) {
@@ -463,7 +465,7 @@ int	dosound;
 				TestText.CoordX = statvals[i].x;
 			TestText.CoordY = statvals[i].y;
 			TestText.PLUTPtr = statvals[i].plut;
-			FontPrint(&TestText);
+			printtext(&TestText);
 		}
 
 		for (i=0; (staticons[i].x); i++) {
@@ -770,7 +772,7 @@ extern int8 gottalisman;
 			TestText.TextPtr = stattext[i].str;
 			TestText.CoordX = stattext[i].x;
 			TestText.CoordY = stattext[i].y;
-			FontPrint(&TestText);
+			printtext(&TestText);
 		}
 
 		TestText.PLUTPtr = LtBluePLUT;
@@ -783,7 +785,7 @@ extern int8 gottalisman;
 				TestText.CoordX = statvals[i].x;
 //			TestText.CoordX = statvals[i].x;
 			TestText.CoordY = statvals[i].y;
-			FontPrint(&TestText);
+			printtext(&TestText);
 		}
 
 		for (i=0; (staticons[i].x); i++) {
@@ -991,7 +993,7 @@ static char	*quit_restart[] = {"  Replay Intro",  "   Quit Game"};
 				TestText.TextPtr = stattext[i].str;
 				TestText.CoordX = stattext[i].x;
 				TestText.CoordY = stattext[i].y;
-				FontPrint(&TestText);
+				printtext(&TestText);
 			}
 		}
 
@@ -1299,7 +1301,7 @@ static char	blankstr[] = {"                    "};
 				TestText.CoordX = (320-7*strlen(credits[i].str))>>1;
 				TestText.CoordY = y;
 				TestText.PLUTPtr = credits[i].plut;
-				FontPrint(&TestText);
+				printtext(&TestText);
 			}
 		}
 
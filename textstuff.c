@@ -10,6 +10,7 @@
 #include <mem.h>
 #include <operamath.h>
 #include <graphics.h>
+#include <string.h>
 
 #include "castle.h"
 #include "objects.h"
@@ -17,6 +18,7 @@
 
 #include "loaf.h"
 #include "textstuff.h"
+#include "font.h"
 
 #include "app_proto.h"
 
@@ -37,6 +39,427 @@ static int32	FontPLUT[] = {
 	0x00000fff, 0x00000000, 0x00000000, 0x00000000,
 };
 
+
+/***************************************************************************
+ * Glyph atlases and text runs.
+ *
+ * Drawing a string a character cel at a time costs the cel engine a CCB
+ * fetch and setup for every glyph, every frame, and the stat and option
+ * screens redraw the same few dozen strings every frame.  So when a font
+ * is loaded, each of its glyphs is drawn once and read back into an
+ * atlas of PLUT indices, along with how far the font advances past it.
+ * A string is then laid out by copying its glyphs out of the atlas into
+ * a single 8-bit coded cel (a "run"), which draws in one go with whatever
+ * PLUT the caller likes.  Runs are kept by content, so a string that
+ * doesn't change is only ever laid out once.
+ */
+#define	ATLASFIRST	' '
+#define	ATLASLAST	'~'
+#define	ATLASCHARS	(ATLASLAST - ATLASFIRST + 1)
+#define	ATLASCELL	16		// Widest and tallest glyph kept
+#define	ATLASPITCH	(ATLASCHARS * ATLASCELL)
+#define	ATLASREF	'I'		// Glyph advances are measured against this
+
+#define	MAXRUNCHARS	40		// Same as FontInit() is given
+#define	NTEXTRUNS	48
+
+typedef struct FontAtlas {
+	struct FontAtlas	*fa_Next;
+	void			*fa_Font;
+	int32			fa_Height;	// Rows of glyph data
+	ubyte			*fa_Pixels;	// PLUT indices, 0 = clear
+	ubyte			fa_Width[ATLASCHARS];
+	ubyte			fa_Advance[ATLASCHARS];
+} FontAtlas;
+
+typedef struct TextRun {
+	FontAtlas	*tr_Atlas;
+	uint32		tr_Hash;
+	uint32		tr_LastUse;
+	int32		tr_Width;	// Advance past the run
+	int32		tr_BufSize;
+	ubyte		*tr_Buf;
+	CCB		tr_CCB;
+	char		tr_Str[MAXRUNCHARS + 1];
+} TextRun;
+
+static FontAtlas	*atlases;
+static TextRun		textruns[NTEXTRUNS];
+static uint32		runclock;
+
+/*
+ * Glyphs are drawn through this PLUT when building an atlas, so every
+ * pixel that lands in the frame buffer is its own PLUT index.
+ */
+static int32	IndexPLUT[] = {
+	0x00000001, 0x00020003, 0x00040005, 0x00060007,
+	0x00080009, 0x000a000b, 0x000c000d, 0x000e000f,
+};
+
+
+static FontAtlas *
+findatlas (font)
+void	*font;
+{
+	register FontAtlas	*fa;
+
+	for (fa = atlases;  fa;  fa = fa->fa_Next)
+		if (fa->fa_Font == font)
+			return (fa);
+	return (NULL);
+}
+
+/*
+ * Fetch a pixel out of the frame buffer, which keeps pairs of lines
+ * interleaved a pixel at a time.
+ */
+static int32
+framepixel (bm, x, y)
+Bitmap	*bm;
+int32	x, y;
+{
+	register uint16	*pix;
+
+	pix = (uint16 *) bm->bm_Buffer +
+	      (((y >> 1) * bm->bm_Width + x) << 1) + (y & 1);
+	return (*pix & 0x7FFF);
+}
+
+/*
+ * Leftmost column with anything in it in the band of ATLASCELL lines
+ * starting at top, or -1.
+ */
+static int32
+inkleft (bm, top)
+Bitmap	*bm;
+int32	top;
+{
+	register int32	x, y;
+
+	for (x = 0;  x < bm->bm_Width;  x++)
+		for (y = top;  y < top + ATLASCELL;  y++)
+			if (framepixel (bm, x, y))
+				return (x);
+	return (-1);
+}
+
+/*
+ * Build an atlas for a font.  print() draws a string with the font at a
+ * position in rprend, through IndexPLUT.  Every glyph is drawn alone on
+ * the first band of the screen, and again followed by ATLASREF on the
+ * second; where the two first differ is where ATLASREF landed, which
+ * gives the advance without knowing anything about the font's format.
+ * rprend is cleared when we're done.
+ */
+static void
+buildatlas (font, print)
+void	*font;
+void	(*print)();
+{
+	register FontAtlas	*fa;
+	register ubyte		*dest;
+	register int32		x, y;
+	Bitmap			*bm;
+	int32			c, w, refleft;
+	char			str[3];
+
+	if (!(fa = malloctype (sizeof (FontAtlas), MEMTYPE_FILL)))
+		die ("Can't allocate font atlas.\n");
+	if (!(fa->fa_Pixels = malloctype (ATLASCELL * ATLASPITCH,
+					  MEMTYPE_FILL)))
+		die ("Can't allocate font atlas.\n");
+	fa->fa_Font = font;
+
+	bm = rprend->rp_Bitmap;
+	str[0] = ATLASREF;
+	str[1] = '\0';
+	SetRast (rprend, 0);
+	(*print) (font, str, 0, 0);
+	refleft = inkleft (bm, 0);
+
+	for (c = ATLASFIRST;  c <= ATLASLAST;  c++) {
+		SetRast (rprend, 0);
+		str[0] = c;
+		str[1] = '\0';
+		(*print) (font, str, 0, 0);
+		str[1] = ATLASREF;
+		str[2] = '\0';
+		(*print) (font, str, 0, ATLASCELL);
+
+		dest = fa->fa_Pixels + (c - ATLASFIRST) * ATLASCELL;
+		w = 0;
+		for (y = 0;  y < ATLASCELL;  y++)
+			for (x = 0;  x < ATLASCELL;  x++)
+				if ((dest[y * ATLASPITCH + x] =
+				     framepixel (bm, x, y)))
+				{
+					if (x >= w)
+						w = x + 1;
+					if (y >= fa->fa_Height)
+						fa->fa_Height = y + 1;
+				}
+		fa->fa_Width[c - ATLASFIRST] = w;
+
+		for (x = 0;  x < bm->bm_Width;  x++) {
+			for (y = 0;  y < ATLASCELL;  y++)
+				if (framepixel (bm, x, y) !=
+				    framepixel (bm, x, y + ATLASCELL))
+					break;
+			if (y < ATLASCELL)
+				break;
+		}
+		if (refleft >= 0  &&  x < bm->bm_Width  &&  x >= refleft)
+			fa->fa_Advance[c - ATLASFIRST] = x - refleft;
+		else
+			fa->fa_Advance[c - ATLASFIRST] = w + 1;
+	}
+	SetRast (rprend, 0);
+	if (!fa->fa_Height)
+		fa->fa_Height = 1;
+
+	fa->fa_Next = atlases;
+	atlases = fa;
+}
+
+/*
+ * Hand back a run of the first len (no more than MAXRUNCHARS) characters
+ * of str, laying it out if it isn't cached.  The least recently used run
+ * is thrown out to make room.
+ */
+static TextRun *
+gettextrun (fa, str, len)
+FontAtlas	*fa;
+char		*str;
+int32		len;
+{
+	register TextRun	*tr, *old;
+	register ubyte		*src, *dest;
+	register int32		x, y;
+	int32			c, i, n, wide, rowbytes, size;
+	uint32			hash;
+
+	for (hash = len, i = 0;  i < len;  i++)
+		hash = hash * 33 + (ubyte) str[i];
+
+	old = textruns;
+	for (tr = textruns;  tr < textruns + NTEXTRUNS;  tr++) {
+		if (tr->tr_Atlas == fa  &&  tr->tr_Hash == hash  &&
+		    !strncmp (tr->tr_Str, str, len)  &&  !tr->tr_Str[len])
+		{
+			tr->tr_LastUse = ++runclock;
+			return (tr);
+		}
+		if (tr->tr_LastUse < old->tr_LastUse)
+			old = tr;
+	}
+	tr = old;
+
+	/*
+	 * Size it up.  Rows of a cel are a whole number of words, and no
+	 * less than two.
+	 */
+	for (wide = x = i = 0;  i < len;  i++) {
+		c = (ubyte) str[i];
+		if (c < ATLASFIRST  ||  c > ATLASLAST)
+			continue;
+		if (x + fa->fa_Width[c - ATLASFIRST] > wide)
+			wide = x + fa->fa_Width[c - ATLASFIRST];
+		x += fa->fa_Advance[c - ATLASFIRST];
+	}
+	tr->tr_Width = x;
+	if (!wide)
+		wide = 1;
+	rowbytes = (wide + 3) & ~3;
+	if (rowbytes < 8)
+		rowbytes = 8;
+	size = rowbytes * fa->fa_Height;
+
+	if (size > tr->tr_BufSize) {
+		if (tr->tr_Buf)
+			freetype (tr->tr_Buf);
+		if (!(tr->tr_Buf = malloctype (size, MEMTYPE_CEL)))
+			die ("Can't allocate text run.\n");
+		tr->tr_BufSize = size;
+	}
+	memset (tr->tr_Buf, 0, size);
+
+	for (x = i = 0;  i < len;  i++) {
+		c = (ubyte) str[i];
+		if (c < ATLASFIRST  ||  c > ATLASLAST)
+			continue;
+		c -= ATLASFIRST;
+		for (y = 0;  y < fa->fa_Height;  y++) {
+			src = fa->fa_Pixels + y * ATLASPITCH + c * ATLASCELL;
+			dest = tr->tr_Buf + y * rowbytes + x;
+			for (n = fa->fa_Width[c];  --n >= 0;  src++, dest++)
+				if (*src)
+					*dest = *src;
+		}
+		x += fa->fa_Advance[c];
+	}
+
+	tr->tr_CCB.ccb_Flags	= CCB_NPABS | CCB_SPABS | CCB_PPABS |
+				  CCB_LDSIZE | CCB_LDPRS | CCB_LDPPMP |
+				  CCB_LDPLUT | CCB_CCBPRE | CCB_YOXY |
+				  CCB_ACW | CCB_ACCW | ccbextra | CCB_LAST;
+	tr->tr_CCB.ccb_NextPtr	= NULL;
+	tr->tr_CCB.ccb_SourcePtr = (CelData *) tr->tr_Buf;
+	tr->tr_CCB.ccb_PIXC	= 0x1F001F00;
+	tr->tr_CCB.ccb_PRE0	= PRE0_LITERAL | PRE0_BPP_8 |
+				  ((fa->fa_Height - PRE0_VCNT_PREFETCH) <<
+				   PRE0_VCNT_SHIFT);
+	tr->tr_CCB.ccb_PRE1	= (((rowbytes >> 2) - PRE1_WOFFSET_PREFETCH) <<
+				   PRE1_WOFFSET8_SHIFT) |
+				  PRE1_TLLSB_PDC0 |
+				  (wide - PRE1_TLHPCNT_PREFETCH);
+	tr->tr_CCB.ccb_Width	= wide;
+	tr->tr_CCB.ccb_Height	= fa->fa_Height;
+	tr->tr_CCB.ccb_HDX	= ONE_HD;
+	tr->tr_CCB.ccb_VDY	= ONE_VD;
+	tr->tr_CCB.ccb_HDY	=
+	tr->tr_CCB.ccb_VDX	=
+	tr->tr_CCB.ccb_HDDX	=
+	tr->tr_CCB.ccb_HDDY	= 0;
+
+	tr->tr_Atlas = fa;
+	tr->tr_Hash = hash;
+	tr->tr_LastUse = ++runclock;
+	strncpy (tr->tr_Str, str, len);
+	tr->tr_Str[len] = '\0';
+
+	return (tr);
+}
+
+/*
+ * Draw str a line at a time, starting at *x, *y.  A line is a run, or
+ * several laid end to end if it's longer than a run holds.  Lines break
+ * at CR or LF and are lf apart.  On return, *x and *y are where the next
+ * character would go.
+ */
+static void
+drawruns (fa, bitmap, str, x, y, lf, plut)
+FontAtlas	*fa;
+Item		bitmap;
+char		*str;
+int32		*x, *y, lf;
+void		*plut;
+{
+	register TextRun	*tr;
+	register int32		len, i, n;
+	int32			left;
+
+	left = *x;
+	for (;;) {
+		for (len = 0;  str[len]  &&  str[len] != '\n'  &&
+			       str[len] != '\r';  len++)
+			;
+		for (i = 0;  i < len;  i += n) {
+			n = len - i > MAXRUNCHARS ? MAXRUNCHARS : len - i;
+			tr = gettextrun (fa, str + i, n);
+			tr->tr_CCB.ccb_XPos = *x << 16;
+			tr->tr_CCB.ccb_YPos = *y << 16;
+			tr->tr_CCB.ccb_PLUTPtr = plut;
+			DrawCels (bitmap, &tr->tr_CCB);
+			*x += tr->tr_Width;
+		}
+		if (!str[len])
+			break;
+		str += len + 1;
+		*x = left;
+		*y += lf;
+	}
+}
+
+static void
+fontstructprint (font, str, x, y)
+void	*font;
+char	*str;
+int32	x, y;
+{
+	FontStruct	fs;
+
+	fs.TextPtr = str;
+	fs.FontPtr = font;
+	fs.CoordX = x;
+	fs.CoordY = y;
+	fs.LineFeedOffset = 0;
+	fs.BItem = rprend->rp_BitmapItem;
+	fs.PLUTPtr = IndexPLUT;
+	FontPrint (&fs);
+}
+
+static void
+fontdefprint (font, str, x, y)
+void	*font;
+char	*str;
+int32	x, y;
+{
+	fontcel->ccb_PLUTPtr = IndexPLUT;
+	MyMoveTo ((FontDef *) font, x, y);
+	MyDrawText ((FontDef *) font, str);
+	fontcel->ccb_PLUTPtr = FontPLUT;
+}
+
+/*
+ * Build the atlas for a font FontPrint() draws.  Only the FontStruct's
+ * FontPtr matters; any FontStruct with the same font will use it.
+ */
+void
+buildfontatlas (fs)
+FontStruct	*fs;
+{
+	if (!findatlas (fs->FontPtr))
+		buildatlas (fs->FontPtr, fontstructprint);
+}
+
+/*
+ * Throw out a font's atlas, and any runs laid out from it.
+ */
+void
+freefontatlas (font)
+void	*font;
+{
+	register FontAtlas	*fa, **prev;
+	register TextRun	*tr;
+
+	for (prev = &atlases;  fa = *prev;  prev = &fa->fa_Next)
+		if (fa->fa_Font == font)
+			break;
+	if (!fa)
+		return;
+	*prev = fa->fa_Next;
+
+	for (tr = textruns;  tr < textruns + NTEXTRUNS;  tr++)
+		if (tr->tr_Atlas == fa) {
+			tr->tr_Atlas = NULL;
+			tr->tr_LastUse = 0;
+		}
+
+	freetype (fa->fa_Pixels);
+	freetype (fa);
+}
+
+/*
+ * Stand-in for FontPrint().  Draws from the font's atlas if it has one,
+ * otherwise hands off to FontPrint().
+ */
+void
+printtext (fs)
+FontStruct	*fs;
+{
+	FontAtlas	*fa;
+	int32		x, y;
+
+	if (!(fa = findatlas (fs->FontPtr))) {
+		FontPrint (fs);
+		return;
+	}
+	x = fs->CoordX;
+	y = fs->CoordY;
+	drawruns (fa, fs->BItem, fs->TextPtr, &x, &y,
+		  fs->LineFeedOffset, fs->PLUTPtr);
+}
+
 FontDef *
 LoadFont(filename)
 char *filename;
@@ -62,6 +485,7 @@ char	*buffer;
 		 		die ("Couldn't load font file.\n");
 	
  kprintf("Font loaded\n");
+	buildatlas (buffer, fontdefprint);
 	return((FontDef*)buffer);
 }
 
@@ -84,6 +508,13 @@ int32	i,initialx;
 char	c;
 int32	*ptr;
 static Point	corner[4];
+FontAtlas	*fa;
+
+	if (fa = findatlas (fontdef)) {
+		drawruns (fa, rprend->rp_BitmapItem, str,
+			  &fontdef->x, &fontdef->y, 10, FontPLUT);
+		return;
+	}
 
 	initialx = fontdef->x;
 
@@ -122,3 +553,4 @@ static Point	corner[4];
 	}
 }
 
+
@@ -50,6 +50,15 @@
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #endif
 
+// The 3DO build (THREEDO_BUILD, set by the Makefile) has none of the SDL
+// port's platform layer.  What the game sources call of it stands in as
+// the direct 3DO equivalent: the HUD is drawn straight onto the screen
+// every frame, with no retained layer to lay over it.
+#ifdef THREEDO_BUILD
+#define platform_hud_begin(bitmap_item, key)    (bitmap_item)
+#define platform_hud_composite(bitmap_item)     ((void)(bitmap_item))
+#endif
+
 // Function that the original code expects to exist
 extern void die(const char* message);
 extern void kprintf(const char* format, ...);
@@ -95,6 +104,8 @@ void drawnumxy(Item bitmap, int32 number, int32 x, int32 y);
 // Memory management compatibility
 void* FreeMemToMemLists(void* ptr);
 void* AllocMemFromMemLists(int32 size, uint32 flags);
+void* malloctype(int32 size, uint32 memtype);
+void freetype(void* ptr);
 
 // File system compatibility
 int InitFileFolioGlue(void);
@@ -200,6 +211,13 @@ void extract_east(ExtDat* ed);
 void processgrid(void);
 void processvisobs(void);
 void rendercels(void);
+struct LineBuf;
+int initlinebuf(struct LineBuf* lb, int32 width);
+void freelinebuf(struct LineBuf* lb);
+void resetlinebuf(struct LineBuf* lb);
+int islinefull(struct LineBuf* lb);
+int testlinebuf(struct LineBuf* lb, int32 lx, int32 rx);
+int testmarklinebuf(struct LineBuf* lb, int32 lx, int32 rx);
 void platform_wait_vbl(int frames);
 void platform_clear_screen(void);
 
@@ -237,6 +255,8 @@ void copyverts(Vertex* dest, Vertex* src, int32 count);
 void translatemany(Vector* offset, Vertex* verts, int32 count);
 void extractcels(frac16 x, frac16 y, frac16 z);
 void closelevelstuff(void);
+void setrendscale(int32 n);
+void setdrawdist(frac16 dist);
 void MulManyVec3Mat33_F16(void* result, void* vectors, void* matrix, int32 count);
 
 // Platform function declarations